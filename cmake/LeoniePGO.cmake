@@ -0,0 +1,64 @@
+#
+#  LeoniePGO.cmake
+#  Leonie
+#
+#  Run by the leonie-pgo target (see CMakeLists.txt) as "cmake -P". Builds
+#  an instrumented Leonie, trains it with the benchmark workloads, builds an
+#  optimized Leonie from the profiles and compares its benchmarks to those
+#  of the non-PGO build that invoked us.
+#
+
+set( PGO_DIR "${LEONIE_BINARY_DIR}/pgo-profiles" )
+set( GENERATE_DIR "${LEONIE_BINARY_DIR}/pgo-generate" )
+set( USE_DIR "${LEONIE_BINARY_DIR}/pgo-use" )
+set( BASELINE_FILE "${LEONIE_BINARY_DIR}/pgo-baseline.txt" )
+
+if( NOT LEONIE_CURRENT_PGO STREQUAL "OFF" )
+	message( WARNING "This build has LEONIE_PGO=${LEONIE_CURRENT_PGO}, so the speedup below isn't relative to a non-PGO build." )
+endif()
+if( LEONIE_C_COMPILER_ID MATCHES "Clang" AND NOT LEONIE_LLVM_PROFDATA )
+	message( FATAL_ERROR "Clang PGO builds need llvm-profdata to merge the profiles, but it wasn't found." )
+endif()
+
+
+function( leonie_pgo_run )
+	execute_process( COMMAND ${ARGN} RESULT_VARIABLE result )
+	if( NOT result EQUAL 0 )
+		string( REPLACE ";" " " commandLine "${ARGN}" )
+		message( FATAL_ERROR "Failed (${result}): ${commandLine}" )
+	endif()
+endfunction()
+
+
+function( leonie_pgo_build inDir inMode )
+	leonie_pgo_run( ${CMAKE_COMMAND} -S ${LEONIE_SOURCE_DIR} -B ${inDir}
+					-DCMAKE_C_COMPILER=${LEONIE_C_COMPILER}
+					-DCMAKE_BUILD_TYPE=${LEONIE_BUILD_TYPE}
+					-DLEONIE_LTO=${LEONIE_LTO}
+					-DLEONIE_NATIVE=${LEONIE_NATIVE}
+					-DLEONIE_PGO=${inMode}
+					-DLEONIE_PGO_DIR=${PGO_DIR} )
+	leonie_pgo_run( ${CMAKE_COMMAND} --build ${inDir} --target leonie-benchmarks --clean-first )
+endfunction()
+
+
+message( STATUS "PGO: Building instrumented Leonie in ${GENERATE_DIR}" )
+file( REMOVE_RECURSE ${PGO_DIR} )
+file( MAKE_DIRECTORY ${PGO_DIR} )
+leonie_pgo_build( ${GENERATE_DIR} GENERATE )
+
+message( STATUS "PGO: Training" )
+leonie_pgo_run( ${GENERATE_DIR}/leonie-benchmarks )
+if( LEONIE_C_COMPILER_ID MATCHES "Clang" )
+	file( GLOB rawProfiles ${PGO_DIR}/*.profraw )
+	leonie_pgo_run( ${LEONIE_LLVM_PROFDATA} merge -output=${PGO_DIR}/leonie.profdata ${rawProfiles} )
+endif()
+
+message( STATUS "PGO: Building optimized Leonie in ${USE_DIR}" )
+leonie_pgo_build( ${USE_DIR} USE )
+
+message( STATUS "PGO: Benchmarking without PGO" )
+leonie_pgo_run( ${LEONIE_BASELINE_BENCHMARKS} --save ${BASELINE_FILE} )
+
+message( STATUS "PGO: Benchmarking with PGO, relative to the run without" )
+leonie_pgo_run( ${USE_DIR}/leonie-benchmarks --baseline ${BASELINE_FILE} )
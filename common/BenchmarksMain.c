@@ -0,0 +1,881 @@
+/*
+ *  BenchmarksMain.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*
+	Runs a fixed set of workloads and reports the time and the number of
+	allocations per operation for each of them.
+
+	Usage: benchmarks [--save <file>] [--baseline <file>] [<name filter>]
+
+	--save writes the results to the given file, --baseline compares them to
+	a file written earlier using --save. Since timings are noisy, only more
+	allocations than in the baseline make us exit with an error, slowdowns
+	are just flagged in the output. When comparing to a baseline, we also
+	report the speedup over all benchmarks, e.g. of a PGO build over a
+	non-PGO build (see the leonie-pgo target in CMakeLists.txt).
+*/
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOInterpreter.h"
+#include "LEOContextGroup.h"
+#include "LEOScript.h"
+#include "LEOInstructions.h"
+#include "LEOSlabAllocator.h"
+#include "LEOVerifier.h"
+#include "LEONumberConversion.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+#define NUM_ARITHMETIC_BENCHMARK_ITERATIONS		1000000
+#define RECURSION_BENCHMARK_DEPTH				100
+#define NUM_RECURSION_BENCHMARK_RUNS			10000
+#define NUM_CHUNK_BENCHMARK_ITEMS				2000
+#define NUM_ARRAY_BENCHMARK_ENTRIES				100000
+#define NUM_REFERENCE_BENCHMARK_ITERATIONS		100000
+#define NUM_CHUNK_REFERENCE_BENCHMARK_READS	10000
+#define NUM_CONCATENATION_BENCHMARK_ITERATIONS	5000
+#define NUM_ASSIGNMENT_BENCHMARK_ITERATIONS		1000000
+#define NUM_KEYED_WRITE_BENCHMARK_KEYS			2000
+#define NUM_SPLIT_BENCHMARK_LINES				100000
+#define NUM_NUMBER_BENCHMARK_VALUES				200000
+#define NUM_STACK_BENCHMARK_RUNS				100000
+#define STACK_BENCHMARK_DEPTH					32
+
+#define LEO_BENCHMARK_REPETITIONS				5		// We report the fastest run.
+#define LEO_BENCHMARK_SLOWDOWN_THRESHOLD		1.10	// Flag benchmarks more than 10% slower than the baseline.
+#define LEO_BENCHMARK_MAX_BASELINE_ENTRIES		64
+
+
+// -----------------------------------------------------------------------------
+//	Types:
+// -----------------------------------------------------------------------------
+
+/*! The measurements of one run of a benchmark.
+	@field	startTime			When LEOBenchmarkStart() was called.
+	@field	elapsedTime			Nanoseconds between LEOBenchmarkStart() and LEOBenchmarkStop().
+	@field	startStatistics		The group's statistics when LEOBenchmarkStart() was called.
+	@field	numAllocations		String buffers, array entries and references allocated between start and stop.
+*/
+typedef struct LEOBenchmarkRun
+{
+	double			startTime;
+	double			elapsedTime;
+	LEOStatistics	startStatistics;
+	size_t			numAllocations;
+} LEOBenchmarkRun;
+
+
+/*! A benchmark sets up its workload, measures the interesting part by
+	bracketing it with LEOBenchmarkStart() and LEOBenchmarkStop() and returns
+	the number of operations it performed in that time. */
+typedef size_t (*LEOBenchmarkFuncPtr)( LEOContext* inContext, LEOBenchmarkRun* ioRun );
+
+
+/*! An entry in our list of benchmarks.
+	@field	name		Name to report the results under, also used to find it in the baseline.
+	@field	func		The function that runs the benchmark.
+	@field	useSlabs	FALSE to run it without the context group's array entry allocator.
+	@field	verify		TRUE to verify the benchmark's handlers, so they run without per-instruction checks.
+*/
+typedef struct LEOBenchmark
+{
+	const char*				name;
+	LEOBenchmarkFuncPtr		func;
+	bool					useSlabs;
+	bool					verify;
+} LEOBenchmark;
+
+
+/*! One result read from a baseline file. */
+typedef struct LEOBenchmarkResult
+{
+	char		name[64];
+	double		nsPerOp;
+	double		allocationsPerOp;
+} LEOBenchmarkResult;
+
+
+// -----------------------------------------------------------------------------
+//	Globals:
+// -----------------------------------------------------------------------------
+
+static bool		sVerifyHandlers = false;	// LEOBenchmark.verify of the benchmark that is running.
+
+
+// -----------------------------------------------------------------------------
+//	Helpers:
+// -----------------------------------------------------------------------------
+
+static double	LEOBenchmarkNow( void )
+{
+	struct timespec		now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (now.tv_sec * 1000000000.0) +now.tv_nsec;
+}
+
+
+static size_t	LEOBenchmarkCountAllocations( LEOStatistics* inStatistics )
+{
+	return inStatistics->numStringsAllocated +inStatistics->numArrayEntriesAllocated +inStatistics->numReferencesCreated;
+}
+
+
+static void	LEOBenchmarkStart( LEOBenchmarkRun* ioRun, LEOContext* inContext )
+{
+	LEOContextGroupGetStatistics( inContext->group, &ioRun->startStatistics );
+	ioRun->startTime = LEOBenchmarkNow();
+}
+
+
+static void	LEOBenchmarkStop( LEOBenchmarkRun* ioRun, LEOContext* inContext )
+{
+	LEOStatistics	endStatistics;
+
+	ioRun->elapsedTime = LEOBenchmarkNow() -ioRun->startTime;
+	LEOContextGroupGetStatistics( inContext->group, &endStatistics );
+	ioRun->numAllocations = LEOBenchmarkCountAllocations( &endStatistics ) -LEOBenchmarkCountAllocations( &ioRun->startStatistics );
+}
+
+
+// Run a handler like the host would, with a fresh call stack:
+static void	LEOBenchmarkRunHandler( LEOContext* inContext, LEOScript* inScript, LEOHandlerID inHandlerID )
+{
+	LEOHandler*	theHandler = LEOScriptFindCommandHandlerWithID( inScript, inHandlerID );
+	if( sVerifyHandlers && !theHandler->verified )
+	{
+		char	errMsg[1024] = { 0 };
+		if( !LEOVerifyScript( inScript, errMsg, sizeof(errMsg) ) )
+			fprintf( stderr, "warning: Couldn't verify benchmark script: %s\n", errMsg );
+	}
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( inContext, theHandler, inScript, NULL, NULL );
+	LEORunInContext( theHandler->instructions, inContext );
+}
+
+
+// Keys for the array benchmarks, scrambled a little so the tree doesn't degenerate into a list:
+static void	LEOBenchmarkArrayKey( char* outKey, size_t inKeySize, size_t inIndex )
+{
+	snprintf( outKey, inKeySize, "k%zu", (inIndex * 7919) % NUM_ARRAY_BENCHMARK_ENTRIES );
+}
+
+
+static void	LEOBenchmarkBuildArray( struct LEOArrayEntry** outArray, LEOContext* inContext )
+{
+	union LEOValue	theValue;
+	char			key[32];
+
+	LEOInitIntegerValue( &theValue, 0, kLEOInvalidateReferences, inContext );
+	for( size_t x = 0; x < NUM_ARRAY_BENCHMARK_ENTRIES; x++ )
+	{
+		LEOBenchmarkArrayKey( key, sizeof(key), x );
+		LEOAddArrayEntryToRoot( outArray, key, &theValue, inContext );
+	}
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, inContext );
+}
+
+
+#pragma mark -
+// -----------------------------------------------------------------------------
+//	Benchmarks:
+// -----------------------------------------------------------------------------
+
+static size_t	DoArithmeticLoopBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	LEOScript*		theScript = LEOScriptCreateForOwner( 0, 0, NULL );
+	LEOHandlerID	mainID = LEOContextGroupHandlerIDForHandlerName( inContext->group, "main" );
+	LEOHandler*		mainHandler = LEOScriptAddCommandHandlerWithID( theScript, mainID );
+
+	LEOHandlerAddInstruction( mainHandler, PUSH_INTEGER_INSTR, 0, NUM_ARITHMETIC_BENCHMARK_ITERATIONS );	// bp+0: counter.
+	LEOHandlerAddInstruction( mainHandler, PUSH_INTEGER_INSTR, 0, 0 );	// bp+1: sum.
+	LEOHandlerAddInstruction( mainHandler, ADD_INTEGER_INSTR, 1, 3 );
+	LEOHandlerAddInstruction( mainHandler, ADD_INTEGER_INSTR, 0, (uint32_t) -1 );
+	LEOHandlerAddInstruction( mainHandler, JUMP_RELATIVE_IF_GT_ZERO_INSTR, 0, (uint32_t) -2 );
+	LEOHandlerAddInstruction( mainHandler, POP_VALUE_INSTR, BACK_OF_STACK, 0 );
+	LEOHandlerAddInstruction( mainHandler, POP_VALUE_INSTR, BACK_OF_STACK, 0 );
+	LEOHandlerAddInstruction( mainHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+
+	LEOBenchmarkStart( ioRun, inContext );
+	LEOBenchmarkRunHandler( inContext, theScript, mainID );
+	LEOBenchmarkStop( ioRun, inContext );
+
+	LEOScriptRelease( theScript );
+
+	return NUM_ARITHMETIC_BENCHMARK_ITERATIONS;
+}
+
+
+static size_t	DoHandlerRecursionBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	LEOScript*		theScript = LEOScriptCreateForOwner( 0, 0, NULL );
+	LEOHandlerID	mainID = LEOContextGroupHandlerIDForHandlerName( inContext->group, "main" );
+	LEOHandlerID	countDownID = LEOContextGroupHandlerIDForHandlerName( inContext->group, "countDown" );
+
+	// countDown n: if n -1 > 0 then countDown n -1
+	LEOHandler*		countDownHandler = LEOScriptAddCommandHandlerWithID( theScript, countDownID );
+	LEOHandlerAddInstruction( countDownHandler, PARAMETER_INSTR, BACK_OF_STACK, 1 );	// bp+0: n.
+	LEOHandlerAddInstruction( countDownHandler, ADD_INTEGER_INSTR, 0, (uint32_t) -1 );
+	LEOHandlerAddInstruction( countDownHandler, JUMP_RELATIVE_IF_GT_ZERO_INSTR, 0, 3 );
+	LEOHandlerAddInstruction( countDownHandler, POP_VALUE_INSTR, BACK_OF_STACK, 0 );
+	LEOHandlerAddInstruction( countDownHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	LEOHandlerAddInstruction( countDownHandler, PUSH_INTEGER_INSTR, 0, 1 );	// Param count, bp+0 is the param.
+	LEOHandlerAddInstruction( countDownHandler, CALL_HANDLER_INSTR, 0, countDownID );
+	LEOHandlerAddInstruction( countDownHandler, POP_VALUE_INSTR, BACK_OF_STACK, 0 );
+	LEOHandlerAddInstruction( countDownHandler, POP_VALUE_INSTR, BACK_OF_STACK, 0 );
+	LEOHandlerAddInstruction( countDownHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+
+	LEOHandler*		mainHandler = LEOScriptAddCommandHandlerWithID( theScript, mainID );
+	LEOHandlerAddInstruction( mainHandler, PUSH_INTEGER_INSTR, 0, RECURSION_BENCHMARK_DEPTH );
+	LEOHandlerAddInstruction( mainHandler, PUSH_INTEGER_INSTR, 0, 1 );
+	LEOHandlerAddInstruction( mainHandler, CALL_HANDLER_INSTR, 0, countDownID );
+	LEOHandlerAddInstruction( mainHandler, POP_VALUE_INSTR, BACK_OF_STACK, 0 );
+	LEOHandlerAddInstruction( mainHandler, POP_VALUE_INSTR, BACK_OF_STACK, 0 );
+	LEOHandlerAddInstruction( mainHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_RECURSION_BENCHMARK_RUNS; x++ )
+		LEOBenchmarkRunHandler( inContext, theScript, mainID );
+	LEOBenchmarkStop( ioRun, inContext );
+
+	LEOScriptRelease( theScript );
+
+	return NUM_RECURSION_BENCHMARK_RUNS * RECURSION_BENCHMARK_DEPTH;
+}
+
+
+// Like a handler that returns or an expression that is done, popping a mix
+//	of numbers, integers, booleans and strings off the stack at once:
+static size_t	DoStackUnwindingBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	if( inContext->stackEndPtr == NULL )	// Nothing has run in this context yet.
+		inContext->stackEndPtr = inContext->stack;
+	
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_STACK_BENCHMARK_RUNS; x++ )
+	{
+		LEOValuePtr		basePtr = inContext->stackEndPtr;
+		for( size_t y = 0; y < STACK_BENCHMARK_DEPTH; y++ )
+		{
+			switch( y % 4 )
+			{
+				case 0:
+					LEOInitIntegerValue( inContext->stackEndPtr, y, kLEOInvalidateReferences, inContext );
+					break;
+				case 1:
+					LEOInitNumberValue( inContext->stackEndPtr, 0.5, kLEOInvalidateReferences, inContext );
+					break;
+				case 2:
+					LEOInitBooleanValue( inContext->stackEndPtr, true, kLEOInvalidateReferences, inContext );
+					break;
+				default:
+					LEOInitStringConstantValue( inContext->stackEndPtr, "word", kLEOInvalidateReferences, inContext );
+					break;
+			}
+			inContext->stackEndPtr++;
+		}
+		LEOCleanUpStackToPtr( inContext, basePtr );
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	return NUM_STACK_BENCHMARK_RUNS * STACK_BENCHMARK_DEPTH;
+}
+
+
+static size_t	DoChunkIterationBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	union LEOValue	theText;
+	size_t			textSize = NUM_CHUNK_BENCHMARK_ITEMS * 16;
+	char*			textStr = calloc( textSize, sizeof(char) );
+	size_t			textLen = 0;
+	size_t			chunkStart, chunkEnd, delChunkStart, delChunkEnd;
+
+	for( size_t x = 0; x < NUM_CHUNK_BENCHMARK_ITEMS; x++ )
+		textLen += snprintf( textStr +textLen, textSize -textLen, (x > 0) ? ",item%zu" : "item%zu", x );
+	LEOInitStringValue( &theText, textStr, textLen, kLEOInvalidateReferences, inContext );
+	free( textStr );
+
+	// Like a "repeat with x = 1 to the number of items" loop:
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_CHUNK_BENCHMARK_ITEMS; x++ )
+	{
+		chunkStart = 0;
+		chunkEnd = SIZE_MAX;
+		LEODetermineChunkRangeOfSubstring( &theText, &chunkStart, &chunkEnd, &delChunkStart, &delChunkEnd,
+											kLEOChunkTypeItem, x, x, inContext );
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	LEOCleanUpValue( &theText, kLEOInvalidateReferences, inContext );
+
+	return NUM_CHUNK_BENCHMARK_ITEMS;
+}
+
+
+static size_t	DoArrayBuildBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	struct LEOArrayEntry*	theArray = NULL;
+
+	LEOBenchmarkStart( ioRun, inContext );
+	LEOBenchmarkBuildArray( &theArray, inContext );
+	LEOBenchmarkStop( ioRun, inContext );
+
+	LEOCleanUpArray( theArray, inContext );
+
+	return NUM_ARRAY_BENCHMARK_ENTRIES;
+}
+
+
+static size_t	DoArrayLookupBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	struct LEOArrayEntry*	theArray = NULL;
+	char					key[32];
+	size_t					numFound = 0;
+
+	LEOBenchmarkBuildArray( &theArray, inContext );
+
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_ARRAY_BENCHMARK_ENTRIES; x++ )
+	{
+		LEOBenchmarkArrayKey( key, sizeof(key), x );
+		if( LEOGetArrayValueForKey( theArray, key ) )
+			numFound++;
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	if( numFound != NUM_ARRAY_BENCHMARK_ENTRIES )
+		fprintf( stderr, "warning: only found %zu of %d array entries.\n", numFound, NUM_ARRAY_BENCHMARK_ENTRIES );
+
+	LEOCleanUpArray( theArray, inContext );
+
+	return NUM_ARRAY_BENCHMARK_ENTRIES;
+}
+
+
+static size_t	DoArrayCopyBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	struct LEOArrayEntry*	theArray = NULL;
+	struct LEOArrayEntry*	arrayCopy = NULL;
+
+	LEOBenchmarkBuildArray( &theArray, inContext );
+
+	LEOBenchmarkStart( ioRun, inContext );
+	arrayCopy = LEOCopyArray( theArray, inContext );
+	LEOCleanUpArray( arrayCopy, inContext );
+	LEOBenchmarkStop( ioRun, inContext );
+
+	LEOCleanUpArray( theArray, inContext );
+
+	return NUM_ARRAY_BENCHMARK_ENTRIES;
+}
+
+
+static size_t	DoArrayPrintBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	struct LEOArrayEntry*	theArray = NULL;
+	char*					arrayStr = NULL;
+
+	LEOBenchmarkBuildArray( &theArray, inContext );
+
+	// Like putting an array into a text variable:
+	LEOBenchmarkStart( ioRun, inContext );
+	arrayStr = LEOCopyArrayAsString( theArray, NULL, inContext );
+	free( arrayStr );
+	LEOBenchmarkStop( ioRun, inContext );
+
+	LEOCleanUpArray( theArray, inContext );
+
+	return NUM_ARRAY_BENCHMARK_ENTRIES;
+}
+
+
+static size_t	DoArrayParseBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	struct LEOArrayEntry*	theArray = NULL;
+	struct LEOArrayEntry*	parsedArray = NULL;
+	char*					arrayStr = NULL;
+
+	LEOBenchmarkBuildArray( &theArray, inContext );
+	arrayStr = LEOCopyArrayAsString( theArray, NULL, inContext );
+	LEOCleanUpArray( theArray, inContext );
+
+	// Like using a text variable as an array:
+	LEOBenchmarkStart( ioRun, inContext );
+	parsedArray = LEOCreateArrayFromString( arrayStr, inContext );
+	LEOCleanUpArray( parsedArray, inContext );
+	LEOBenchmarkStop( ioRun, inContext );
+
+	free( arrayStr );
+
+	return NUM_ARRAY_BENCHMARK_ENTRIES;
+}
+
+
+static size_t	DoSplitBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	LEOInstruction	splitInstruction = { ASSIGN_CHUNK_ARRAY_INSTR, BACK_OF_STACK, kLEOChunkTypeLine };
+	char*			text = malloc( NUM_SPLIT_BENCHMARK_LINES * 16 );
+	size_t			textLen = 0;
+	char			keyStr[LEO_NUMBER_STRING_MAX_LENGTH];
+
+	for( size_t x = 0; x < NUM_SPLIT_BENCHMARK_LINES; x++ )
+		textLen += snprintf( text +textLen, 16, (x == 0) ? "line %zu" : "\nline %zu", x );
+	LEOPushStringValueOnStack( inContext, text, textLen );
+	free( text );
+
+	// Like "repeat with x = 1 to number of lines of it" over a split text:
+	LEOBenchmarkStart( ioRun, inContext );
+	inContext->currentInstruction = &splitInstruction;
+	gInstructions[ASSIGN_CHUNK_ARRAY_INSTR]( inContext );
+	LEOValuePtr		theArray = inContext->stackEndPtr -1;
+	for( size_t x = 1; x <= NUM_SPLIT_BENCHMARK_LINES; x++ )
+	{
+		LEOFormatInteger( x, keyStr );
+		LEOGetValueAsString( LEOGetValueForKey( theArray, keyStr, inContext ), NULL, 0, inContext );
+	}
+	LEOCleanUpStackToPtr( inContext, theArray );
+	LEOBenchmarkStop( ioRun, inContext );
+
+	return NUM_SPLIT_BENCHMARK_LINES;
+}
+
+
+static size_t	DoReferenceCreationBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	union LEOValue	theValue;
+	union LEOValue	theReference;
+
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_REFERENCE_BENCHMARK_ITERATIONS; x++ )
+	{
+		LEOInitIntegerValue( &theValue, x, kLEOInvalidateReferences, inContext );
+		LEOInitReferenceValue( &theReference, &theValue, kLEOInvalidateReferences, kLEOChunkTypeINVALID, 0, 0, inContext );
+		LEOCleanUpValue( &theReference, kLEOInvalidateReferences, inContext );
+		LEOCleanUpValue( &theValue, kLEOInvalidateReferences, inContext );
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	return NUM_REFERENCE_BENCHMARK_ITERATIONS;
+}
+
+
+static size_t	DoChunkReferenceReadBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	union LEOValue	theText;
+	union LEOValue	theReference;
+	size_t			textSize = NUM_CHUNK_BENCHMARK_ITEMS * 16;
+	char*			textStr = calloc( textSize, sizeof(char) );
+	size_t			textLen = 0;
+	char			itemStr[64];
+
+	for( size_t x = 0; x < NUM_CHUNK_BENCHMARK_ITEMS; x++ )
+		textLen += snprintf( textStr +textLen, textSize -textLen, (x > 0) ? ",%zu" : "%zu", x );
+	LEOInitStringValue( &theText, textStr, textLen, kLEOInvalidateReferences, inContext );
+	free( textStr );
+	LEOInitReferenceValue( &theReference, &theText, kLEOInvalidateReferences, kLEOChunkTypeItem,
+							NUM_CHUNK_BENCHMARK_ITEMS -1, NUM_CHUNK_BENCHMARK_ITEMS -1, inContext );
+
+	// Like using "item x of theText" over and over in a loop body, through a parameter:
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_CHUNK_REFERENCE_BENCHMARK_READS; x++ )
+	{
+		LEOGetValueAsString( &theReference, itemStr, sizeof(itemStr), inContext );
+		LEOGetValueAsInteger( &theReference, inContext );
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	LEOCleanUpValue( &theReference, kLEOInvalidateReferences, inContext );
+	LEOCleanUpValue( &theText, kLEOInvalidateReferences, inContext );
+
+	return NUM_CHUNK_REFERENCE_BENCHMARK_READS;
+}
+
+
+static size_t	DoConcatenationBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	union LEOValue	theText;
+
+	LEOInitStringValue( &theText, "", 0, kLEOInvalidateReferences, inContext );
+
+	// Like "put "word " after theText" in a loop, appending at the end like CONCATENATE_VALUES_INSTR:
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_CONCATENATION_BENCHMARK_ITERATIONS; x++ )
+	{
+		size_t	textLen = strlen( LEOGetValueAsString( &theText, NULL, 0, inContext ) );
+		LEOSetValuePredeterminedRangeAsString( &theText, textLen, textLen, "word ", inContext );
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	LEOCleanUpValue( &theText, kLEOInvalidateReferences, inContext );
+
+	return NUM_CONCATENATION_BENCHMARK_ITERATIONS;
+}
+
+
+static size_t	DoStringAssignmentBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	static const char*	sLines[] = { "Dear Sir or Madam,", "Thank you for your letter", "Kind regards", "P.S.: See you soon!" };
+	union LEOValue		theVariable;
+
+	LEOInitStringVariantValue( &theVariable, "", kLEOInvalidateReferences, inContext );
+
+	// Like "put line x of theLetter into theLine" in a loop:
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_ASSIGNMENT_BENCHMARK_ITERATIONS; x++ )
+		LEOSetValueAsString( &theVariable, sLines[x % 4], inContext );
+	LEOBenchmarkStop( ioRun, inContext );
+
+	LEOCleanUpValue( &theVariable, kLEOInvalidateReferences, inContext );
+
+	return NUM_ASSIGNMENT_BENCHMARK_ITERATIONS;
+}
+
+
+static size_t	DoKeyedWriteBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	union LEOValue	theText;
+	union LEOValue	theValue;
+	char			key[32];
+
+	LEOInitStringValue( &theText, "", 0, kLEOInvalidateReferences, inContext );
+	LEOInitIntegerValue( &theValue, 0, kLEOInvalidateReferences, inContext );
+
+	// Like "put x into theText[key]" in a loop, on a variable that started out as text:
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_KEYED_WRITE_BENCHMARK_KEYS; x++ )
+	{
+		snprintf( key, sizeof(key), "key%zu", x );
+		LEOSetValueAsInteger( &theValue, x, inContext );
+		LEOSetValueForKey( &theText, key, &theValue, inContext );
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, inContext );
+	LEOCleanUpValue( &theText, kLEOInvalidateReferences, inContext );
+
+	return NUM_KEYED_WRITE_BENCHMARK_KEYS;
+}
+
+
+// A mix of what scripts typically convert: counters, prices and results of divisions:
+static LEONumber	LEOBenchmarkNumber( size_t inIndex )
+{
+	switch( inIndex % 3 )
+	{
+		case 0:
+			return (LEONumber) inIndex;
+		case 1:
+			return (LEONumber)(inIndex % 100000) / 100.0;
+		default:
+			return 1.0 / (LEONumber)(inIndex +1);
+	}
+}
+
+
+static size_t	DoNumberFormattingBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	char	str[LEO_NUMBER_STRING_MAX_LENGTH];
+	size_t	totalLen = 0;
+
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_NUMBER_BENCHMARK_VALUES; x++ )
+	{
+		totalLen += LEOFormatNumber( LEOBenchmarkNumber( x ), str );
+		totalLen += LEOFormatInteger( x, str );
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	if( totalLen == 0 )
+		fprintf( stderr, "warning: formatted no numbers.\n" );
+
+	return NUM_NUMBER_BENCHMARK_VALUES * 2;
+}
+
+
+static size_t	DoLibCNumberFormattingBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	char	str[LEO_NUMBER_STRING_MAX_LENGTH];
+	size_t	totalLen = 0;
+
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_NUMBER_BENCHMARK_VALUES; x++ )
+	{
+		totalLen += snprintf( str, sizeof(str), "%g", LEOBenchmarkNumber( x ) );
+		totalLen += snprintf( str, sizeof(str), "%lld", (LEOInteger) x );
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	if( totalLen == 0 )
+		fprintf( stderr, "warning: formatted no numbers.\n" );
+
+	return NUM_NUMBER_BENCHMARK_VALUES * 2;
+}
+
+
+// Each entry is LEO_NUMBER_STRING_MAX_LENGTH bytes, first the number, then the integer:
+static char*	LEOBenchmarkCreateNumberStrings( void )
+{
+	char*	strings = malloc( NUM_NUMBER_BENCHMARK_VALUES * 2 * LEO_NUMBER_STRING_MAX_LENGTH );
+	for( size_t x = 0; x < NUM_NUMBER_BENCHMARK_VALUES; x++ )
+	{
+		LEOFormatNumber( LEOBenchmarkNumber( x ), strings +(x * 2) * LEO_NUMBER_STRING_MAX_LENGTH );
+		LEOFormatInteger( x, strings +(x * 2 +1) * LEO_NUMBER_STRING_MAX_LENGTH );
+	}
+	return strings;
+}
+
+
+static size_t	DoNumberParsingBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	char*		strings = LEOBenchmarkCreateNumberStrings();
+	LEONumber	total = 0;
+	LEOInteger	integerTotal = 0;
+
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_NUMBER_BENCHMARK_VALUES; x++ )
+	{
+		LEONumber	theNumber = 0;
+		LEOInteger	theInteger = 0;
+		LEOParseNumber( strings +(x * 2) * LEO_NUMBER_STRING_MAX_LENGTH, &theNumber );
+		LEOParseInteger( strings +(x * 2 +1) * LEO_NUMBER_STRING_MAX_LENGTH, &theInteger );
+		total += theNumber;
+		integerTotal += theInteger;
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	if( total == 0 || integerTotal == 0 )
+		fprintf( stderr, "warning: parsed no numbers.\n" );
+	free( strings );
+
+	return NUM_NUMBER_BENCHMARK_VALUES * 2;
+}
+
+
+static size_t	DoLibCNumberParsingBenchmark( LEOContext* inContext, LEOBenchmarkRun* ioRun )
+{
+	char*		strings = LEOBenchmarkCreateNumberStrings();
+	LEONumber	total = 0;
+	LEOInteger	integerTotal = 0;
+
+	LEOBenchmarkStart( ioRun, inContext );
+	for( size_t x = 0; x < NUM_NUMBER_BENCHMARK_VALUES; x++ )
+	{
+		total += strtod( strings +(x * 2) * LEO_NUMBER_STRING_MAX_LENGTH, NULL );
+		integerTotal += strtoll( strings +(x * 2 +1) * LEO_NUMBER_STRING_MAX_LENGTH, NULL, 10 );
+	}
+	LEOBenchmarkStop( ioRun, inContext );
+
+	if( total == 0 || integerTotal == 0 )
+		fprintf( stderr, "warning: parsed no numbers.\n" );
+	free( strings );
+
+	return NUM_NUMBER_BENCHMARK_VALUES * 2;
+}
+
+
+static LEOBenchmark		gBenchmarks[] =
+{
+	{ "arithmetic loop", DoArithmeticLoopBenchmark, true, false },
+	{ "arithmetic loop (verified)", DoArithmeticLoopBenchmark, true, true },
+	{ "handler recursion", DoHandlerRecursionBenchmark, true, false },
+	{ "handler recursion (verified)", DoHandlerRecursionBenchmark, true, true },
+	{ "stack unwinding", DoStackUnwindingBenchmark, true, false },
+	{ "chunk iteration", DoChunkIterationBenchmark, true, false },
+	{ "array build", DoArrayBuildBenchmark, true, false },
+	{ "array build (malloc)", DoArrayBuildBenchmark, false, false },
+	{ "array lookup", DoArrayLookupBenchmark, true, false },
+	{ "array copy", DoArrayCopyBenchmark, true, false },
+	{ "array print", DoArrayPrintBenchmark, true, false },
+	{ "array parse", DoArrayParseBenchmark, true, false },
+	{ "split", DoSplitBenchmark, true, false },
+	{ "reference creation", DoReferenceCreationBenchmark, true, false },
+	{ "chunk reference reads", DoChunkReferenceReadBenchmark, true, false },
+	{ "concatenation", DoConcatenationBenchmark, true, false },
+	{ "string assignment", DoStringAssignmentBenchmark, true, false },
+	{ "keyed writes", DoKeyedWriteBenchmark, true, false },
+	{ "number formatting", DoNumberFormattingBenchmark, true, false },
+	{ "number formatting (libc)", DoLibCNumberFormattingBenchmark, true, false },
+	{ "number parsing", DoNumberParsingBenchmark, true, false },
+	{ "number parsing (libc)", DoLibCNumberParsingBenchmark, true, false },
+	{ NULL, NULL, false, false }
+};
+
+
+#pragma mark -
+// -----------------------------------------------------------------------------
+//	Baselines:
+// -----------------------------------------------------------------------------
+
+// Baseline files contain one tab-separated line per benchmark: name, ns/op, allocations/op.
+static size_t	LEOBenchmarkReadBaseline( const char* inPath, LEOBenchmarkResult* outResults, size_t inMaxResults )
+{
+	FILE*	theFile = fopen( inPath, "r" );
+	char	line[256];
+	size_t	numResults = 0;
+
+	if( !theFile )
+	{
+		fprintf( stderr, "error: Couldn't open baseline file \"%s\".\n", inPath );
+		return 0;
+	}
+
+	while( numResults < inMaxResults && fgets( line, sizeof(line), theFile ) )
+	{
+		char*	tabPos = strchr( line, '\t' );
+		if( !tabPos || (size_t)(tabPos -line) >= sizeof(outResults[0].name) )
+			continue;
+
+		memcpy( outResults[numResults].name, line, tabPos -line );
+		outResults[numResults].name[tabPos -line] = 0;
+		if( sscanf( tabPos +1, "%lf\t%lf", &outResults[numResults].nsPerOp, &outResults[numResults].allocationsPerOp ) == 2 )
+			numResults++;
+	}
+	fclose( theFile );
+
+	return numResults;
+}
+
+
+static LEOBenchmarkResult*	LEOBenchmarkFindResult( const char* inName, LEOBenchmarkResult* inResults, size_t inNumResults )
+{
+	for( size_t x = 0; x < inNumResults; x++ )
+	{
+		if( strcmp( inResults[x].name, inName ) == 0 )
+			return inResults +x;
+	}
+
+	return NULL;
+}
+
+
+#pragma mark -
+
+int main( int argc, char** argv )
+{
+	const char*			savePath = NULL;
+	const char*			baselinePath = NULL;
+	const char*			nameFilter = NULL;
+	LEOBenchmarkResult	baseline[LEO_BENCHMARK_MAX_BASELINE_ENTRIES];
+	size_t				numBaselineResults = 0;
+	FILE*				saveFile = NULL;
+	bool				hadAllocationRegression = false;
+	double				sumOfLogSpeedups = 0;
+	size_t				numCompared = 0;
+
+	for( int x = 1; x < argc; x++ )
+	{
+		if( strcmp( argv[x], "--save" ) == 0 && (x +1) < argc )
+			savePath = argv[++x];
+		else if( strcmp( argv[x], "--baseline" ) == 0 && (x +1) < argc )
+			baselinePath = argv[++x];
+		else if( argv[x][0] != '-' )
+			nameFilter = argv[x];
+		else
+		{
+			fprintf( stderr, "usage: %s [--save <file>] [--baseline <file>] [<name filter>]\n", argv[0] );
+			return EXIT_FAILURE;
+		}
+	}
+
+	if( baselinePath )
+	{
+		numBaselineResults = LEOBenchmarkReadBaseline( baselinePath, baseline, LEO_BENCHMARK_MAX_BASELINE_ENTRIES );
+		if( numBaselineResults == 0 )
+			return EXIT_FAILURE;
+	}
+	if( savePath )
+	{
+		saveFile = fopen( savePath, "w" );
+		if( !saveFile )
+		{
+			fprintf( stderr, "error: Couldn't create \"%s\".\n", savePath );
+			return EXIT_FAILURE;
+		}
+	}
+
+	LEOInitInstructionArray();
+
+	for( LEOBenchmark* currBenchmark = gBenchmarks; currBenchmark->name != NULL; currBenchmark++ )
+	{
+		if( nameFilter && strstr( currBenchmark->name, nameFilter ) == NULL )
+			continue;
+
+		double	bestNsPerOp = 0;
+		double	allocationsPerOp = 0;
+		for( int currRepetition = 0; currRepetition < LEO_BENCHMARK_REPETITIONS; currRepetition++ )
+		{
+			LEOContext			ctx;
+			LEOBenchmarkRun		theRun = { 0 };
+			LEOContextGroup*	group = LEOContextGroupCreate();
+			if( !currBenchmark->useSlabs )
+			{
+				LEOSlabAllocatorFree( group->arrayEntryAllocator );
+				group->arrayEntryAllocator = NULL;
+			}
+			LEOInitContext( &ctx, group );
+			LEOContextGroupRelease( group );
+
+			sVerifyHandlers = currBenchmark->verify;
+			size_t	numOps = currBenchmark->func( &ctx, &theRun );
+			if( ctx.errMsg[0] != 0 )
+				fprintf( stderr, "warning: %s: %s\n", currBenchmark->name, ctx.errMsg );
+
+			double	nsPerOp = theRun.elapsedTime / numOps;
+			if( currRepetition == 0 || nsPerOp < bestNsPerOp )
+				bestNsPerOp = nsPerOp;
+			allocationsPerOp = (double)theRun.numAllocations / numOps;
+
+			LEOCleanUpContext( &ctx );
+		}
+
+		printf( "%-32s %10.1f ns/op %8.2f allocs/op", currBenchmark->name, bestNsPerOp, allocationsPerOp );
+		LEOBenchmarkResult*	baselineResult = LEOBenchmarkFindResult( currBenchmark->name, baseline, numBaselineResults );
+		if( baselineResult )
+		{
+			double	change = (baselineResult->nsPerOp > 0) ? ((bestNsPerOp / baselineResult->nsPerOp) -1.0) * 100.0 : 0;
+			printf( " %+7.1f%%", change );
+			if( baselineResult->nsPerOp > 0 && bestNsPerOp > 0 )
+			{
+				double	speedup = baselineResult->nsPerOp / bestNsPerOp;
+				printf( " %5.2fx", speedup );
+				sumOfLogSpeedups += log( speedup );
+				numCompared++;
+			}
+			if( bestNsPerOp > baselineResult->nsPerOp * LEO_BENCHMARK_SLOWDOWN_THRESHOLD )
+				printf( " SLOWER" );
+			if( allocationsPerOp > baselineResult->allocationsPerOp +0.005 )
+			{
+				printf( " MORE ALLOCATIONS (was %.2f)", baselineResult->allocationsPerOp );
+				hadAllocationRegression = true;
+			}
+		}
+		printf( "\n" );
+
+		if( saveFile )
+			fprintf( saveFile, "%s\t%.1f\t%.2f\n", currBenchmark->name, bestNsPerOp, allocationsPerOp );
+	}
+
+	if( saveFile )
+		fclose( saveFile );
+
+	// The geometric mean, so one benchmark that got much faster doesn't hide the others:
+	if( numCompared > 0 )
+		printf( "\nspeedup over baseline: %.2fx (geometric mean of %zu benchmarks)\n", exp( sumOfLogSpeedups / numCompared ), numCompared );
+
+	return hadAllocationRegression ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+/*
+ *  LEOArena.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOArena.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+// Every allocation is preceded by a header containing its (rounded) size, so
+//	we can give back the most recent allocation right away:
+#define LEOArenaHeaderSize				sizeof(size_t)
+#define LEOArenaAlignment				sizeof(size_t)
+#define LEOArenaRoundUp(n)				(((n) +LEOArenaAlignment -1) & ~(LEOArenaAlignment -1))
+
+
+
+LEOArena*	LEOArenaCreate( size_t inSize )
+{
+	LEOArena*	theArena = calloc( 1, sizeof(LEOArena) );
+	inSize = LEOArenaRoundUp( inSize );
+	theArena->start = malloc( inSize );
+	theArena->end = theArena->start +inSize;
+	theArena->top = theArena->start;
+
+	return theArena;
+}
+
+
+void	LEOArenaFree( LEOArena* inArena )
+{
+	if( inArena->start )
+		free( inArena->start );
+	inArena->start = inArena->end = inArena->top = NULL;
+	free( inArena );
+}
+
+
+void*	LEOArenaAllocate( LEOArena* inArena, size_t inSize )
+{
+	size_t	blockSize = LEOArenaRoundUp( inSize ) +LEOArenaHeaderSize;
+	if( blockSize > (size_t)(inArena->end -inArena->top) )
+	{
+		inArena->statistics.numFallbackAllocations ++;
+		return NULL;
+	}
+
+	*(size_t*)inArena->top = blockSize;
+	void*	thePtr = inArena->top +LEOArenaHeaderSize;
+	inArena->top += blockSize;
+	inArena->numLiveAllocations ++;
+
+	inArena->statistics.numAllocations ++;
+	inArena->statistics.numBytesAllocated += blockSize;
+	if( (size_t)(inArena->top -inArena->start) > inArena->statistics.maxBytesInUse )
+		inArena->statistics.maxBytesInUse = inArena->top -inArena->start;
+
+	return thePtr;
+}
+
+
+bool	LEOArenaContainsPointer( LEOArena* inArena, void* inPtr )
+{
+	return( (char*)inPtr >= inArena->start && (char*)inPtr < inArena->end );
+}
+
+
+void	LEOArenaRelease( LEOArena* inArena, void* inPtr )
+{
+	char*	theBlock = ((char*)inPtr) -LEOArenaHeaderSize;
+
+	inArena->numLiveAllocations --;
+	if( inArena->numLiveAllocations == 0 )
+	{
+		inArena->top = inArena->start;
+		inArena->statistics.numRewinds ++;
+	}
+	else if( theBlock +(*(size_t*)theBlock) == inArena->top )	// Most recent allocation? Hand back right away.
+		inArena->top = theBlock;
+}
+
+
+void	LEOArenaRewind( LEOArena* inArena )
+{
+	inArena->top = inArena->start;
+	inArena->numLiveAllocations = 0;
+}
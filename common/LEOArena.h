@@ -0,0 +1,128 @@
+/*
+ *  LEOArena.h
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*!
+	@header LEOArena
+	A simple bump allocator a LEOContext can use for the buffers of transient
+	string values it creates on its stack (results of concatenation, chunk
+	expressions, strings pushed from the string table etc.).
+
+	Memory is handed out by bumping a pointer through one fixed-size block.
+	Releasing the most recent allocation hands its memory back right away,
+	and once no allocations are alive anymore the whole block is reused from
+	the start. If a request doesn't fit, the caller is expected to fall back
+	to malloc(), so the arena never fails, it only gets less effective.
+
+	Values only ever get their buffers from the arena when they are created
+	directly on the context's stack. Copies (e.g. into globals, array entries
+	or variables) are always allocated on the heap, so nothing that outlives
+	the stack ever points into the arena.
+*/
+
+#ifndef LEO_ARENA_H
+#define LEO_ARENA_H		1
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include <sys/types.h>
+#include <stdbool.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+/*! A good size for a context's arena if you don't have any better idea. */
+#define LEO_DEFAULT_ARENA_SIZE		(64 * 1024)
+
+
+// -----------------------------------------------------------------------------
+//	Types:
+// -----------------------------------------------------------------------------
+
+/*! Counters that show how much an arena helped.
+	@field	numAllocations			Number of allocations served from the arena, i.e. calls to malloc() avoided.
+	@field	numFallbackAllocations	Number of requests that didn't fit and had to go to the heap.
+	@field	numBytesAllocated		Total number of bytes served from the arena.
+	@field	maxBytesInUse			Largest amount of arena memory that was in use at once.
+	@field	numRewinds				Number of times the arena became empty and was reused from the start.
+*/
+typedef struct LEOArenaStatistics
+{
+	size_t		numAllocations;
+	size_t		numFallbackAllocations;
+	size_t		numBytesAllocated;
+	size_t		maxBytesInUse;
+	size_t		numRewinds;
+} LEOArenaStatistics;
+
+
+/*! A bump allocator. Create it using LEOArenaCreate().
+	@field	start				First byte of the arena's memory block.
+	@field	end					First byte after the arena's memory block.
+	@field	top					Where the next allocation will be made.
+	@field	numLiveAllocations	Number of allocations that haven't been released yet.
+	@field	statistics			Counters for the host to check how well the arena works.
+*/
+typedef struct LEOArena
+{
+	char*				start;
+	char*				end;
+	char*				top;
+	size_t				numLiveAllocations;
+	LEOArenaStatistics	statistics;
+} LEOArena;
+
+
+// -----------------------------------------------------------------------------
+//	Prototypes:
+// -----------------------------------------------------------------------------
+
+/*!
+	Create a new arena that can hand out inSize bytes in total (including a
+	small per-allocation overhead).
+	@seealso //leo_ref/c/func/LEOArenaFree LEOArenaFree
+*/
+LEOArena*	LEOArenaCreate( size_t inSize );
+
+/*!
+	Dispose of the given arena and its memory block. Any memory still handed
+	out from it becomes invalid.
+*/
+void		LEOArenaFree( LEOArena* inArena );
+
+/*!
+	Hand out inSize bytes of uninitialized memory from the arena, or return
+	NULL if there isn't enough room left, in which case the caller should
+	use malloc() instead.
+	@seealso //leo_ref/c/func/LEOArenaRelease LEOArenaRelease
+*/
+void*		LEOArenaAllocate( LEOArena* inArena, size_t inSize );
+
+/*!
+	Returns TRUE if the given pointer was handed out by this arena, FALSE if
+	it is e.g. a heap block.
+*/
+bool		LEOArenaContainsPointer( LEOArena* inArena, void* inPtr );
+
+/*!
+	Give back memory obtained from LEOArenaAllocate().
+*/
+void		LEOArenaRelease( LEOArena* inArena, void* inPtr );
+
+/*!
+	Forget about all allocations and start reusing the arena's memory from the
+	beginning. Only call this when you know nobody uses the memory anymore.
+*/
+void		LEOArenaRewind( LEOArena* inArena );
+
+
+#endif // LEO_ARENA_H
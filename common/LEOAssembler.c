@@ -0,0 +1,719 @@
+/*
+ *  LEOAssembler.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOAssembler.h"
+#include "LEOInstructions.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <ctype.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+#define LEOAssemblerChunkSize			16
+#define LEOAssemblerMaxNameLength		64
+#define LEOAssemblerBackOfStackName		"BACK"
+
+
+// -----------------------------------------------------------------------------
+//	Types:
+// -----------------------------------------------------------------------------
+
+// A label defined in the current handler, or a reference to one that still
+//	needs to be filled in once we know where all labels are:
+typedef struct LEOAssemblerLabel
+{
+	char		name[LEOAssemblerMaxNameLength];
+	size_t		instructionIndex;
+	size_t		lineNumber;
+} LEOAssemblerLabel;
+
+
+// State while assembling a script:
+typedef struct LEOAssembler
+{
+	LEOScript*			script;
+	LEOContextGroup*	group;
+	LEOHandler*			handler;		// Handler between "command"/"function" and "end", or NULL.
+	size_t				lineNumber;
+	size_t				numLabels;
+	LEOAssemblerLabel*	labels;
+	size_t				numLabelReferences;
+	LEOAssemblerLabel*	labelReferences;
+	bool				failed;
+	char*				errMsg;
+	size_t				errMsgSize;
+} LEOAssembler;
+
+
+#pragma mark Assembling
+
+static void	LEOAssemblerFail( LEOAssembler* inAssembler, const char* inFormatString, ... )
+{
+	if( inAssembler->failed )
+		return;
+
+	inAssembler->failed = true;
+	int			prefixLength = snprintf( inAssembler->errMsg, inAssembler->errMsgSize, "line %zu: ", inAssembler->lineNumber );
+	if( prefixLength < 0 || (size_t)prefixLength >= inAssembler->errMsgSize )
+		return;
+
+	va_list		varargs;
+	va_start( varargs, inFormatString );
+	vsnprintf( inAssembler->errMsg +prefixLength, inAssembler->errMsgSize -prefixLength, inFormatString, varargs );
+	va_end( varargs );
+}
+
+
+static const char*	LEOAssemblerSkipSpaces( const char* inPos )
+{
+	while( *inPos == ' ' || *inPos == '\t' )
+		inPos++;
+	return inPos;
+}
+
+
+static bool	LEOAssemblerIsNameCharacter( char inCh )
+{
+	return isalnum( (unsigned char)inCh ) || inCh == '_';
+}
+
+
+// Copy the name at ioPos into outName and advance ioPos past it:
+static bool	LEOAssemblerParseName( LEOAssembler* inAssembler, const char** ioPos, char* outName )
+{
+	const char*	nameEnd = *ioPos;
+	while( LEOAssemblerIsNameCharacter( *nameEnd ) )
+		nameEnd++;
+	size_t		nameLength = nameEnd -*ioPos;
+	if( nameLength == 0 )
+	{
+		LEOAssemblerFail( inAssembler, "Expected a name." );
+		return false;
+	}
+	if( nameLength >= LEOAssemblerMaxNameLength )
+	{
+		LEOAssemblerFail( inAssembler, "Name too long." );
+		return false;
+	}
+
+	memcpy( outName, *ioPos, nameLength );
+	outName[nameLength] = 0;
+	*ioPos = nameEnd;
+
+	return true;
+}
+
+
+// Returns a malloc()ed copy of the quoted string at ioPos without quotes and
+//	escapes, and advances ioPos past the closing quote:
+static char*	LEOAssemblerParseStringLiteral( LEOAssembler* inAssembler, const char** ioPos )
+{
+	const char*	currCh = *ioPos;
+	if( *currCh != '"' )
+	{
+		LEOAssemblerFail( inAssembler, "Expected a quoted string." );
+		return NULL;
+	}
+	currCh++;
+
+	char*		theString = malloc( strlen(currCh) +1 );	// The unescaped string is never longer than the rest of the line.
+	size_t		stringLength = 0;
+	while( *currCh != '"' )
+	{
+		if( *currCh == 0 )
+		{
+			LEOAssemblerFail( inAssembler, "Missing closing quote." );
+			free( theString );
+			return NULL;
+		}
+		if( *currCh == '\\' )
+		{
+			currCh++;
+			switch( *currCh )
+			{
+				case 'n':	theString[stringLength++] = '\n';	break;
+				case 'r':	theString[stringLength++] = '\r';	break;
+				case 't':	theString[stringLength++] = '\t';	break;
+				case '"':
+				case '\\':	theString[stringLength++] = *currCh;	break;
+				case 'x':
+					if( isxdigit( (unsigned char)currCh[1] ) && isxdigit( (unsigned char)currCh[2] ) )
+					{
+						char	hexDigits[3] = { currCh[1], currCh[2], 0 };
+						theString[stringLength++] = (char) strtol( hexDigits, NULL, 16 );
+						currCh += 2;
+						break;
+					}
+					// Otherwise fall through to error:
+				default:
+					LEOAssemblerFail( inAssembler, "Invalid escape sequence in string." );
+					free( theString );
+					return NULL;
+			}
+			currCh++;
+		}
+		else
+			theString[stringLength++] = *(currCh++);
+	}
+	theString[stringLength] = 0;
+	*ioPos = currCh +1;
+
+	return theString;
+}
+
+
+static bool	LEOAssemblerIsFloatingPointNumber( const char* inStart, const char* inEnd )
+{
+	if( *inStart == '-' || *inStart == '+' )
+		inStart++;
+	if( strncasecmp( inStart, "inf", 3 ) == 0 || strncasecmp( inStart, "nan", 3 ) == 0 )
+		return true;
+	if( inStart[0] == '0' && (inStart[1] == 'x' || inStart[1] == 'X') )	// Hex integer, 'e' is a digit.
+		return false;
+	for( const char* currCh = inStart; currCh < inEnd; currCh++ )
+	{
+		if( *currCh == '.' || *currCh == 'e' || *currCh == 'E' )
+			return true;
+	}
+	return false;
+}
+
+
+// Parse one instruction parameter at ioPos. Labels are only allowed in param2,
+//	we can't know their offset yet, so we remember where they're used instead:
+static bool	LEOAssemblerParseParameter( LEOAssembler* inAssembler, const char** ioPos, bool isParam2, uint32_t* outValue )
+{
+	const char*	currCh = *ioPos;
+	int64_t		minValue = isParam2 ? INT32_MIN : INT16_MIN;
+	int64_t		maxValue = isParam2 ? UINT32_MAX : UINT16_MAX;
+
+	*outValue = 0;
+	if( *currCh == '"' )
+	{
+		char*	theString = LEOAssemblerParseStringLiteral( inAssembler, &currCh );
+		if( !theString )
+			return false;
+		size_t	stringIndex = LEOScriptAddString( inAssembler->script, theString );
+		free( theString );
+		if( stringIndex > (size_t)maxValue )
+		{
+			LEOAssemblerFail( inAssembler, "Too many strings for parameter." );
+			return false;
+		}
+		*outValue = (uint32_t) stringIndex;
+	}
+	else if( *currCh == '$' )
+	{
+		char	handlerName[LEOAssemblerMaxNameLength];
+		currCh++;
+		if( !isParam2 )
+		{
+			LEOAssemblerFail( inAssembler, "Handler names are only allowed as the second parameter." );
+			return false;
+		}
+		if( !LEOAssemblerParseName( inAssembler, &currCh, handlerName ) )
+			return false;
+		*outValue = (uint32_t) LEOContextGroupHandlerIDForHandlerName( inAssembler->group, handlerName );
+	}
+	else if( *currCh == '@' )
+	{
+		currCh++;
+		if( !isParam2 )
+		{
+			LEOAssemblerFail( inAssembler, "Labels are only allowed as the second parameter." );
+			return false;
+		}
+		if( (inAssembler->numLabelReferences % LEOAssemblerChunkSize) == 0 )
+			inAssembler->labelReferences = realloc( inAssembler->labelReferences, sizeof(LEOAssemblerLabel) * (inAssembler->numLabelReferences +LEOAssemblerChunkSize) );
+		LEOAssemblerLabel*	theReference = inAssembler->labelReferences +inAssembler->numLabelReferences;
+		if( !LEOAssemblerParseName( inAssembler, &currCh, theReference->name ) )
+			return false;
+		theReference->instructionIndex = inAssembler->handler->numInstructions;
+		theReference->lineNumber = inAssembler->lineNumber;
+		inAssembler->numLabelReferences++;
+	}
+	else if( strncmp( currCh, LEOAssemblerBackOfStackName, sizeof(LEOAssemblerBackOfStackName) -1 ) == 0
+				&& !LEOAssemblerIsNameCharacter( currCh[sizeof(LEOAssemblerBackOfStackName) -1] ) )
+	{
+		*outValue = BACK_OF_STACK;
+		currCh += sizeof(LEOAssemblerBackOfStackName) -1;
+	}
+	else
+	{
+		const char*	numberEnd = currCh;
+		while( *numberEnd != 0 && *numberEnd != ',' && *numberEnd != ')' && *numberEnd != ' ' && *numberEnd != '\t' )
+			numberEnd++;
+		if( numberEnd == currCh )
+		{
+			LEOAssemblerFail( inAssembler, "Expected a parameter." );
+			return false;
+		}
+
+		char*	parsedEnd = NULL;
+		if( LEOAssemblerIsFloatingPointNumber( currCh, numberEnd ) )
+		{
+			double	theNumber = strtod( currCh, &parsedEnd );
+			*outValue = LEOCastLEONumberToUInt32( theNumber );
+		}
+		else
+		{
+			long long	theNumber = strtoll( currCh, &parsedEnd, 0 );
+			if( theNumber < minValue || theNumber > maxValue )
+			{
+				LEOAssemblerFail( inAssembler, "Parameter %lld out of range.", theNumber );
+				return false;
+			}
+			*outValue = (uint32_t) theNumber;
+		}
+		if( parsedEnd != numberEnd )
+		{
+			LEOAssemblerFail( inAssembler, "Invalid number \"%.*s\".", (int)(numberEnd -currCh), currCh );
+			return false;
+		}
+		currCh = numberEnd;
+	}
+
+	*ioPos = currCh;
+	return true;
+}
+
+
+static void	LEOAssemblerParseInstruction( LEOAssembler* inAssembler, const char* inLine )
+{
+	const char*	openBracket = strchr( inLine, '(' );
+	if( !openBracket )
+	{
+		LEOAssemblerFail( inAssembler, "Expected an instruction." );
+		return;
+	}
+	if( !inAssembler->handler )
+	{
+		LEOAssemblerFail( inAssembler, "Instruction outside a handler." );
+		return;
+	}
+
+	// Instruction names may contain spaces (e.g. "# Line"), so only trim the end:
+	const char*	nameEnd = openBracket;
+	while( nameEnd > inLine && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t') )
+		nameEnd--;
+	char		instructionName[LEOAssemblerMaxNameLength];
+	if( (size_t)(nameEnd -inLine) >= sizeof(instructionName) )
+	{
+		LEOAssemblerFail( inAssembler, "Unknown instruction \"%.*s\".", (int)(nameEnd -inLine), inLine );
+		return;
+	}
+	memcpy( instructionName, inLine, nameEnd -inLine );
+	instructionName[nameEnd -inLine] = 0;
+	LEOInstructionID	theID = INVALID_INSTR;
+	if( !LEOInstructionIDForName( instructionName, &theID ) )
+	{
+		LEOAssemblerFail( inAssembler, "Unknown instruction \"%s\".", instructionName );
+		return;
+	}
+
+	uint32_t	params[2] = { 0, 0 };
+	const char*	currCh = LEOAssemblerSkipSpaces( openBracket +1 );
+	for( int paramIndex = 0; paramIndex < 2 && *currCh != ')'; paramIndex++ )
+	{
+		if( paramIndex > 0 )
+		{
+			if( *currCh != ',' )
+			{
+				LEOAssemblerFail( inAssembler, "Expected \",\" or \")\"." );
+				return;
+			}
+			currCh = LEOAssemblerSkipSpaces( currCh +1 );
+		}
+		if( !LEOAssemblerParseParameter( inAssembler, &currCh, paramIndex == 1, params +paramIndex ) )
+			return;
+		currCh = LEOAssemblerSkipSpaces( currCh );
+	}
+	if( *currCh != ')' )
+	{
+		LEOAssemblerFail( inAssembler, "Expected \")\"." );
+		return;
+	}
+	currCh = LEOAssemblerSkipSpaces( currCh +1 );
+	if( *currCh == ';' )
+		currCh = LEOAssemblerSkipSpaces( currCh +1 );
+	if( *currCh != 0 && strncmp( currCh, "//", 2 ) != 0 )
+	{
+		LEOAssemblerFail( inAssembler, "Unexpected text after instruction." );
+		return;
+	}
+
+	LEOHandlerAddInstruction( inAssembler->handler, theID, (uint16_t) params[0], params[1] );
+}
+
+
+static void	LEOAssemblerDefineLabel( LEOAssembler* inAssembler, const char* inName )
+{
+	if( !inAssembler->handler )
+	{
+		LEOAssemblerFail( inAssembler, "Label outside a handler." );
+		return;
+	}
+	for( size_t x = 0; x < inAssembler->numLabels; x++ )
+	{
+		if( strcmp( inAssembler->labels[x].name, inName ) == 0 )
+		{
+			LEOAssemblerFail( inAssembler, "Label \"%s\" defined twice.", inName );
+			return;
+		}
+	}
+
+	if( (inAssembler->numLabels % LEOAssemblerChunkSize) == 0 )
+		inAssembler->labels = realloc( inAssembler->labels, sizeof(LEOAssemblerLabel) * (inAssembler->numLabels +LEOAssemblerChunkSize) );
+	LEOAssemblerLabel*	theLabel = inAssembler->labels +inAssembler->numLabels;
+	strcpy( theLabel->name, inName );
+	theLabel->instructionIndex = inAssembler->handler->numInstructions;
+	theLabel->lineNumber = inAssembler->lineNumber;
+	inAssembler->numLabels++;
+}
+
+
+// Fill in the relative offsets of all jumps to labels in the current handler:
+static void	LEOAssemblerEndHandler( LEOAssembler* inAssembler )
+{
+	for( size_t x = 0; x < inAssembler->numLabelReferences && !inAssembler->failed; x++ )
+	{
+		LEOAssemblerLabel*	currReference = inAssembler->labelReferences +x;
+		size_t				labelIndex = 0;
+		for( labelIndex = 0; labelIndex < inAssembler->numLabels; labelIndex++ )
+		{
+			if( strcmp( inAssembler->labels[labelIndex].name, currReference->name ) == 0 )
+				break;
+		}
+		if( labelIndex == inAssembler->numLabels )
+		{
+			inAssembler->lineNumber = currReference->lineNumber;
+			LEOAssemblerFail( inAssembler, "Unknown label \"%s\".", currReference->name );
+			break;
+		}
+
+		int32_t	offset = (int32_t)((long long)inAssembler->labels[labelIndex].instructionIndex -(long long)currReference->instructionIndex);
+		inAssembler->handler->instructions[currReference->instructionIndex].param2 = (uint32_t) offset;
+	}
+
+	inAssembler->numLabels = 0;
+	inAssembler->numLabelReferences = 0;
+	inAssembler->handler = NULL;
+}
+
+
+static void	LEOAssemblerParseLine( LEOAssembler* inAssembler, const char* inLine )
+{
+	const char*	currCh = LEOAssemblerSkipSpaces( inLine );
+	if( *currCh == 0 || strncmp( currCh, "//", 2 ) == 0 )
+		return;
+
+	// Read the first word, if there is one, to find out what kind of line this is:
+	const char*	wordEnd = currCh;
+	while( LEOAssemblerIsNameCharacter( *wordEnd ) )
+		wordEnd++;
+	size_t		wordLength = wordEnd -currCh;
+	const char*	afterWord = LEOAssemblerSkipSpaces( wordEnd );
+
+	if( (wordLength == 7 && strncmp( currCh, "command", 7 ) == 0) || (wordLength == 8 && strncmp( currCh, "function", 8 ) == 0) )
+	{
+		char	handlerName[LEOAssemblerMaxNameLength];
+		bool	isFunction = (wordLength == 8);
+		if( inAssembler->handler )
+		{
+			LEOAssemblerFail( inAssembler, "Missing \"end\" before next handler." );
+			return;
+		}
+		if( !LEOAssemblerParseName( inAssembler, &afterWord, handlerName ) )
+			return;
+		LEOHandlerID	handlerID = LEOContextGroupHandlerIDForHandlerName( inAssembler->group, handlerName );
+		if( isFunction ? LEOScriptFindFunctionHandlerWithID( inAssembler->script, handlerID ) : LEOScriptFindCommandHandlerWithID( inAssembler->script, handlerID ) )
+		{
+			LEOAssemblerFail( inAssembler, "Handler \"%s\" defined twice.", handlerName );
+			return;
+		}
+		inAssembler->handler = isFunction ? LEOScriptAddFunctionHandlerWithID( inAssembler->script, handlerID )
+											: LEOScriptAddCommandHandlerWithID( inAssembler->script, handlerID );
+	}
+	else if( wordLength == 3 && strncmp( currCh, "end", 3 ) == 0 && *afterWord == 0 )
+	{
+		if( !inAssembler->handler )
+		{
+			LEOAssemblerFail( inAssembler, "\"end\" outside a handler." );
+			return;
+		}
+		LEOAssemblerEndHandler( inAssembler );
+	}
+	else if( wordLength == 6 && strncmp( currCh, "string", 6 ) == 0 && *afterWord == '"' )
+	{
+		char*	theString = LEOAssemblerParseStringLiteral( inAssembler, &afterWord );
+		if( theString )
+		{
+			LEOScriptAddString( inAssembler->script, theString );
+			free( theString );
+		}
+	}
+	else if( wordLength == 8 && strncmp( currCh, "variable", 8 ) == 0 && *afterWord == '"' )
+	{
+		if( !inAssembler->handler )
+		{
+			LEOAssemblerFail( inAssembler, "Variable outside a handler." );
+			return;
+		}
+		char*	realVariableName = LEOAssemblerParseStringLiteral( inAssembler, &afterWord );
+		afterWord = LEOAssemblerSkipSpaces( afterWord );
+		char*	variableName = realVariableName ? LEOAssemblerParseStringLiteral( inAssembler, &afterWord ) : NULL;
+		if( variableName )
+		{
+			char*	numberEnd = NULL;
+			long	bpRelativeAddress = strtol( afterWord, &numberEnd, 0 );
+			if( numberEnd == afterWord || *LEOAssemblerSkipSpaces( numberEnd ) != 0 )
+				LEOAssemblerFail( inAssembler, "Expected the variable's address." );
+			else
+				LEOHandlerAddVariableNameMapping( inAssembler->handler, variableName, realVariableName, bpRelativeAddress );
+		}
+		if( realVariableName )
+			free( realVariableName );
+		if( variableName )
+			free( variableName );
+	}
+	else if( wordLength > 0 && *wordEnd == ':' && *LEOAssemblerSkipSpaces( wordEnd +1 ) == 0 )
+	{
+		char	labelName[LEOAssemblerMaxNameLength];
+		if( LEOAssemblerParseName( inAssembler, &currCh, labelName ) )
+			LEOAssemblerDefineLabel( inAssembler, labelName );
+	}
+	else
+		LEOAssemblerParseInstruction( inAssembler, currCh );
+}
+
+
+LEOScript*	LEOAssembleScript( const char* inText, size_t inTextLength, LEOContextGroup* inGroup, char* outErrMsg, size_t inErrMsgSize )
+{
+	LEOAssembler	assembler = { 0 };
+	assembler.script = LEOScriptCreateForOwner( 0, 0, NULL );
+	assembler.group = inGroup;
+	assembler.errMsg = outErrMsg;
+	assembler.errMsgSize = inErrMsgSize;
+
+	// Make a copy we can terminate each line of with a zero byte:
+	char*	theText = malloc( inTextLength +1 );
+	memcpy( theText, inText, inTextLength );
+	theText[inTextLength] = 0;
+
+	char*	currLine = theText;
+	while( currLine && !assembler.failed )
+	{
+		char*	lineEnd = strchr( currLine, '\n' );
+		if( lineEnd )
+			*(lineEnd++) = 0;
+		size_t	lineLength = strlen( currLine );
+		if( lineLength > 0 && currLine[lineLength -1] == '\r' )
+			currLine[lineLength -1] = 0;
+
+		assembler.lineNumber++;
+		LEOAssemblerParseLine( &assembler, currLine );
+		currLine = lineEnd;
+	}
+	if( !assembler.failed && assembler.handler )
+		LEOAssemblerFail( &assembler, "Missing \"end\" at end of file." );
+
+	free( theText );
+	if( assembler.labels )
+		free( assembler.labels );
+	if( assembler.labelReferences )
+		free( assembler.labelReferences );
+
+	if( assembler.failed )
+	{
+		LEOScriptRelease( assembler.script );
+		return NULL;
+	}
+
+	return assembler.script;
+}
+
+
+#pragma mark -
+#pragma mark Disassembling
+
+static void	LEODisassemblerWriteString( FILE* outFile, const char* inString )
+{
+	fputc( '"', outFile );
+	for( const char* currCh = inString; *currCh != 0; currCh++ )
+	{
+		switch( *currCh )
+		{
+			case '"':	fputs( "\\\"", outFile );	break;
+			case '\\':	fputs( "\\\\", outFile );	break;
+			case '\n':	fputs( "\\n", outFile );	break;
+			case '\r':	fputs( "\\r", outFile );	break;
+			case '\t':	fputs( "\\t", outFile );	break;
+			default:
+				if( (unsigned char)*currCh < 0x20 )
+					fprintf( outFile, "\\x%02x", (unsigned char)*currCh );
+				else
+					fputc( *currCh, outFile );
+		}
+	}
+	fputc( '"', outFile );
+}
+
+
+static bool	LEODisassemblerIsJump( LEOInstructionID inID )
+{
+	return inID >= JUMP_RELATIVE_INSTR && inID <= JUMP_RELATIVE_IF_LT_SAME_ZERO_INSTR;
+}
+
+
+static void	LEODisassemblerWriteParam2( LEOScript* inScript, LEOContextGroup* inGroup, LEOHandler* inHandler, size_t inInstructionIndex, FILE* outFile )
+{
+	LEOInstruction*	theInstruction = inHandler->instructions +inInstructionIndex;
+	uint32_t		param2 = theInstruction->param2;
+
+	switch( theInstruction->instructionID )
+	{
+		case PUSH_STR_FROM_TABLE_INSTR:
+		case ASSIGN_STRING_FROM_TABLE_INSTR:
+		case PUSH_STR_VARIANT_FROM_TABLE_INSTR:
+			if( param2 < inScript->numStrings )
+			{
+				LEODisassemblerWriteString( outFile, inScript->strings[param2] );
+				return;
+			}
+			break;
+
+		case CALL_HANDLER_INSTR:
+		{
+			const char*	handlerName = LEOContextGroupHandlerNameForHandlerID( inGroup, param2 );
+			if( handlerName )
+			{
+				fprintf( outFile, "$%s", handlerName );
+				return;
+			}
+			break;
+		}
+
+		case PUSH_NUMBER_INSTR:
+		case ADD_NUMBER_INSTR:
+		{
+			// 9 significant digits are enough for any float to survive the trip:
+			char	numStr[40];
+			snprintf( numStr, sizeof(numStr), "%.9g", LEOCastUInt32ToLEONumber( param2 ) );
+			if( strpbrk( numStr, ".einfa" ) == NULL )
+				strcat( numStr, ".0" );
+			fputs( numStr, outFile );
+			return;
+		}
+
+		case PUSH_INTEGER_INSTR:
+		case ADD_INTEGER_INSTR:
+			fprintf( outFile, "%d", LEOCastUInt32ToInt32( param2 ) );
+			return;
+	}
+
+	if( LEODisassemblerIsJump( theInstruction->instructionID ) )
+	{
+		long long	target = (long long)inInstructionIndex +LEOCastUInt32ToInt32( param2 );
+		if( target >= 0 && target <= (long long)inHandler->numInstructions )
+			fprintf( outFile, "@L%lld", target );
+		else
+			fprintf( outFile, "%d", LEOCastUInt32ToInt32( param2 ) );
+		return;
+	}
+
+	fprintf( outFile, "%u", param2 );
+}
+
+
+static void	LEODisassembleHandler( LEOScript* inScript, LEOContextGroup* inGroup, LEOHandler* inHandler, const char* inKind, FILE* outFile )
+{
+	const char*	handlerName = LEOContextGroupHandlerNameForHandlerID( inGroup, inHandler->handlerName );
+	fprintf( outFile, "%s %s\n", inKind, handlerName ? handlerName : "" );
+
+	// Find all instructions something jumps to, so we can give them labels:
+	bool*		isJumpTarget = calloc( inHandler->numInstructions +1, sizeof(bool) );
+	for( size_t x = 0; x < inHandler->numInstructions; x++ )
+	{
+		LEOInstruction*	currInstruction = inHandler->instructions +x;
+		if( !LEODisassemblerIsJump( currInstruction->instructionID ) )
+			continue;
+		long long		target = (long long)x +LEOCastUInt32ToInt32( currInstruction->param2 );
+		if( target >= 0 && target <= (long long)inHandler->numInstructions )
+			isJumpTarget[target] = true;
+	}
+
+	for( size_t x = 0; x <= inHandler->numInstructions; x++ )
+	{
+		if( isJumpTarget[x] )
+			fprintf( outFile, "L%zu:\n", x );
+		if( x == inHandler->numInstructions )
+			break;
+
+		LEOInstruction*	currInstruction = inHandler->instructions +x;
+		LEOInstructionID	currID = (currInstruction->instructionID < gNumInstructions) ? currInstruction->instructionID : INVALID_INSTR;
+		fprintf( outFile, "\t%s( ", gInstructionNames[currID] );
+		if( currInstruction->param1 == BACK_OF_STACK )
+			fputs( LEOAssemblerBackOfStackName, outFile );
+		else
+			fprintf( outFile, "%d", (int) LEOCastUInt16ToInt16( currInstruction->param1 ) );
+		fputs( ", ", outFile );
+		LEODisassemblerWriteParam2( inScript, inGroup, inHandler, x, outFile );
+		fputs( " );\n", outFile );
+	}
+	free( isJumpTarget );
+
+	for( size_t x = 0; x < inHandler->numVariables; x++ )
+	{
+		LEOVariableNameMapping*	currVariable = inHandler->varNames +x;
+		char					nameBuf[DBG_VAR_NAME_SIZE +1] = { 0 };
+		fputs( "\tvariable ", outFile );
+		strncpy( nameBuf, currVariable->realVariableName, DBG_VAR_NAME_SIZE );
+		LEODisassemblerWriteString( outFile, nameBuf );
+		fputc( ' ', outFile );
+		strncpy( nameBuf, currVariable->variableName, DBG_VAR_NAME_SIZE );
+		LEODisassemblerWriteString( outFile, nameBuf );
+		fprintf( outFile, " %ld\n", currVariable->bpRelativeAddress );
+	}
+
+	fputs( "end\n", outFile );
+}
+
+
+bool	LEODisassembleScript( LEOScript* inScript, LEOContextGroup* inGroup, FILE* outFile )
+{
+	// Declare all strings up front, so they keep their indexes when assembled again:
+	for( size_t x = 0; x < inScript->numStrings; x++ )
+	{
+		fputs( "string ", outFile );
+		LEODisassemblerWriteString( outFile, inScript->strings[x] );
+		fputc( '\n', outFile );
+	}
+
+	for( size_t x = 0; x < inScript->numCommands; x++ )
+	{
+		fputc( '\n', outFile );
+		LEODisassembleHandler( inScript, inGroup, inScript->commands +x, "command", outFile );
+	}
+	for( size_t x = 0; x < inScript->numFunctions; x++ )
+	{
+		fputc( '\n', outFile );
+		LEODisassembleHandler( inScript, inGroup, inScript->functions +x, "function", outFile );
+	}
+
+	return !ferror( outFile );
+}
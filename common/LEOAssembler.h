@@ -0,0 +1,94 @@
+/*
+ *  LEOAssembler.h
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*!
+	@header LEOAssembler
+	Turns a script into text and back, so bytecode for tests and benchmarks
+	can be written by hand instead of as a series of LEOHandlerAddInstruction()
+	calls, and so the output of LEODisassembleScript() can be edited and run
+	again.
+
+	Each instruction is written like LEODebugPrintInstr() prints it, as the
+	instruction's name from gInstructionNames (so host instructions work as
+	well) followed by its two parameters:
+
+	<pre>
+	// Comments start with two slashes.
+	string "Unused strings can be declared ahead of time"
+
+	command main
+		PushStringFromTable( BACK, "Hello World" );
+		CallHandler( 1, $helper );
+	loop:
+		AddInteger( -1, 1 );
+		JumpRelative( 0, @loop );
+		PushNumber( BACK, 1.5 );
+		ReturnFromHandler( 0, 0 );
+		variable "greeting" "var_greeting" -1
+	end
+
+	function helper
+		ReturnFromHandler( 0, 0 );
+	end
+	</pre>
+
+	Parameters are decimal or 0x-prefixed hexadecimal integers, or:
+	<dl>
+	<dt>BACK</dt><dd>BACK_OF_STACK</dd>
+	<dt>1.5</dt><dd>A number with a decimal point or exponent is turned into
+	a float's bits, as LEOCastUInt32ToLEONumber() expects them.</dd>
+	<dt>"text"</dt><dd>The index of the string in the script's strings table,
+	where it is added if needed. \\ \" \n \r \t and \xHH escapes are supported.</dd>
+	<dt>@label</dt><dd>The number of instructions from this instruction to the
+	one following "label:", as the relative jump instructions expect it.</dd>
+	<dt>$name</dt><dd>The handler ID of the handler of that name.</dd>
+	</dl>
+	"variable" lines add a variable name mapping with the given real name,
+	internal name and basePtr-relative address to the current handler.
+*/
+
+#ifndef LEO_ASSEMBLER_H
+#define LEO_ASSEMBLER_H		1
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOScript.h"
+#include "LEOContextGroup.h"
+#include <stdio.h>
+
+
+// -----------------------------------------------------------------------------
+//	Prototypes:
+// -----------------------------------------------------------------------------
+
+/*!
+	Create a new script from the given assembly text. Handler names are
+	turned into handler IDs of the given context group. The new script has no
+	owner and a reference count of 1.
+	@result The new script, or NULL if the text contained an error, in which
+			case a message describing it (including the line number) has been
+			written to outErrMsg (which is inErrMsgSize bytes large).
+	@seealso //leo_ref/c/func/LEODisassembleScript LEODisassembleScript
+*/
+LEOScript*	LEOAssembleScript( const char* inText, size_t inTextLength, LEOContextGroup* inGroup, char* outErrMsg, size_t inErrMsgSize );
+
+/*!
+	Write the given script to the given file as assembly text that
+	LEOAssembleScript() turns back into the same instructions, strings and
+	variable name mappings. Jumps get labels, and string table indexes,
+	handler IDs and numbers of the built-in instructions that take them are
+	written as strings, handler names and floats.
+	@result TRUE on success, FALSE if writing to the file failed.
+*/
+bool		LEODisassembleScript( LEOScript* inScript, LEOContextGroup* inGroup, FILE* outFile );
+
+
+#endif // LEO_ASSEMBLER_H
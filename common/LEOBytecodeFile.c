@@ -0,0 +1,436 @@
+/*
+ *  LEOBytecodeFile.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOBytecodeFile.h"
+#include "LEOInstructions.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+#define LEOBytecodeFileMagic				"LEOB"
+#define LEOBytecodeFileNamesChunkSize		16
+#define LEOBytecodeFileMaxCount				(1 << 24)	// Anything larger is a damaged file, not a script.
+
+
+// -----------------------------------------------------------------------------
+//	Types:
+// -----------------------------------------------------------------------------
+
+// A table of handler IDs in the order in which they are written to a file:
+typedef struct LEOBytecodeFileHandlerNames
+{
+	size_t			numHandlerIDs;
+	LEOHandlerID*	handlerIDs;
+} LEOBytecodeFileHandlerNames;
+
+
+// State while reading a file, so the read functions can just give back a
+//	number and we only need to check for errors every now and then:
+typedef struct LEOBytecodeFileReader
+{
+	FILE*		file;
+	bool		failed;
+	char*		errMsg;
+	size_t		errMsgSize;
+} LEOBytecodeFileReader;
+
+
+#pragma mark Writing
+
+static void	LEOBytecodeFileWriteUInt8( FILE* outFile, uint8_t inNum )
+{
+	fputc( inNum, outFile );
+}
+
+
+static void	LEOBytecodeFileWriteUInt16( FILE* outFile, uint16_t inNum )
+{
+	uint8_t		bytes[2] = { inNum & 0xff, (inNum >> 8) & 0xff };
+	fwrite( bytes, 1, sizeof(bytes), outFile );
+}
+
+
+static void	LEOBytecodeFileWriteUInt32( FILE* outFile, uint32_t inNum )
+{
+	uint8_t		bytes[4] = { inNum & 0xff, (inNum >> 8) & 0xff, (inNum >> 16) & 0xff, (inNum >> 24) & 0xff };
+	fwrite( bytes, 1, sizeof(bytes), outFile );
+}
+
+
+static void	LEOBytecodeFileWriteString( FILE* outFile, const char* inString, size_t inLength )
+{
+	LEOBytecodeFileWriteUInt32( outFile, (uint32_t) inLength );
+	fwrite( inString, 1, inLength, outFile );
+}
+
+
+static uint32_t	LEOBytecodeFileHandlerNameIndex( LEOBytecodeFileHandlerNames* inNames, LEOHandlerID inHandlerID )
+{
+	for( size_t x = 0; x < inNames->numHandlerIDs; x++ )
+	{
+		if( inNames->handlerIDs[x] == inHandlerID )
+			return (uint32_t) x;
+	}
+
+	if( (inNames->numHandlerIDs % LEOBytecodeFileNamesChunkSize) == 0 )
+		inNames->handlerIDs = realloc( inNames->handlerIDs, sizeof(LEOHandlerID) * (inNames->numHandlerIDs +LEOBytecodeFileNamesChunkSize) );
+	inNames->handlerIDs[inNames->numHandlerIDs] = inHandlerID;
+
+	return (uint32_t) inNames->numHandlerIDs++;
+}
+
+
+static void	LEOBytecodeFileCollectHandlerNames( LEOHandler* inHandlers, size_t inNumHandlers, LEOBytecodeFileHandlerNames* inNames )
+{
+	for( size_t x = 0; x < inNumHandlers; x++ )
+	{
+		LEOBytecodeFileHandlerNameIndex( inNames, inHandlers[x].handlerName );
+		for( size_t y = 0; y < inHandlers[x].numInstructions; y++ )
+		{
+			if( inHandlers[x].instructions[y].instructionID == CALL_HANDLER_INSTR )
+				LEOBytecodeFileHandlerNameIndex( inNames, inHandlers[x].instructions[y].param2 );
+		}
+	}
+}
+
+
+static void	LEOBytecodeFileWriteHandlers( FILE* outFile, uint8_t inKind, LEOHandler* inHandlers, size_t inNumHandlers,
+											LEOBytecodeFileHandlerNames* inNames, uint32_t* inInstructionNameIndexes )
+{
+	for( size_t x = 0; x < inNumHandlers; x++ )
+	{
+		LEOHandler*	currHandler = inHandlers +x;
+		LEOBytecodeFileWriteUInt8( outFile, inKind );
+		LEOBytecodeFileWriteUInt32( outFile, LEOBytecodeFileHandlerNameIndex( inNames, currHandler->handlerName ) );
+
+		LEOBytecodeFileWriteUInt32( outFile, (uint32_t) currHandler->numInstructions );
+		for( size_t y = 0; y < currHandler->numInstructions; y++ )
+		{
+			LEOInstruction*		currInstruction = currHandler->instructions +y;
+			LEOInstructionID	currID = (currInstruction->instructionID < gNumInstructions) ? currInstruction->instructionID : INVALID_INSTR;
+			uint32_t			param2 = currInstruction->param2;
+			if( currID == CALL_HANDLER_INSTR )
+				param2 = LEOBytecodeFileHandlerNameIndex( inNames, param2 );
+			LEOBytecodeFileWriteUInt32( outFile, inInstructionNameIndexes[currID] );
+			LEOBytecodeFileWriteUInt16( outFile, currInstruction->param1 );
+			LEOBytecodeFileWriteUInt32( outFile, param2 );
+		}
+
+		LEOBytecodeFileWriteUInt32( outFile, (uint32_t) currHandler->numVariables );
+		for( size_t y = 0; y < currHandler->numVariables; y++ )
+		{
+			LEOVariableNameMapping*	currVariable = currHandler->varNames +y;
+			LEOBytecodeFileWriteString( outFile, currVariable->variableName, strnlen( currVariable->variableName, DBG_VAR_NAME_SIZE ) );
+			LEOBytecodeFileWriteString( outFile, currVariable->realVariableName, strnlen( currVariable->realVariableName, DBG_VAR_NAME_SIZE ) );
+			LEOBytecodeFileWriteUInt32( outFile, (uint32_t)(int32_t) currVariable->bpRelativeAddress );
+		}
+	}
+}
+
+
+bool	LEOBytecodeFileWriteScript( LEOScript* inScript, LEOContextGroup* inGroup, FILE* outFile )
+{
+	// Give each instruction used by the script a number, in the order they're first used:
+	uint32_t*		instructionNameIndexes = malloc( sizeof(uint32_t) * gNumInstructions );
+	size_t			numInstructionNames = 0;
+	LEOInstructionID*	instructionNames = NULL;
+	for( size_t x = 0; x < gNumInstructions; x++ )
+		instructionNameIndexes[x] = UINT32_MAX;
+	for( size_t pass = 0; pass < 2; pass++ )
+	{
+		LEOHandler*	handlers = (pass == 0) ? inScript->commands : inScript->functions;
+		size_t		numHandlers = (pass == 0) ? inScript->numCommands : inScript->numFunctions;
+		for( size_t x = 0; x < numHandlers; x++ )
+		{
+			for( size_t y = 0; y < handlers[x].numInstructions; y++ )
+			{
+				LEOInstructionID	currID = handlers[x].instructions[y].instructionID;
+				if( currID >= gNumInstructions )
+					currID = INVALID_INSTR;
+				if( instructionNameIndexes[currID] != UINT32_MAX )
+					continue;
+				if( (numInstructionNames % LEOBytecodeFileNamesChunkSize) == 0 )
+					instructionNames = realloc( instructionNames, sizeof(LEOInstructionID) * (numInstructionNames +LEOBytecodeFileNamesChunkSize) );
+				instructionNames[numInstructionNames] = currID;
+				instructionNameIndexes[currID] = (uint32_t) numInstructionNames++;
+			}
+		}
+	}
+
+	LEOBytecodeFileHandlerNames	handlerNames = { 0, NULL };
+	LEOBytecodeFileCollectHandlerNames( inScript->commands, inScript->numCommands, &handlerNames );
+	LEOBytecodeFileCollectHandlerNames( inScript->functions, inScript->numFunctions, &handlerNames );
+
+	fwrite( LEOBytecodeFileMagic, 1, 4, outFile );
+	LEOBytecodeFileWriteUInt32( outFile, LEO_BYTECODE_FILE_VERSION );
+
+	LEOBytecodeFileWriteUInt32( outFile, (uint32_t) numInstructionNames );
+	for( size_t x = 0; x < numInstructionNames; x++ )
+	{
+		const char*	theName = gInstructionNames[instructionNames[x]];
+		LEOBytecodeFileWriteString( outFile, theName, strlen(theName) );
+	}
+
+	LEOBytecodeFileWriteUInt32( outFile, (uint32_t) handlerNames.numHandlerIDs );
+	for( size_t x = 0; x < handlerNames.numHandlerIDs; x++ )
+	{
+		const char*	theName = LEOContextGroupHandlerNameForHandlerID( inGroup, handlerNames.handlerIDs[x] );
+		if( !theName )
+			theName = "";
+		LEOBytecodeFileWriteString( outFile, theName, strlen(theName) );
+	}
+
+	LEOBytecodeFileWriteUInt32( outFile, (uint32_t) inScript->numStrings );
+	for( size_t x = 0; x < inScript->numStrings; x++ )
+		LEOBytecodeFileWriteString( outFile, inScript->strings[x], strlen(inScript->strings[x]) );
+
+	LEOBytecodeFileWriteUInt32( outFile, (uint32_t)(inScript->numCommands +inScript->numFunctions) );
+	LEOBytecodeFileWriteHandlers( outFile, kLEOBytecodeFileCommand, inScript->commands, inScript->numCommands, &handlerNames, instructionNameIndexes );
+	LEOBytecodeFileWriteHandlers( outFile, kLEOBytecodeFileFunction, inScript->functions, inScript->numFunctions, &handlerNames, instructionNameIndexes );
+
+	if( handlerNames.handlerIDs )
+		free( handlerNames.handlerIDs );
+	if( instructionNames )
+		free( instructionNames );
+	free( instructionNameIndexes );
+
+	return !ferror( outFile );
+}
+
+
+#pragma mark -
+#pragma mark Reading
+
+static void	LEOBytecodeFileReaderFail( LEOBytecodeFileReader* inReader, const char* inFormatString, ... )
+{
+	if( inReader->failed )	// Only keep the first error, later ones are usually caused by it.
+		return;
+
+	inReader->failed = true;
+	va_list		varargs;
+	va_start( varargs, inFormatString );
+	vsnprintf( inReader->errMsg, inReader->errMsgSize, inFormatString, varargs );
+	va_end( varargs );
+}
+
+
+static bool	LEOBytecodeFileReadBytes( LEOBytecodeFileReader* inReader, void* outBytes, size_t inNumBytes )
+{
+	if( inReader->failed )
+		return false;
+	if( fread( outBytes, 1, inNumBytes, inReader->file ) != inNumBytes )
+	{
+		LEOBytecodeFileReaderFail( inReader, "Unexpected end of bytecode file." );
+		return false;
+	}
+	return true;
+}
+
+
+static uint8_t	LEOBytecodeFileReadUInt8( LEOBytecodeFileReader* inReader )
+{
+	uint8_t		theNum = 0;
+	LEOBytecodeFileReadBytes( inReader, &theNum, 1 );
+	return theNum;
+}
+
+
+static uint16_t	LEOBytecodeFileReadUInt16( LEOBytecodeFileReader* inReader )
+{
+	uint8_t		bytes[2] = { 0 };
+	LEOBytecodeFileReadBytes( inReader, bytes, sizeof(bytes) );
+	return bytes[0] | (bytes[1] << 8);
+}
+
+
+static uint32_t	LEOBytecodeFileReadUInt32( LEOBytecodeFileReader* inReader )
+{
+	uint8_t		bytes[4] = { 0 };
+	LEOBytecodeFileReadBytes( inReader, bytes, sizeof(bytes) );
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+
+// Read a count and make sure it's not so large that the file must be damaged:
+static uint32_t	LEOBytecodeFileReadCount( LEOBytecodeFileReader* inReader, const char* inWhat )
+{
+	uint32_t	theCount = LEOBytecodeFileReadUInt32( inReader );
+	if( theCount > LEOBytecodeFileMaxCount )
+	{
+		LEOBytecodeFileReaderFail( inReader, "Bytecode file has too many %s (%u).", inWhat, theCount );
+		return 0;
+	}
+	return inReader->failed ? 0 : theCount;
+}
+
+
+// Returns a NUL-terminated copy of the string that the caller must free(), or NULL:
+static char*	LEOBytecodeFileReadString( LEOBytecodeFileReader* inReader )
+{
+	uint32_t	theLength = LEOBytecodeFileReadCount( inReader, "bytes in a string" );
+	if( inReader->failed )
+		return NULL;
+
+	char*		theString = malloc( theLength +1 );
+	if( !LEOBytecodeFileReadBytes( inReader, theString, theLength ) )
+	{
+		free( theString );
+		return NULL;
+	}
+	theString[theLength] = 0;
+
+	return theString;
+}
+
+
+static void	LEOBytecodeFileReadHandler( LEOBytecodeFileReader* inReader, LEOScript* inScript,
+										LEOInstructionID* inInstructionIDs, uint32_t inNumInstructionIDs,
+										LEOHandlerID* inHandlerIDs, uint32_t inNumHandlerIDs )
+{
+	uint8_t		theKind = LEOBytecodeFileReadUInt8( inReader );
+	uint32_t	nameIndex = LEOBytecodeFileReadUInt32( inReader );
+	if( inReader->failed )
+		return;
+	if( theKind != kLEOBytecodeFileCommand && theKind != kLEOBytecodeFileFunction )
+	{
+		LEOBytecodeFileReaderFail( inReader, "Unknown handler kind %u in bytecode file.", theKind );
+		return;
+	}
+	if( nameIndex >= inNumHandlerIDs )
+	{
+		LEOBytecodeFileReaderFail( inReader, "Handler name index %u out of range in bytecode file.", nameIndex );
+		return;
+	}
+
+	LEOHandler*	theHandler = (theKind == kLEOBytecodeFileFunction) ? LEOScriptAddFunctionHandlerWithID( inScript, inHandlerIDs[nameIndex] )
+																		: LEOScriptAddCommandHandlerWithID( inScript, inHandlerIDs[nameIndex] );
+
+	uint32_t	numInstructions = LEOBytecodeFileReadCount( inReader, "instructions" );
+	for( uint32_t x = 0; x < numInstructions && !inReader->failed; x++ )
+	{
+		uint32_t	instructionIndex = LEOBytecodeFileReadUInt32( inReader );
+		uint16_t	param1 = LEOBytecodeFileReadUInt16( inReader );
+		uint32_t	param2 = LEOBytecodeFileReadUInt32( inReader );
+		if( inReader->failed )
+			break;
+		if( instructionIndex >= inNumInstructionIDs )
+		{
+			LEOBytecodeFileReaderFail( inReader, "Instruction name index %u out of range in bytecode file.", instructionIndex );
+			break;
+		}
+
+		LEOInstructionID	theID = inInstructionIDs[instructionIndex];
+		if( theID == CALL_HANDLER_INSTR )
+		{
+			if( param2 >= inNumHandlerIDs )
+			{
+				LEOBytecodeFileReaderFail( inReader, "Called handler name index %u out of range in bytecode file.", param2 );
+				break;
+			}
+			param2 = (uint32_t) inHandlerIDs[param2];
+		}
+		LEOHandlerAddInstruction( theHandler, theID, param1, param2 );
+	}
+
+	uint32_t	numVariables = LEOBytecodeFileReadCount( inReader, "variables" );
+	for( uint32_t x = 0; x < numVariables && !inReader->failed; x++ )
+	{
+		char*		variableName = LEOBytecodeFileReadString( inReader );
+		char*		realVariableName = LEOBytecodeFileReadString( inReader );
+		int32_t		bpRelativeAddress = (int32_t) LEOBytecodeFileReadUInt32( inReader );
+		if( !inReader->failed )
+			LEOHandlerAddVariableNameMapping( theHandler, variableName, realVariableName, bpRelativeAddress );
+		if( variableName )
+			free( variableName );
+		if( realVariableName )
+			free( realVariableName );
+	}
+}
+
+
+LEOScript*	LEOBytecodeFileReadScript( FILE* inFile, LEOContextGroup* inGroup, char* outErrMsg, size_t inErrMsgSize )
+{
+	LEOBytecodeFileReader	reader = { inFile, false, outErrMsg, inErrMsgSize };
+	LEOScript*				theScript = NULL;
+	LEOInstructionID*		instructionIDs = NULL;
+	LEOHandlerID*			handlerIDs = NULL;
+
+	char		magic[4] = { 0 };
+	LEOBytecodeFileReadBytes( &reader, magic, sizeof(magic) );
+	if( !reader.failed && memcmp( magic, LEOBytecodeFileMagic, 4 ) != 0 )
+		LEOBytecodeFileReaderFail( &reader, "Not a Leonie bytecode file." );
+	uint32_t	version = LEOBytecodeFileReadUInt32( &reader );
+	if( !reader.failed && version != LEO_BYTECODE_FILE_VERSION )
+		LEOBytecodeFileReaderFail( &reader, "Unsupported bytecode file version %u.", version );
+
+	// Map instruction names to the instruction IDs in this process:
+	uint32_t	numInstructionIDs = LEOBytecodeFileReadCount( &reader, "instruction names" );
+	instructionIDs = calloc( numInstructionIDs +1, sizeof(LEOInstructionID) );
+	for( uint32_t x = 0; x < numInstructionIDs && !reader.failed; x++ )
+	{
+		char*	theName = LEOBytecodeFileReadString( &reader );
+		if( !theName )
+			break;
+		if( !LEOInstructionIDForName( theName, instructionIDs +x ) )
+			LEOBytecodeFileReaderFail( &reader, "Unknown instruction \"%s\" in bytecode file.", theName );
+		free( theName );
+	}
+
+	// Map handler names to the handler IDs of this context group:
+	uint32_t	numHandlerIDs = LEOBytecodeFileReadCount( &reader, "handler names" );
+	handlerIDs = calloc( numHandlerIDs +1, sizeof(LEOHandlerID) );
+	for( uint32_t x = 0; x < numHandlerIDs && !reader.failed; x++ )
+	{
+		char*	theName = LEOBytecodeFileReadString( &reader );
+		if( !theName )
+			break;
+		handlerIDs[x] = LEOContextGroupHandlerIDForHandlerName( inGroup, theName );
+		free( theName );
+	}
+
+	if( !reader.failed )
+		theScript = LEOScriptCreateForOwner( 0, 0, NULL );
+
+	uint32_t	numStrings = LEOBytecodeFileReadCount( &reader, "strings" );
+	for( uint32_t x = 0; x < numStrings && !reader.failed; x++ )
+	{
+		char*	theString = LEOBytecodeFileReadString( &reader );
+		if( !theString )
+			break;
+		// LEOScriptAddString() re-uses identical strings, which would shift the
+		//	indexes the instructions refer to:
+		if( LEOScriptAddString( theScript, theString ) != x )
+			LEOBytecodeFileReaderFail( &reader, "Duplicate string \"%s\" in bytecode file.", theString );
+		free( theString );
+	}
+
+	uint32_t	numHandlers = LEOBytecodeFileReadCount( &reader, "handlers" );
+	for( uint32_t x = 0; x < numHandlers && !reader.failed; x++ )
+		LEOBytecodeFileReadHandler( &reader, theScript, instructionIDs, numInstructionIDs, handlerIDs, numHandlerIDs );
+
+	free( instructionIDs );
+	free( handlerIDs );
+
+	if( reader.failed && theScript )
+	{
+		LEOScriptRelease( theScript );
+		theScript = NULL;
+	}
+
+	return theScript;
+}
@@ -0,0 +1,100 @@
+/*
+ *  LEOBytecodeFile.h
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*!
+	@header LEOBytecodeFile
+	Saves a LEOScript's handlers and strings to a file and loads them back,
+	so compiled scripts can be run by a program that doesn't know how to
+	compile them, e.g. the leonie-run command line tool.
+
+	Instruction IDs and handler IDs are only valid inside the process (and,
+	for handler IDs, the context group) that created them, so the file
+	stores the names of the instructions and handlers instead and looks them
+	up again when the file is read. Any host instructions a script uses must
+	therefore have been added to the instruction array before reading it.
+
+	All numbers in the file are stored little-endian. The layout is:
+
+	<pre>
+	"LEOB"					magic
+	uint32					version (LEO_BYTECODE_FILE_VERSION)
+	uint32, string...		instruction names
+	uint32, string...		handler names
+	uint32, string...		the script's strings table
+	uint32					number of handlers, each of them:
+		uint8					kLEOBytecodeFileCommand or kLEOBytecodeFileFunction
+		uint32					index into handler names
+		uint32					number of instructions, each of them:
+			uint32					index into instruction names
+			uint16					param1
+			uint32					param2, for CALL_HANDLER_INSTR an index into handler names
+		uint32					number of variables, each of them:
+			string					variableName
+			string					realVariableName
+			int32					bpRelativeAddress
+	</pre>
+
+	where a string is a uint32 byte count followed by that many bytes
+	(without a terminating zero byte).
+*/
+
+#ifndef LEO_BYTECODE_FILE_H
+#define LEO_BYTECODE_FILE_H		1
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOScript.h"
+#include "LEOContextGroup.h"
+#include <stdio.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+/*! The version of the file format LEOBytecodeFileWriteScript() writes. */
+#define LEO_BYTECODE_FILE_VERSION		1
+
+
+/*! Kinds of handlers in a bytecode file. */
+enum
+{
+	kLEOBytecodeFileCommand		= 0,	// The handler is a command handler.
+	kLEOBytecodeFileFunction	= 1		// The handler is a function handler.
+};
+
+
+// -----------------------------------------------------------------------------
+//	Prototypes:
+// -----------------------------------------------------------------------------
+
+/*!
+	Write the given script's handlers and strings to the given file, which
+	must be open for writing in binary mode. inGroup is the context group
+	whose handler IDs the script uses.
+	@result TRUE on success, FALSE if writing to the file failed.
+	@seealso //leo_ref/c/func/LEOBytecodeFileReadScript LEOBytecodeFileReadScript
+*/
+bool		LEOBytecodeFileWriteScript( LEOScript* inScript, LEOContextGroup* inGroup, FILE* outFile );
+
+/*!
+	Read a script written by LEOBytecodeFileWriteScript() from the given file,
+	which must be open for reading in binary mode. The handler names in the
+	file are turned into handler IDs of the given context group. The new
+	script has no owner and a reference count of 1.
+	@result The new script, or NULL if the file couldn't be read, in which
+			case a message describing the problem has been written to
+			outErrMsg (which is inErrMsgSize bytes large).
+*/
+LEOScript*	LEOBytecodeFileReadScript( FILE* inFile, LEOContextGroup* inGroup, char* outErrMsg, size_t inErrMsgSize );
+
+
+#endif // LEO_BYTECODE_FILE_H
@@ -14,6 +14,8 @@
 #include "LEOContextGroup.h"
 #include "LEOHandlerID.h"
 #include "LEOValue.h"
+#include "LEOSlabAllocator.h"
+#include "LEOInterpreter.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -24,6 +26,7 @@
 
 #define LEOReferencesTableChunkSize			16
 #define LEOHandlerNamesChunkSize			16
+#define LEOContextsChunkSize				16
 
 
 
@@ -46,6 +49,7 @@ LEOContextGroup*	LEOContextGroupCreate()
 {
 	LEOContextGroup*	theGroup = calloc( 1, sizeof(LEOContextGroup) );
 	theGroup->referenceCount = 1;
+	theGroup->arrayEntryAllocator = LEOSlabAllocatorCreate();
 	
 	return theGroup;
 }
@@ -69,6 +73,17 @@ void	LEOContextGroupRelease( LEOContextGroup* inGroup )
 			inGroup->references = NULL;
 			inGroup->numReferences = 0;
 		}
+		if( inGroup->arrayEntryAllocator )
+		{
+			LEOSlabAllocatorFreeWhenUnused( inGroup->arrayEntryAllocator );	// Arrays we created may still be in use elsewhere, they free it once they're gone.
+			inGroup->arrayEntryAllocator = NULL;
+		}
+		if( inGroup->contexts )
+		{
+			free( inGroup->contexts );
+			inGroup->contexts = NULL;
+			inGroup->numContexts = 0;
+		}
 		free( inGroup );
 	}
 }
@@ -100,13 +115,14 @@ LEOObjectID	LEOContextGroupCreateNewObjectIDForPointer( LEOContextGroup* inConte
 			size_t		oldNumReferences = inContext->numReferences;
 			inContext->numReferences += LEOReferencesTableChunkSize;
 			inContext->references = realloc( inContext->references, sizeof(struct LEOObject) * inContext->numReferences );
-			memset( inContext->references +(oldNumReferences * sizeof(struct LEOObject)), 0, LEOReferencesTableChunkSize * sizeof(struct LEOObject) );
+			memset( inContext->references +oldNumReferences, 0, LEOReferencesTableChunkSize * sizeof(struct LEOObject) );
 			
 			newObjectID = oldNumReferences;	// Same as index of first new item.
 		}
 	}
 	
 	inContext->references[newObjectID].value = theValue;
+	inContext->statistics.numReferencesCreated ++;
 	
 	return newObjectID;
 }
@@ -122,6 +138,7 @@ void	LEOContextGroupRecycleObjectID( LEOContextGroup* inContext, LEOObjectID inO
 {
 	inContext->references[inObjectID].value = NULL;
 	inContext->references[inObjectID].seed += 1;	// Make sure that if this is reused, whoever still references it knows it's gone.
+	inContext->statistics.numReferencesRecycled ++;
 }
 
 
@@ -189,4 +206,56 @@ const char*		LEOContextGroupHandlerNameForHandlerID( LEOContextGroup* inContext,
 }
 
 
+static void	LEOStatisticsAdd( LEOStatistics* total, const LEOStatistics* inStatistics )
+{
+	total->numInstructions += inStatistics->numInstructions;
+	total->numHandlerCalls += inStatistics->numHandlerCalls;
+	if( inStatistics->maxCallDepth > total->maxCallDepth )
+		total->maxCallDepth = inStatistics->maxCallDepth;
+	if( inStatistics->maxStackDepth > total->maxStackDepth )
+		total->maxStackDepth = inStatistics->maxStackDepth;
+	total->numStringsAllocated += inStatistics->numStringsAllocated;
+	total->numStringBytesAllocated += inStatistics->numStringBytesAllocated;
+	total->numStringBytesFreed += inStatistics->numStringBytesFreed;
+	total->numArrayEntriesAllocated += inStatistics->numArrayEntriesAllocated;
+	total->numArrayEntriesFreed += inStatistics->numArrayEntriesFreed;
+	total->numReferencesCreated += inStatistics->numReferencesCreated;
+	total->numReferencesRecycled += inStatistics->numReferencesRecycled;
+	total->numErrors += inStatistics->numErrors;
+}
+
 
+void	LEOContextGroupAddStatistics( LEOContextGroup* inGroup, const LEOStatistics* inStatistics )
+{
+	LEOStatisticsAdd( &inGroup->statistics, inStatistics );
+}
+
+
+void	LEOContextGroupGetStatistics( LEOContextGroup* inGroup, LEOStatistics* outStatistics )
+{
+	*outStatistics = inGroup->statistics;
+	for( size_t x = 0; x < inGroup->numContexts; x++ )
+		LEOStatisticsAdd( outStatistics, &inGroup->contexts[x]->statistics );
+}
+
+
+void	LEOContextGroupAddContext( LEOContextGroup* inGroup, struct LEOContext* inContext )
+{
+	if( (inGroup->numContexts % LEOContextsChunkSize) == 0 )
+		inGroup->contexts = realloc( inGroup->contexts, sizeof(struct LEOContext*) * (inGroup->numContexts +LEOContextsChunkSize) );
+	inGroup->contexts[inGroup->numContexts++] = inContext;
+}
+
+
+void	LEOContextGroupRemoveContext( LEOContextGroup* inGroup, struct LEOContext* inContext )
+{
+	for( size_t x = 0; x < inGroup->numContexts; x++ )
+	{
+		if( inGroup->contexts[x] == inContext )
+		{
+			inGroup->numContexts--;
+			inGroup->contexts[x] = inGroup->contexts[inGroup->numContexts];	// Order doesn't matter, move last one into the gap.
+			break;
+		}
+	}
+}
@@ -32,6 +32,42 @@
 
 typedef struct LEOObject LEOObject;
 
+struct LEOContext;
+
+
+/*! Counters that show what scripts have been doing. Each LEOContext keeps its
+	own set, which it updates without any locking, and LEOContextGroupGetStatistics()
+	adds them up for all contexts of a group. Counters for resources that
+	belong to the group, like references, are only kept by the group.
+	@field	numInstructions				Number of instructions executed.
+	@field	numHandlerCalls				Number of handlers called.
+	@field	maxCallDepth				Largest number of handlers that were on the call stack at once.
+	@field	maxStackDepth				Largest number of values that were on the stack at once.
+	@field	numStringsAllocated			Number of buffers allocated on the heap for string values.
+	@field	numStringBytesAllocated		Number of bytes allocated on the heap for string values.
+	@field	numStringBytesFreed			Number of bytes of string values given back to the heap.
+	@field	numArrayEntriesAllocated	Number of array entries allocated.
+	@field	numArrayEntriesFreed		Number of array entries given back.
+	@field	numReferencesCreated		Number of object IDs handed out for references.
+	@field	numReferencesRecycled		Number of object IDs given back because the referenced value went away.
+	@field	numErrors					Number of times a script was stopped with an error.
+*/
+typedef struct LEOStatistics
+{
+	size_t		numInstructions;
+	size_t		numHandlerCalls;
+	size_t		maxCallDepth;
+	size_t		maxStackDepth;
+	size_t		numStringsAllocated;
+	size_t		numStringBytesAllocated;
+	size_t		numStringBytesFreed;
+	size_t		numArrayEntriesAllocated;
+	size_t		numArrayEntriesFreed;
+	size_t		numReferencesCreated;
+	size_t		numReferencesRecycled;
+	size_t		numErrors;
+} LEOStatistics;
+
 
 /*! All LEOContexts belong to a Context group that contains references and other
 	global data they share. You can insulate running scripts from each other by
@@ -40,6 +76,10 @@ typedef struct LEOObject LEOObject;
 	@field	globals				An associative array of LEOValues of various kinds representing global variables.
 	@field	numReferences		Number of items in the <tt>references</tt> array.
 	@field	references			An array of "master pointers" to values to which references have been created.
+	@field	arrayEntryAllocator	Allocator the entries of all associative arrays created in this group are taken from. May be NULL, in which case entries are allocated using malloc(). Entries remember the allocator they came from, so it stays around until the last of them has been freed.
+	@field	numContexts			Number of items in the <tt>contexts</tt> array.
+	@field	contexts			The contexts that currently belong to this group, so we can add up their statistics.
+	@field	statistics			Group-wide counters, plus the statistics of contexts that have been reset or cleaned up.
 	@seealso //leo_ref/c/func/LEOContextGroupCreate LEOContextGroupCreate
 */
 typedef struct LEOContextGroup
@@ -50,6 +90,10 @@ typedef struct LEOContextGroup
 	char**					handlerNames;		// Array of handler names. The indexes into this array are 'handler IDs' used throughout the bytecode.
 	size_t					numReferences;		// Available slots in "references" array.
 	LEOObject				*references;		// "Master pointer" table for references so we can detect when a reference goes away.
+	struct LEOSlabAllocator	*arrayEntryAllocator;	// Slabs our array entries are allocated from. NULL to use malloc().
+	size_t					numContexts;		// Number of items in "contexts" array.
+	struct LEOContext		**contexts;			// Contexts currently belonging to this group.
+	LEOStatistics			statistics;			// Counters of the group itself and of contexts that are gone.
 } LEOContextGroup;
 
 
@@ -142,6 +186,35 @@ LEOHandlerID	LEOContextGroupHandlerIDForHandlerName( LEOContextGroup* inContext,
 const char*		LEOContextGroupHandlerNameForHandlerID( LEOContextGroup* inContext, LEOHandlerID inHandlerID );
 
 
+/*!
+	Add up the statistics of all contexts in this group, including those that
+	have already been cleaned up, and the group's own counters. The counters
+	of contexts running on other threads are read without locking, so they may
+	be slightly out of date.
+	@seealso //leo_ref/c/func/LEOContextGetStatistics LEOContextGetStatistics
+*/
+void	LEOContextGroupGetStatistics( LEOContextGroup* inGroup, LEOStatistics* outStatistics );
+
+/*!
+	Add the given counters to the group's statistics. Used by LEOResetContext()
+	and LEOCleanUpContext() to keep a context's counters before they're cleared.
+*/
+void	LEOContextGroupAddStatistics( LEOContextGroup* inGroup, const LEOStatistics* inStatistics );
+
+/*!
+	Remember that the given context belongs to this group, so its statistics
+	are included in LEOContextGroupGetStatistics(). LEOInitContext() calls this
+	for you.
+	@seealso //leo_ref/c/func/LEOContextGroupRemoveContext LEOContextGroupRemoveContext
+*/
+void	LEOContextGroupAddContext( LEOContextGroup* inGroup, struct LEOContext* inContext );
+
+/*!
+	Forget the given context again. LEOCleanUpContext() calls this for you.
+*/
+void	LEOContextGroupRemoveContext( LEOContextGroup* inGroup, struct LEOContext* inContext );
+
+
 
 
 #endif // LEO_CONTEXT_GROUP_H
@@ -0,0 +1,129 @@
+/*
+ *  LEOContextPool.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOContextPool.h"
+#include "LEOContextGroup.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+#define LEOContextPoolChunkSize			16
+
+
+
+static void	LEOContextPoolAddFreeContext( LEOContextPool* inPool, LEOContext* inContext )
+{
+	if( inPool->numFreeContexts >= inPool->numFreeSlots )
+	{
+		size_t	numSlots = inPool->numFreeSlots +LEOContextPoolChunkSize;
+		inPool->freeContexts = realloc( inPool->freeContexts, sizeof(LEOContext*) * numSlots );
+		inPool->numFreeSlots = numSlots;
+	}
+
+	inPool->freeContexts[inPool->numFreeContexts++] = inContext;
+}
+
+
+static LEOContext*	LEOContextPoolCreateContext( LEOContextPool* inPool )
+{
+	LEOContext*		theContext = malloc( sizeof(LEOContext) );
+	LEOInitContext( theContext, inPool->group );
+	inPool->statistics.numContextsCreated ++;
+
+	return theContext;
+}
+
+
+LEOContextPool*	LEOContextPoolCreate( struct LEOContextGroup* inGroup, size_t inNumPreallocatedContexts )
+{
+	LEOContextPool*		thePool = calloc( 1, sizeof(LEOContextPool) );
+	thePool->referenceCount = 1;
+	thePool->group = LEOContextGroupRetain( inGroup );
+
+	for( size_t x = 0; x < inNumPreallocatedContexts; x++ )
+		LEOContextPoolAddFreeContext( thePool, LEOContextPoolCreateContext( thePool ) );
+
+	return thePool;
+}
+
+
+LEOContextPool*	LEOContextPoolRetain( LEOContextPool* inPool )
+{
+	inPool->referenceCount ++;
+	return inPool;
+}
+
+
+void	LEOContextPoolRelease( LEOContextPool* inPool )
+{
+	inPool->referenceCount --;
+	if( inPool->referenceCount == 0 )
+	{
+		for( size_t x = 0; x < inPool->numFreeContexts; x++ )
+		{
+			LEOCleanUpContext( inPool->freeContexts[x] );
+			free( inPool->freeContexts[x] );
+		}
+		if( inPool->freeContexts )
+		{
+			free( inPool->freeContexts );
+			inPool->freeContexts = NULL;
+			inPool->numFreeContexts = 0;
+			inPool->numFreeSlots = 0;
+		}
+		LEOContextGroupRelease( inPool->group );
+		inPool->group = NULL;
+		free( inPool );
+	}
+}
+
+
+LEOContext*	LEOContextPoolAcquireContext( LEOContextPool* inPool )
+{
+	LEOContext*		theContext = NULL;
+
+	if( inPool->numFreeContexts > 0 )
+	{
+		theContext = inPool->freeContexts[--inPool->numFreeContexts];
+		inPool->statistics.numContextsReused ++;
+	}
+	else
+		theContext = LEOContextPoolCreateContext( inPool );
+
+	inPool->statistics.numContextsAcquired ++;
+	inPool->statistics.numContextsInUse ++;
+	if( inPool->statistics.numContextsInUse > inPool->statistics.maxContextsInUse )
+		inPool->statistics.maxContextsInUse = inPool->statistics.numContextsInUse;
+
+	return theContext;
+}
+
+
+void	LEOContextPoolReturnContext( LEOContextPool* inPool, LEOContext* inContext )
+{
+	LEOResetContext( inContext );
+	LEOContextPoolAddFreeContext( inPool, inContext );
+
+	inPool->statistics.numContextsReturned ++;
+	inPool->statistics.numContextsInUse --;
+}
+
+
+void	LEOContextPoolGetStatistics( LEOContextPool* inPool, LEOContextPoolStatistics* outStatistics )
+{
+	*outStatistics = inPool->statistics;
+}
@@ -0,0 +1,130 @@
+/*
+ *  LEOContextPool.h
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*!
+	@header LEOContextPool
+	A context pool keeps around LEOContexts that have finished running, so
+	hosts that run many short scripts (e.g. one per incoming event) don't
+	have to pay for LEOInitContext() and LEOCleanUpContext() each time.
+
+	Acquire a context from the pool, run your bytecode in it as usual, then
+	hand it back to the pool instead of calling LEOCleanUpContext(). The pool
+	resets the context using LEOResetContext(), which only touches the part
+	of the stack that was actually used.
+
+	A context pool is not thread safe. Use one pool per thread, or protect
+	it with your own lock.
+*/
+
+#ifndef LEO_CONTEXT_POOL_H
+#define LEO_CONTEXT_POOL_H		1
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOInterpreter.h"
+
+
+// -----------------------------------------------------------------------------
+//	Types:
+// -----------------------------------------------------------------------------
+
+/*! Statistics about how well a LEOContextPool has been reused.
+	@field	numContextsCreated		Number of contexts the pool had to allocate and initialize.
+	@field	numContextsAcquired		Number of times a context was handed out by the pool.
+	@field	numContextsReused		Number of times a context was handed out without having to create a new one.
+	@field	numContextsReturned		Number of times a context was given back to the pool.
+	@field	numContextsInUse		Number of contexts currently handed out and not returned yet.
+	@field	maxContextsInUse		Highest value numContextsInUse has ever had.
+*/
+typedef struct LEOContextPoolStatistics
+{
+	size_t		numContextsCreated;
+	size_t		numContextsAcquired;
+	size_t		numContextsReused;
+	size_t		numContextsReturned;
+	size_t		numContextsInUse;
+	size_t		maxContextsInUse;
+} LEOContextPoolStatistics;
+
+
+/*! A pool of LEOContexts that all belong to the same LEOContextGroup.
+	@field	referenceCount		Reference count for this object.
+	@field	group				The context group all contexts in this pool belong to.
+	@field	numFreeContexts		Number of contexts in freeContexts.
+	@field	numFreeSlots		Number of slots allocated for freeContexts.
+	@field	freeContexts		Contexts that are ready to be handed out again.
+	@field	statistics			Counters describing the reuse of contexts.
+	@seealso //leo_ref/c/func/LEOContextPoolCreate LEOContextPoolCreate
+*/
+typedef struct LEOContextPool
+{
+	size_t						referenceCount;		// Reference count for this object.
+	struct LEOContextGroup		*group;				// Group all our contexts belong to. Retained.
+	size_t						numFreeContexts;	// Number of contexts in freeContexts.
+	size_t						numFreeSlots;		// Number of slots allocated for freeContexts.
+	LEOContext					**freeContexts;		// Contexts ready to be handed out again.
+	LEOContextPoolStatistics	statistics;			// Counters describing the reuse of contexts.
+} LEOContextPool;
+
+
+// -----------------------------------------------------------------------------
+//	Prototypes:
+// -----------------------------------------------------------------------------
+
+/*!
+	Create a context pool whose contexts all belong to the given context group.
+	The pool retains the group. inNumPreallocatedContexts contexts are created
+	and initialized right away, so the first acquisitions are already cheap.
+	The LEOContextPool* is reference-counted and its reference count is set to 1.
+	@seealso //leo_ref/c/func/LEOContextPoolRelease LEOContextPoolRelease
+*/
+LEOContextPool*		LEOContextPoolCreate( struct LEOContextGroup* inGroup, size_t inNumPreallocatedContexts );	// Gives referenceCount of 1.
+
+/*!
+	Acquire ownership of the given context pool. Increases the reference count by 1.
+	@result Returns inPool.
+	@seealso //leo_ref/c/func/LEOContextPoolRelease LEOContextPoolRelease
+*/
+LEOContextPool*		LEOContextPoolRetain( LEOContextPool* inPool );		// Adds 1 to referenceCount. Returns inPool.
+
+/*!
+	Give up ownership of the given context pool. When the reference count
+	reaches 0, all contexts in the pool are cleaned up and freed. Contexts
+	that are still handed out at that point are not affected, you will have
+	to call LEOCleanUpContext() and free() on those yourself.
+	@seealso //leo_ref/c/func/LEOContextPoolRetain LEOContextPoolRetain
+*/
+void				LEOContextPoolRelease( LEOContextPool* inPool );	// Subtracts 1 from referenceCount. If it hits 0, disposes of inPool.
+
+/*!
+	Hand out a context that is ready to run bytecode, as if it had just been
+	initialized using LEOInitContext(). Give it back to the pool using
+	LEOContextPoolReturnContext() once you're done with it.
+	@seealso //leo_ref/c/func/LEOContextPoolReturnContext LEOContextPoolReturnContext
+*/
+LEOContext*			LEOContextPoolAcquireContext( LEOContextPool* inPool );
+
+/*!
+	Give back a context obtained from LEOContextPoolAcquireContext(). The
+	context is reset and kept for the next caller, so you must not use it
+	anymore after this call.
+	@seealso //leo_ref/c/func/LEOContextPoolAcquireContext LEOContextPoolAcquireContext
+	@seealso //leo_ref/c/func/LEOResetContext LEOResetContext
+*/
+void				LEOContextPoolReturnContext( LEOContextPool* inPool, LEOContext* inContext );
+
+/*!
+	Copy the reuse statistics of the given pool into outStatistics.
+*/
+void				LEOContextPoolGetStatistics( LEOContextPool* inPool, LEOContextPoolStatistics* outStatistics );
+
+
+#endif // LEO_CONTEXT_POOL_H
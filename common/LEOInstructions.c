@@ -78,7 +78,7 @@ void	LEOPushStringFromTableInstruction( LEOContext* inContext )
 	if( inContext->currentInstruction->param2 < script->numStrings )
 		theString = script->strings[inContext->currentInstruction->param2];
 	
-	LEOInitStringValue( (LEOValuePtr) inContext->stackEndPtr, theString, strlen(theString), kLEOInvalidateReferences, inContext );
+	LEOInitTransientStringValue( (LEOValuePtr) inContext->stackEndPtr, theString, strlen(theString), kLEOInvalidateReferences, inContext );
 	inContext->stackEndPtr++;
 	
 	inContext->currentInstruction++;
@@ -605,15 +605,19 @@ void	LEOPushChunkInstruction( LEOContext* inContext )
 	if( !inContext->keepRunning )
 		return;
 	
-	char	str[1024] = { 0 };
-	LEOGetValueAsString( chunkTarget, str, sizeof(str), inContext );
+	char		tempStr[1024] = { 0 };
+	const char*	str = LEOGetValueAsString( chunkTarget, NULL, 0, inContext );	// Strings and arrays give us their whole text.
+	if( !str )
+		str = LEOGetValueAsString( chunkTarget, tempStr, sizeof(tempStr), inContext );
 	
 	LEOCleanUpStackToPtr( inContext, inContext->stackEndPtr -2 );
 	
-	size_t	startDelOffs = 0, endDelOffs = 0;
+	size_t			startDelOffs = 0, endDelOffs = 0;
+	union LEOValue	resultValue;
 	LEOGetChunkRanges( str, inContext->currentInstruction->param2, chunkStartOffs, chunkEndOffs, &chunkStartOffs, &chunkEndOffs, &startDelOffs, &endDelOffs, inContext->itemDelimiter );
+	LEOInitTransientStringValue( &resultValue, str +chunkStartOffs, chunkEndOffs -chunkStartOffs, kLEOInvalidateReferences, inContext );	// Before cleaning up, str may belong to the chunk target.
 	LEOCleanUpValue( inContext->stackEndPtr -1, kLEOInvalidateReferences, inContext );
-	LEOInitStringValue( inContext->stackEndPtr -1, str +chunkStartOffs, chunkEndOffs -chunkStartOffs, kLEOInvalidateReferences, inContext );
+	inContext->stackEndPtr[-1] = resultValue;	// Nobody can have a reference to resultValue yet, so we can just move it.
 	
 	inContext->currentInstruction++;
 }
@@ -721,33 +725,36 @@ void	LEOConcatenateValuesInstruction( LEOContext* inContext )
 	size_t			startOffs = 0, endOffs = SIZE_MAX,
 					startDelOffs, endDelOffs;
 	uint32_t		delimChar = inContext->currentInstruction->param2;
-	char			tempStr[1024] = { 0 };	// TODO: Make this work with any length of string.
+	char			delimStr[8] = { 0 };
+	char			tempStr[1024] = { 0 };
 	char			tempStr2[1024] = { 0 };
-	size_t			offs = 0;
 	union LEOValue	resultValue;
 	
-	if( delimChar != 0 )
-	{
-		tempStr[0] = delimChar;		// TODO: Make this work with any Unicode character.
-		offs = 1;
-	}
+	delimStr[0] = delimChar;		// TODO: Make this work with any Unicode character.
 	
-	LEOGetValueAsString( secondArgumentValue, tempStr +offs, sizeof(tempStr) -offs, inContext );
+	const char*	secondArgumentString = LEOGetValueAsString( secondArgumentValue, NULL, 0, inContext );	// Strings and arrays give us their whole text.
+	if( !secondArgumentString )
+		secondArgumentString = LEOGetValueAsString( secondArgumentValue, tempStr, sizeof(tempStr), inContext );
 	char*		firstArgumentString = LEOGetValueAsString( firstArgumentValue, NULL, 0, inContext );
 	if( !firstArgumentString )
 		firstArgumentString = LEOGetValueAsString( firstArgumentValue, tempStr2, sizeof(tempStr2), inContext );
-	LEOInitStringValue( &resultValue, firstArgumentString, strlen(firstArgumentString), kLEOInvalidateReferences, inContext );
+	LEOInitTransientStringValue( &resultValue, firstArgumentString, strlen(firstArgumentString), kLEOInvalidateReferences, inContext );
 	
 	LEODetermineChunkRangeOfSubstring(	&resultValue, &startOffs, &endOffs,
 										&startDelOffs, &endDelOffs,
 										kLEOChunkTypeCharacter,
 										SIZE_MAX, SIZE_MAX, inContext );
-	LEOSetValuePredeterminedRangeAsString( &resultValue, endOffs, endOffs, tempStr, inContext );
+	if( delimStr[0] != 0 )
+	{
+		LEOSetValuePredeterminedRangeAsString( &resultValue, endOffs, endOffs, delimStr, inContext );
+		endOffs += strlen(delimStr);
+	}
+	LEOSetValuePredeterminedRangeAsString( &resultValue, endOffs, endOffs, secondArgumentString, inContext );
 	
 	LEOCleanUpStackToPtr( inContext, inContext->stackEndPtr -2 );
 	
-	LEOPushValueOnStack( inContext, &resultValue );
-	LEOCleanUpValue( &resultValue, kLEOInvalidateReferences, inContext );
+	*inContext->stackEndPtr = resultValue;	// Nobody can have a reference to resultValue yet, so we can just move it onto the stack instead of copying.
+	inContext->stackEndPtr++;
 	
 	inContext->currentInstruction++;
 }
@@ -760,33 +767,39 @@ void	LEOConcatenateValuesWithSpaceInstruction( LEOContext* inContext )
 	size_t			startOffs = 0, endOffs = SIZE_MAX,
 					startDelOffs, endDelOffs;
 	uint32_t		delimChar = inContext->currentInstruction->param2;
-	char			tempStr[1024] = { 0 };	// TODO: Make this work with any length of string.
+	char			delimStr[8] = { 0 };
+	char			tempStr[1024] = { 0 };
 	char			tempStr2[1024] = { 0 };
-	size_t			offs = 0;
 	union LEOValue	resultValue;
 	
 	if( delimChar == 0 )
 		delimChar = ' ';
 
-	tempStr[0] = delimChar;		// TODO: Make this work with any Unicode character.
-	offs = 1;
+	delimStr[0] = delimChar;		// TODO: Make this work with any Unicode character.
 	
-	LEOGetValueAsString( secondArgumentValue, tempStr +offs, sizeof(tempStr) -offs, inContext );
+	const char*	secondArgumentString = LEOGetValueAsString( secondArgumentValue, NULL, 0, inContext );	// Strings and arrays give us their whole text.
+	if( !secondArgumentString )
+		secondArgumentString = LEOGetValueAsString( secondArgumentValue, tempStr, sizeof(tempStr), inContext );
 	char*		firstArgumentString = LEOGetValueAsString( firstArgumentValue, NULL, 0, inContext );
 	if( !firstArgumentString )
 		firstArgumentString = LEOGetValueAsString( firstArgumentValue, tempStr2, sizeof(tempStr2), inContext );
-	LEOInitStringValue( &resultValue, firstArgumentString, strlen(firstArgumentString), kLEOInvalidateReferences, inContext );
+	LEOInitTransientStringValue( &resultValue, firstArgumentString, strlen(firstArgumentString), kLEOInvalidateReferences, inContext );
 		
 	LEODetermineChunkRangeOfSubstring(	&resultValue, &startOffs, &endOffs,
 										&startDelOffs, &endDelOffs,
 										kLEOChunkTypeCharacter,
 										SIZE_MAX, SIZE_MAX, inContext );
-	LEOSetValuePredeterminedRangeAsString( &resultValue, endOffs, endOffs, tempStr, inContext );
+	if( delimStr[0] != 0 )
+	{
+		LEOSetValuePredeterminedRangeAsString( &resultValue, endOffs, endOffs, delimStr, inContext );
+		endOffs += strlen(delimStr);
+	}
+	LEOSetValuePredeterminedRangeAsString( &resultValue, endOffs, endOffs, secondArgumentString, inContext );
 	
 	LEOCleanUpStackToPtr( inContext, inContext->stackEndPtr -2 );
 	
-	LEOPushValueOnStack( inContext, &resultValue );
-	LEOCleanUpValue( &resultValue, kLEOInvalidateReferences, inContext );
+	*inContext->stackEndPtr = resultValue;	// Nobody can have a reference to resultValue yet, so we can just move it onto the stack instead of copying.
+	inContext->stackEndPtr++;
 	
 	inContext->currentInstruction++;
 }
@@ -1262,7 +1275,7 @@ void	LEOLineMarkerInstruction( LEOContext* inContext )
 
 struct LEOAssignChunkArrayUserData
 {
-	struct LEOArrayEntry *	array;
+	struct LEODenseArray *	array;
 	size_t					numItems;
 	struct LEOContext	*	context;
 };
@@ -1271,18 +1284,15 @@ struct LEOAssignChunkArrayUserData
 static bool LEOAssignChunkArrayChunkCallback( const char *currStr, size_t currLen, size_t currStart, size_t currEnd, void *userData )
 {
 	struct LEOAssignChunkArrayUserData	*	ud = (struct LEOAssignChunkArrayUserData *) userData;
-	char									keyString[20] = { 0 };
-	snprintf( keyString, sizeof(keyString) -1, "%lu", ++ud->numItems );
-	
-	union LEOValue		tempStringValue = { 0 };
-	LEOInitStringValue( &tempStringValue, currStr, currLen, kLEOInvalidateReferences, ud->context );
-	LEOAddArrayEntryToRoot( &ud->array, keyString, &tempStringValue, ud->context );
-	LEOCleanUpValue( &tempStringValue, kLEOInvalidateReferences, ud->context );
+	LEOInitStringValue( ud->array->items +(ud->numItems++), currStr, currLen, kLEOInvalidateReferences, ud->context );
 	
 	return true;
 }
 
 
+static bool LEOCountChunksChunkCallback( const char *currStr, size_t currLen, size_t currStart, size_t currEnd, void *userData );
+
+
 /*!
 	@function LEOAssignChunkArrayInstruction
 	Build an array containing each chunk item (i.e. item, line or word) in a
@@ -1300,18 +1310,26 @@ void	LEOAssignChunkArrayInstruction( LEOContext* inContext )
 	union LEOValue	*		srcValue = inContext->stackEndPtr -1;
 	struct LEOAssignChunkArrayUserData	userData = { 0 };
 	userData.context = inContext;
-	char					tempStr[1024] = { 0 };	// TODO: Make this work with any length of string.
+	char					tempStr[1024] = { 0 };
 	
-	LEOGetValueAsString( srcValue, tempStr, sizeof(tempStr), inContext );
-	LEOCleanUpStackToPtr( inContext, srcValue );	// Pop srcValue off the stack.
+	// Keys are always "1" through "N", so we can keep the items in one block:
+	const char*		srcStr = LEOGetValueAsString( srcValue, NULL, 0, inContext );	// Strings give us their own buffer without copying.
+	if( !srcStr )	// Numbers and the like need a buffer to be written to.
+		srcStr = LEOGetValueAsString( srcValue, tempStr, sizeof(tempStr), inContext );
+	size_t			srcLen = strlen(srcStr);
+	size_t			numItems = 0;
+	LEODoForEachChunk( srcStr, srcLen, inContext->currentInstruction->param2, LEOCountChunksChunkCallback, inContext->itemDelimiter, &numItems );
+	userData.array = LEOCreateDenseArray( numItems, inContext );
+	LEODoForEachChunk( srcStr, srcLen, inContext->currentInstruction->param2, LEOAssignChunkArrayChunkCallback, inContext->itemDelimiter, &userData );
+	
+	LEOCleanUpStackToPtr( inContext, srcValue );	// Pop srcValue off the stack. *** srcStr may be gone after this.
 	
 	bool			onStack = (inContext->currentInstruction->param1 == BACK_OF_STACK);
 	LEOValuePtr		dstValue = onStack ? (inContext->stackEndPtr++) : (inContext->stackBasePtr +(*(int16_t*)&inContext->currentInstruction->param1));
 	if( !onStack )
 		LEOCleanUpValue( dstValue, kLEOKeepReferences, inContext );
 	
-	LEODoForEachChunk( tempStr, strlen(tempStr), inContext->currentInstruction->param2, LEOAssignChunkArrayChunkCallback, inContext->itemDelimiter, &userData );
-	LEOInitArrayValue( dstValue, userData.array, kLEOKeepReferences, inContext );
+	LEOInitDenseArrayValue( dstValue, userData.array, kLEOKeepReferences, inContext );
 
 	inContext->currentInstruction++;
 }
@@ -1367,12 +1385,12 @@ void	LEOCountChunksInstruction( LEOContext* inContext )
 
 void	LEOGetArrayItemInstruction( LEOContext* inContext )
 {
+	union LEOValue	*		keyValue = inContext->stackEndPtr -2;
+	union LEOValue	*		srcValue = inContext->stackEndPtr -1;
 	bool					onStack = (inContext->currentInstruction->param1 == BACK_OF_STACK);
 	LEOValuePtr				dstValue = onStack ? (inContext->stackEndPtr++) : (inContext->stackBasePtr +(*(int16_t*)&inContext->currentInstruction->param1));
 	if( !onStack )
 		LEOCleanUpValue( dstValue, kLEOKeepReferences, inContext );
-	union LEOValue	*		keyValue = inContext->stackEndPtr -2;
-	union LEOValue	*		srcValue = inContext->stackEndPtr -1;
 	
 	char					keyStr[1024] = { 0 };	// TODO: Make this work with any length of string.
 	
@@ -1398,11 +1416,11 @@ void	LEOGetArrayItemInstruction( LEOContext* inContext )
 
 void	LEOGetArrayItemCountInstruction( LEOContext* inContext )
 {
+	union LEOValue	*		srcValue = inContext->stackEndPtr -1;
 	bool					onStack = (inContext->currentInstruction->param1 == BACK_OF_STACK);
 	LEOValuePtr				dstValue = onStack ? (inContext->stackEndPtr++) : (inContext->stackBasePtr +(*(int16_t*)&inContext->currentInstruction->param1));
 	if( !onStack )
 		LEOCleanUpValue( dstValue, kLEOKeepReferences, inContext );
-	union LEOValue	*		srcValue = inContext->stackEndPtr -1;
 	
 	size_t	numKeys = LEOGetKeyCount( srcValue, inContext );
 	LEOInitIntegerValue( dstValue, numKeys, (onStack ? kLEOInvalidateReferences : kLEOKeepReferences), inContext );
@@ -1419,9 +1437,11 @@ void	LEOGetArrayItemCountInstruction( LEOContext* inContext )
 void	LEOSetStringInstruction( LEOContext* inContext )
 {
 	bool			onStack = (inContext->currentInstruction->param1 == BACK_OF_STACK);
-	union LEOValue*	destValue = onStack ? (inContext->stackEndPtr -2) : inContext->stackBasePtr +inContext->currentInstruction->param1;
-	char			str[1024] = { 0 };
-	LEOGetValueAsString( inContext->stackEndPtr -1, str, sizeof(str), inContext );
+	union LEOValue*	destValue = onStack ? (inContext->stackEndPtr -2) : (inContext->stackBasePtr +(*(int16_t*)&inContext->currentInstruction->param1));
+	char			tempStr[1024] = { 0 };
+	const char*		str = LEOGetValueAsString( inContext->stackEndPtr -1, NULL, 0, inContext );	// Strings and arrays give us their whole text.
+	if( !str )
+		str = LEOGetValueAsString( inContext->stackEndPtr -1, tempStr, sizeof(tempStr), inContext );
 	LEOSetValueAsString( destValue, str, inContext );
 	LEOCleanUpStackToPtr( inContext, inContext->stackEndPtr +(onStack ? -2 : -1) );
 	
@@ -1495,7 +1515,7 @@ void	LEONumToCharInstruction( LEOContext* inContext )
 	char	utf8CharStr[9] = { 0 };
 	size_t	theLength = sizeof(utf8CharStr);
 	UTF8BytesForUTF32Character( utf32Char, utf8CharStr, &theLength );
-	LEOInitStringValue( inContext->stackEndPtr -1, utf8CharStr, theLength,
+	LEOInitTransientStringValue( inContext->stackEndPtr -1, utf8CharStr, theLength,
 						kLEOInvalidateReferences, inContext );
 	
 	inContext->currentInstruction++;
@@ -1528,7 +1548,7 @@ void	LEONumToHexInstruction( LEOContext* inContext )
 	
 	char	hexStr[16] = { 0 };
 	snprintf( hexStr, sizeof(hexStr), "%lx", theNumber );
-	LEOInitStringValue( inContext->stackEndPtr -1, hexStr, strlen(hexStr),
+	LEOInitTransientStringValue( inContext->stackEndPtr -1, hexStr, strlen(hexStr),
 						kLEOInvalidateReferences, inContext );
 	
 	inContext->currentInstruction++;
@@ -1743,3 +1763,18 @@ void	LEOAddInstructionsToInstructionArray( LEOInstructionFuncPtr *inInstructionA
 		gNumInstructions += inNumInstructions;
 	}
 }
+
+
+bool	LEOInstructionIDForName( const char* inName, LEOInstructionID *outID )
+{
+	for( size_t x = 0; x < gNumInstructions; x++ )
+	{
+		if( gInstructionNames[x] && strcmp( gInstructionNames[x], inName ) == 0 )
+		{
+			*outID = (LEOInstructionID) x;
+			return true;
+		}
+	}
+	
+	return false;
+}
@@ -15,6 +15,9 @@
 #include "LEOInstructions.h"
 #include "LEOContextGroup.h"
 #include "LEOScript.h"
+#include "LEOArena.h"
+#include "LEOTrace.h"
+#include "LEOProfiler.h"
 #include <sys/types.h>
 #include <stdlib.h>
 #include <string.h>
@@ -37,6 +40,15 @@ void	LEODoNothingPreInstructionProc( LEOContext* inContext )
 }
 
 
+// A verified handler may skip the per-instruction checks if all the values
+//	it pushes fit on the stack above the given base pointer:
+static bool	LEOCanRunHandlerUnchecked( LEOContext* inContext, LEOHandler* inHandler, LEOValuePtr inBasePtr )
+{
+	return inHandler && inHandler->verified
+			&& (size_t)((inContext->stack +LEO_STACK_SIZE) -inBasePtr) >= inHandler->maxStackDepth;
+}
+
+
 void	LEOInitContext( LEOContext* theContext, struct LEOContextGroup* inGroup )
 {
 	memset( theContext, 0, sizeof(LEOContext) );
@@ -45,12 +57,19 @@ void	LEOInitContext( LEOContext* theContext, struct LEOContextGroup* inGroup )
 	theContext->itemDelimiter = ',';
 	theContext->group = LEOContextGroupRetain( inGroup );
 	theContext->keepRunning = true;
+	LEOContextGroupAddContext( inGroup, theContext );
 }
 
 
 void	LEOCleanUpContext( LEOContext* theContext )
 {
+	if( theContext->profiler )
+		LEOProfilerDetachFromContext( theContext->profiler );
+	if( theContext->traceBuffer )	// Do this while the group is still around to look up handler names in.
+		LEOTraceSessionDetachFromContext( theContext );
 	LEOCleanUpStackToPtr( theContext, theContext->stack );
+	LEOContextGroupAddStatistics( theContext->group, &theContext->statistics );
+	LEOContextGroupRemoveContext( theContext->group, theContext );
 	LEOContextGroupRelease( theContext->group );
 	theContext->group = NULL;
 	if( theContext->callStackEntries )
@@ -66,6 +85,65 @@ void	LEOCleanUpContext( LEOContext* theContext )
 		theContext->callStackEntries = NULL;
 		theContext->numCallStackEntries = 0;
 	}
+	if( theContext->arena )
+	{
+		LEOArenaFree( theContext->arena );
+		theContext->arena = NULL;
+	}
+}
+
+
+void	LEOContextSetArenaSize( LEOContext* theContext, size_t inSize )
+{
+	if( theContext->arena )
+	{
+		LEOArenaFree( theContext->arena );
+		theContext->arena = NULL;
+	}
+	if( inSize > 0 )
+		theContext->arena = LEOArenaCreate( inSize );
+}
+
+
+void	LEOContextGetStatistics( LEOContext* theContext, LEOStatistics* outStatistics )
+{
+	*outStatistics = theContext->statistics;
+}
+
+
+void	LEOResetContext( LEOContext* theContext )
+{
+	if( theContext->profiler )	// Whoever attached a profiler or trace session may free it once they're done with the context.
+		LEOProfilerDetachFromContext( theContext->profiler );
+	if( theContext->traceBuffer )
+		LEOTraceSessionDetachFromContext( theContext );
+	if( theContext->stackEndPtr )
+		LEOCleanUpStackToPtr( theContext, theContext->stack );
+	
+	// Keep the callStackEntries block around, we'll just overwrite the entries:
+	for( size_t x = 0; x < theContext->numCallStackEntries; x++ )
+	{
+		LEOScriptRelease( theContext->callStackEntries[x].script );
+		theContext->callStackEntries[x].script = NULL;
+		theContext->callStackEntries[x].handler = NULL;	// Script owns handlers, so this is invalid now, too.
+	}
+	theContext->numCallStackEntries = 0;
+	
+	if( theContext->arena )
+		LEOArenaRewind( theContext->arena );
+	
+	theContext->keepRunning = true;
+	theContext->errMsg[0] = 0;
+	theContext->itemDelimiter = ',';
+	theContext->preInstructionProc = LEODoNothingPreInstructionProc;
+	theContext->promptProc = LEODoNothingPreInstructionProc;
+	theContext->numSteps = 0;
+	LEOContextGroupAddStatistics( theContext->group, &theContext->statistics );
+	memset( &theContext->statistics, 0, sizeof(theContext->statistics) );
+	theContext->runUnchecked = false;
+	theContext->currentInstruction = NULL;
+	theContext->stackBasePtr = NULL;
+	theContext->stackEndPtr = theContext->stack;
 }
 
 
@@ -94,6 +172,18 @@ void	LEOContextPushHandlerScriptReturnAddressAndBasePtr( LEOContext* inContext,
 	inContext->callStackEntries[newEntryIndex].script = LEOScriptRetain( inScript );
 	inContext->callStackEntries[newEntryIndex].returnAddress = returnAddress;
 	inContext->callStackEntries[newEntryIndex].oldBasePtr = oldBP;
+	
+	LEOValuePtr	stackEndPtr = inContext->stackEndPtr ? inContext->stackEndPtr : inContext->stack;
+	inContext->callStackEntries[newEntryIndex].callerStackEndPtr = stackEndPtr;
+	inContext->callStackEntries[newEntryIndex].runUnchecked = LEOCanRunHandlerUnchecked( inContext, inHandler, stackEndPtr );
+	inContext->runUnchecked = inContext->callStackEntries[newEntryIndex].runUnchecked;
+	
+	inContext->statistics.numHandlerCalls ++;
+	if( inContext->numCallStackEntries > inContext->statistics.maxCallDepth )
+		inContext->statistics.maxCallDepth = inContext->numCallStackEntries;
+	
+	if( inContext->traceBuffer )
+		LEOTraceBufferRecordEvent( inContext->traceBuffer, kLEOTraceEventBegin, inHandler ? inHandler->handlerName : kLEOHandlerIDINVALID );
 }
 
 
@@ -154,12 +244,27 @@ void	LEOContextPopHandlerScriptReturnAddressAndBasePtr( LEOContext* inContext )
 	}
 	
 	inContext->numCallStackEntries--;
+	if( inContext->traceBuffer )
+	{
+		LEOHandler*	returningHandler = inContext->callStackEntries[inContext->numCallStackEntries].handler;
+		LEOTraceBufferRecordEvent( inContext->traceBuffer, kLEOTraceEventEnd, returningHandler ? returningHandler->handlerName : kLEOHandlerIDINVALID );
+	}
 	LEOScriptRelease( inContext->callStackEntries[inContext->numCallStackEntries].script );
+	LEOValuePtr	callerStackEndPtr = inContext->callStackEntries[inContext->numCallStackEntries].callerStackEndPtr;
 	
 	if( (inContext->numCallStackEntries % LEOCallStackEntriesChunkSize) == 0 && (inContext->numCallStackEntries > 0) )
 	{
 		inContext->callStackEntries = realloc( inContext->callStackEntries, sizeof(struct LEOCallStackEntry) * inContext->numCallStackEntries );
 	}
+	
+	inContext->runUnchecked = false;
+	if( inContext->numCallStackEntries > 0 )
+	{
+		LEOCallStackEntry*	callerEntry = inContext->callStackEntries +inContext->numCallStackEntries -1;
+		if( inContext->stackEndPtr != callerStackEndPtr )	// Unverified handler didn't clean up its stack? Then the caller's stack isn't laid out like the verifier assumed anymore.
+			callerEntry->runUnchecked = false;
+		inContext->runUnchecked = callerEntry->runUnchecked;
+	}
 }
 
 
@@ -202,7 +307,7 @@ LEOValuePtr	LEOPushStringValueOnStack( LEOContext* theContext, const char* inStr
 	
 	theContext->stackEndPtr++;
 	
-	LEOInitStringValue( theValue, inString, strLen, kLEOInvalidateReferences, theContext );
+	LEOInitTransientStringValue( theValue, inString, strLen, kLEOInvalidateReferences, theContext );
 	
 	return theValue;
 }
@@ -261,11 +366,44 @@ void	LEOCleanUpStackToPtr( LEOContext* theContext, union LEOValue* lastItemToDel
 		return;
 	}
 	
-	while( theContext->stackEndPtr > lastItemToDelete )
+	// Pop the whole range in one go. Most values are numbers etc. that nobody
+	//	references, which we only need to mark as gone:
+	LEOValuePtr		currValue = theContext->stackEndPtr;
+	while( currValue > lastItemToDelete )
 	{
-		theContext->stackEndPtr--;
-		LEOCleanUpValue( theContext->stackEndPtr, kLEOInvalidateReferences, theContext );
+		currValue--;
+		if( currValue->base.isa == NULL )
+			continue;
+		else if( currValue->base.isa->triviallyDestructible && currValue->base.refObjectID == kLEOObjectIDINVALID )
+			currValue->base.isa = NULL;
+		else
+			currValue->base.isa->CleanUp( currValue, kLEOInvalidateReferences, theContext );
 	}
+	if( theContext->stackEndPtr > lastItemToDelete )
+		theContext->stackEndPtr = lastItemToDelete;
+}
+
+
+// Run instructions of the current handler and any verified handlers it calls
+//	until we get to an unverified handler or execution ends. LEOVerifyHandler()
+//	has made sure that all instruction IDs are valid, and
+//	LEOCanRunHandlerUnchecked() that the handler's values fit on the stack.
+static bool	LEOContinueRunningContextUnchecked( LEOContext *inContext )
+{
+	while( inContext->runUnchecked )
+	{
+		gInstructions[inContext->currentInstruction->instructionID](inContext);
+		
+		inContext->statistics.numInstructions ++;
+		size_t	stackDepth = inContext->stackEndPtr -inContext->stack;
+		if( stackDepth > inContext->statistics.maxStackDepth )
+			inContext->statistics.maxStackDepth = stackDepth;
+		
+		if( inContext->currentInstruction == NULL || !inContext->keepRunning )
+			return false;
+	}
+	
+	return true;
 }
 
 
@@ -273,8 +411,14 @@ void	LEORunInContext( LEOInstruction instructions[], LEOContext *inContext )
 {
 	LEOPrepareContextForRunning( instructions, inContext );
 	
-	while( LEOContinueRunningContext( inContext ) )
-		;
+	bool	keepGoing = true;
+	while( keepGoing )
+	{
+		if( inContext->runUnchecked && inContext->preInstructionProc == LEODoNothingPreInstructionProc )
+			keepGoing = LEOContinueRunningContextUnchecked( inContext );
+		else
+			keepGoing = LEOContinueRunningContext( inContext );
+	}
 }
 
 
@@ -287,7 +431,16 @@ void	LEOPrepareContextForRunning( LEOInstruction instructions[], LEOContext *inC
 	inContext->stackBasePtr = inContext->stackEndPtr;
 	inContext->errMsg[0] = 0;
 	
-	// +++ Should we call LEOCleanUpStackToPtr here? Would be necessary for reusing a context.
+	inContext->runUnchecked = false;
+	if( inContext->numCallStackEntries > 0 )
+	{
+		LEOCallStackEntry*	currEntry = inContext->callStackEntries +inContext->numCallStackEntries -1;
+		currEntry->runUnchecked = currEntry->handler && currEntry->handler->instructions == instructions
+									&& LEOCanRunHandlerUnchecked( inContext, currEntry->handler, inContext->stackEndPtr );
+		inContext->runUnchecked = currEntry->runUnchecked;
+	}
+	
+	// To reuse a context that has already run, call LEOResetContext() first.
 }
 
 
@@ -304,6 +457,11 @@ bool	LEOContinueRunningContext( LEOContext *inContext )
 		currID = 0;	// First instruction is the special "unimplemented" instruction.
 	gInstructions[currID](inContext);
 	
+	inContext->statistics.numInstructions ++;
+	size_t	stackDepth = inContext->stackEndPtr -inContext->stack;
+	if( stackDepth > inContext->statistics.maxStackDepth )
+		inContext->statistics.maxStackDepth = stackDepth;
+	
 	return( inContext->currentInstruction != NULL && inContext->keepRunning );
 }
 
@@ -315,6 +473,7 @@ void	LEOContextStopWithError( LEOContext* inContext, const char* inErrorFmt, ...
 	vsnprintf( inContext->errMsg, sizeof(inContext->errMsg), inErrorFmt, varargs );
 	va_end( varargs );
 	inContext->keepRunning = false;
+	inContext->statistics.numErrors ++;
 	
 	inContext->promptProc( inContext );
 }
@@ -38,6 +38,7 @@
 // -----------------------------------------------------------------------------
 
 #include "LEOValue.h"
+#include "LEOContextGroup.h"
 #include <stdint.h>
 #include <assert.h>
 
@@ -88,22 +89,32 @@ typedef struct LEOInstruction
 
 /*! @functiongroup Static typecasting functions */
 /*! Reinterpret the given unsigned uint32_t as a signed int32_t. E.g. useful for an instruction's param2 field. */
-inline int32_t		LEOCastUInt32ToInt32( uint32_t inNum ) __attribute__((always_inline));
-inline int32_t		LEOCastUInt32ToInt32( uint32_t inNum )		{ return *(int32_t*)&inNum; }
+static inline int32_t		LEOCastUInt32ToInt32( uint32_t inNum ) __attribute__((always_inline));
+static inline int32_t		LEOCastUInt32ToInt32( uint32_t inNum )		{ return *(int32_t*)&inNum; }
 
 /*! Reinterpret the given unsigned uint16_t as a signed int16_t. E.g. useful for an instruction's param1 field. */
-inline int16_t		LEOCastUInt16ToInt16( uint16_t inNum ) __attribute__((always_inline));
-inline int16_t		LEOCastUInt16ToInt16( uint16_t inNum )		{ return *(int16_t*)&inNum; }
+static inline int16_t		LEOCastUInt16ToInt16( uint16_t inNum ) __attribute__((always_inline));
+static inline int16_t		LEOCastUInt16ToInt16( uint16_t inNum )		{ return *(int16_t*)&inNum; }
 
-/*! Reinterpret the given unsigned uint32_t as a LEONumber floating point quantity. E.g. useful for an instruction's param2 field. */
-inline LEONumber	LEOCastUInt32ToLEONumber( uint32_t inNum ) __attribute__((always_inline));
-inline LEONumber	LEOCastUInt32ToLEONumber( uint32_t inNum )	{ assert(sizeof(LEONumber) <= sizeof(uint32_t));  return *(LEONumber*)&inNum; }
+/*! Reinterpret the given unsigned uint32_t as a LEONumber floating point quantity. E.g. useful for an instruction's param2 field.
+	Since a LEONumber is larger than 32 bits, the param is a single-precision float's bits. */
+static inline LEONumber	LEOCastUInt32ToLEONumber( uint32_t inNum ) __attribute__((always_inline));
+static inline LEONumber	LEOCastUInt32ToLEONumber( uint32_t inNum )	{ union { uint32_t u; float f; } theNum = { inNum }; return theNum.f; }
+
+/*! Turn the given LEONumber into a uint32_t that LEOCastUInt32ToLEONumber() turns back into (roughly) the same number. E.g. useful for generating an instruction's param2 field. */
+static inline uint32_t	LEOCastLEONumberToUInt32( LEONumber inNum ) __attribute__((always_inline));
+static inline uint32_t	LEOCastLEONumberToUInt32( LEONumber inNum )	{ union { uint32_t u; float f; } theNum; theNum.f = (float) inNum; return theNum.u; }
 
 
 void	LEOInitInstructionArray();
 
 void	LEOAddInstructionsToInstructionArray( LEOInstructionFuncPtr *inInstructionArray, const char* *inInstructionNames, size_t inNumInstructions, size_t *outFirstNewInstruction );
 
+/*! Look up the ID of the instruction with the given name in gInstructionNames,
+	including instructions added by the host. Returns FALSE if there is no
+	instruction of that name. */
+bool	LEOInstructionIDForName( const char* inName, LEOInstructionID *outID );
+
 
 
 /*! @functiongroup LEOContext methods */
@@ -117,6 +128,8 @@ typedef struct LEOCallStackEntry
 	struct LEOHandler*	handler;		// The current handler, so we can show a nice call stack.
 	LEOInstruction*		returnAddress;	// Instruction at which we are to continue when this handler returns.
 	LEOValuePtr			oldBasePtr;		// The base pointer relative to which we calculate our parameters' and local variables' addresses.
+	LEOValuePtr			callerStackEndPtr;	// Stack pointer when the handler was called, so we notice if it didn't clean up after itself.
+	bool				runUnchecked;	// Handler has been verified and its stack frame fits on the stack.
 } LEOCallStackEntry;
 
 
@@ -137,6 +150,11 @@ typedef struct LEOCallStackEntry
 								is executed. Useful as a hook-up-point for a debugger,
 								or to process events while a script is running.
 	@field	numSteps			Used by LEODebugger's PreInstructionProc to implement single-stepping.
+	@field	arena				Optional bump allocator for transient strings created on the stack, or NULL. See LEOContextSetArenaSize.
+	@field	profiler			Used by LEOProfiler's PreInstructionProc to find the profiler collecting data for this context.
+	@field	traceBuffer			Buffer to record handler calls and returns in when this context is attached to a LEOTraceSession, or NULL.
+	@field	statistics			Counters of what this context has done since it was initialized or last reset. See LEOContextGetStatistics.
+	@field	runUnchecked		TRUE while the current handler has been verified by LEOVerifyHandler() and LEORunInContext() can skip the per-instruction checks.
 	@field	currentInstruction	The instruction currently being executed. Essentially the Program Counter of our virtual CPU.
 	@field	stackBasePtr		Base pointer into stack, used during function calls to find parameters & start of local variable section.
 	@field	stackEndPtr			Stack pointer indicating used size of our stack. Always points at element after last element.
@@ -158,6 +176,11 @@ typedef struct LEOContext
 	LEOInstructionFuncPtr	preInstructionProc;		// For each instruction, this function gets called, to let you do idle processing, hook in a debugger etc. This should NOT be an instruction, as that would advance the PC and screw up the call of the actual instruction.
 	LEOInstructionFuncPtr	promptProc;				// On certain errors, this function is called to enter into the debugger prompt.
 	size_t					numSteps;				// Used by LEODebugger's PreInstructionProc to implement single-stepping.
+	struct LEOArena			*arena;					// Bump allocator for transient strings on the stack, or NULL to just use malloc.
+	struct LEOProfiler		*profiler;				// Used by LEOProfiler's PreInstructionProc.
+	struct LEOTraceBuffer	*traceBuffer;			// Where to record handler calls for LEOTrace, or NULL.
+	LEOStatistics			statistics;				// Instructions executed, memory allocated etc.
+	bool					runUnchecked;			// Current handler is verified, see LEOVerifier.h.
 	LEOInstruction			*currentInstruction;	// PC
 	union LEOValue			*stackBasePtr;			// BP
 	union LEOValue			*stackEndPtr;			// SP (always points at element after last element)
@@ -180,7 +203,39 @@ typedef struct LEOContext
 */
 void	LEOInitContext( LEOContext* theContext, struct LEOContextGroup* inGroup );
 
+/*! Return the given LEOContext to the state LEOInitContext() left it in, so
+	it can be used to run another script without having to clean it up and
+	initialize it again. This only cleans up the part of the stack that is
+	actually in use, and keeps the call stack's storage allocated for reuse.
+	The context stays attached to its current context group, but is detached
+	from any LEOProfiler or LEOTraceSession.
+	@seealso //leo_ref/c/func/LEOInitContext LEOInitContext
+	@seealso //leo_ref/c/func/LEOContextPoolAcquireContext LEOContextPoolAcquireContext
+*/
+void	LEOResetContext( LEOContext* theContext );
+
+/*! Give the given context an arena of the given size in bytes, from which
+	it will allocate the buffers of transient string values it creates on its
+	stack, instead of calling malloc() for each of them. Pass 0 to go back to
+	using malloc() for everything. Only call this while the stack is empty.
+	@seealso //leo_ref/c/func/LEOArenaCreate LEOArenaCreate
+*/
+void	LEOContextSetArenaSize( LEOContext* theContext, size_t inSize );
+
+/*! Give the counters of what the given context has done since it was
+	initialized or last reset. To get the numbers for all contexts together,
+	use LEOContextGroupGetStatistics(), which also keeps the counters of
+	contexts that have been reset or cleaned up.
+	@seealso //leo_ref/c/func/LEOContextGroupGetStatistics LEOContextGroupGetStatistics
+*/
+void	LEOContextGetStatistics( LEOContext* theContext, LEOStatistics* outStatistics );
+
 /*! Shorthand for LEOPrepareContextForRunning and a loop of LEOContinueRunningContext.
+	While the current handler has been verified using LEOVerifyHandler() and
+	no preInstructionProc has been installed, its instructions are run without
+	the checks and the call to the preInstructionProc that
+	LEOContinueRunningContext does for each instruction.
+	@seealso //leo_ref/c/func/LEOVerifyHandler LEOVerifyHandler
 	@seealso //leo_ref/c/func/LEOPrepareContextForRunning LEOPrepareContextForRunning
 	@seealso //leo_ref/c/func/LEOContinueRunningContext LEOContinueRunningContext
 */
@@ -0,0 +1,310 @@
+/*
+ *  LEONumberConversion.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEONumberConversion.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+#define LEO_NUMBER_SIGNIFICANT_DIGITS	6		// What "%g" gives us.
+#define LEO_NUMBER_TIE_TOLERANCE		1e-6	// Closer than this to x.5 and double precision can't tell which way "%g" rounds.
+#define LEO_MAX_EXACT_POWER_OF_TEN		22		// 10^22 is the largest power of ten a double holds exactly.
+#define LEO_MAX_FAST_MANTISSA_DIGITS	19		// Any 19-digit decimal fits in a uint64_t.
+#define LEO_MAX_EXACT_MANTISSA			(1ULL << 53)
+#define LEO_MAX_FAST_INTEGER_DIGITS		18		// Any 18-digit decimal fits in a LEOInteger.
+
+
+// -----------------------------------------------------------------------------
+//	Globals:
+// -----------------------------------------------------------------------------
+
+static const double	sPowersOfTen[LEO_MAX_EXACT_POWER_OF_TEN +1] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const char	sDigitPairs[201] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+
+#pragma mark -
+// -----------------------------------------------------------------------------
+//	Formatting:
+// -----------------------------------------------------------------------------
+
+// Write the digits of inNumber right-aligned so they end right before
+//	inBufEnd, and return a pointer to the first one:
+static char*	LEOWriteDigitsBackwards( unsigned long long inNumber, char* inBufEnd )
+{
+	char*	currCh = inBufEnd;
+	while( inNumber >= 100 )
+	{
+		unsigned	pairIndex = (unsigned)(inNumber % 100) * 2;
+		inNumber /= 100;
+		currCh -= 2;
+		memcpy( currCh, sDigitPairs +pairIndex, 2 );
+	}
+	if( inNumber >= 10 )
+	{
+		currCh -= 2;
+		memcpy( currCh, sDigitPairs +(inNumber * 2), 2 );
+	}
+	else
+		*(--currCh) = (char)('0' +inNumber);
+
+	return currCh;
+}
+
+
+size_t	LEOFormatInteger( LEOInteger inInteger, char* outBuf )
+{
+	char				digits[LEO_NUMBER_STRING_MAX_LENGTH];
+	char*				digitsEnd = digits +sizeof(digits);
+	unsigned long long	magnitude = (inInteger < 0) ? (0ULL -(unsigned long long)inInteger) : (unsigned long long)inInteger;
+	char*				firstCh = LEOWriteDigitsBackwards( magnitude, digitsEnd );
+	if( inInteger < 0 )
+		*(--firstCh) = '-';
+
+	size_t	len = digitsEnd -firstCh;
+	memcpy( outBuf, firstCh, len );
+	outBuf[len] = 0;
+
+	return len;
+}
+
+
+static size_t	LEOFormatNumberUsingLibC( LEONumber inNumber, char* outBuf )
+{
+	return snprintf( outBuf, LEO_NUMBER_STRING_MAX_LENGTH, "%g", inNumber );
+}
+
+
+size_t	LEOFormatNumber( LEONumber inNumber, char* outBuf )
+{
+	if( inNumber == 0.0 )
+	{
+		if( signbit(inNumber) )
+		{
+			memcpy( outBuf, "-0", 3 );
+			return 2;
+		}
+		memcpy( outBuf, "0", 2 );
+		return 1;
+	}
+	if( !isfinite(inNumber) )
+		return LEOFormatNumberUsingLibC( inNumber, outBuf );
+
+	// Scale the number so its 6 significant digits are in front of the
+	//	decimal point. log10() may be off by one, so we correct the exponent
+	//	until they are:
+	double	magnitude = fabs(inNumber);
+	int		exponent = (int) floor( log10( magnitude ) );
+	double	scaled = 0;
+	for( int attempt = 0; true; attempt++ )
+	{
+		int		scale = (LEO_NUMBER_SIGNIFICANT_DIGITS -1) -exponent;
+		if( attempt > 2 || scale > LEO_MAX_EXACT_POWER_OF_TEN || scale < -LEO_MAX_EXACT_POWER_OF_TEN )
+			return LEOFormatNumberUsingLibC( inNumber, outBuf );
+
+		// The power of ten is exact, so this only rounds once, by at most half a unit in the last place:
+		scaled = (scale >= 0) ? (magnitude * sPowersOfTen[scale]) : (magnitude / sPowersOfTen[-scale]);
+		if( fabs( (scaled -floor(scaled)) -0.5 ) < LEO_NUMBER_TIE_TOLERANCE )
+			return LEOFormatNumberUsingLibC( inNumber, outBuf );
+
+		if( scaled < 99999.5 )
+			exponent--;
+		else if( scaled >= 999999.5 )
+			exponent++;
+		else
+			break;
+	}
+
+	unsigned long	significand = (unsigned long) floor( scaled +0.5 );
+	if( significand >= 1000000 )	// Rounded up to the next power of ten.
+	{
+		significand /= 10;
+		exponent++;
+	}
+
+	char	digits[LEO_NUMBER_SIGNIFICANT_DIGITS];
+	LEOWriteDigitsBackwards( significand, digits +LEO_NUMBER_SIGNIFICANT_DIGITS );
+	int		numDigits = LEO_NUMBER_SIGNIFICANT_DIGITS;
+	while( numDigits > 1 && digits[numDigits -1] == '0' )
+		numDigits--;
+
+	char*	currCh = outBuf;
+	if( inNumber < 0 )
+		*(currCh++) = '-';
+	if( exponent >= -4 && exponent < LEO_NUMBER_SIGNIFICANT_DIGITS )	// "%g" uses "%f" style for these.
+	{
+		if( exponent >= 0 )
+		{
+			memcpy( currCh, digits, exponent +1 );
+			currCh += exponent +1;
+			if( numDigits > exponent +1 )
+			{
+				*(currCh++) = '.';
+				memcpy( currCh, digits +exponent +1, numDigits -exponent -1 );
+				currCh += numDigits -exponent -1;
+			}
+		}
+		else
+		{
+			*(currCh++) = '0';
+			*(currCh++) = '.';
+			for( int x = -1; x > exponent; x-- )
+				*(currCh++) = '0';
+			memcpy( currCh, digits, numDigits );
+			currCh += numDigits;
+		}
+	}
+	else	// "%e" style:
+	{
+		*(currCh++) = digits[0];
+		if( numDigits > 1 )
+		{
+			*(currCh++) = '.';
+			memcpy( currCh, digits +1, numDigits -1 );
+			currCh += numDigits -1;
+		}
+		*(currCh++) = 'e';
+		*(currCh++) = (exponent < 0) ? '-' : '+';
+		memcpy( currCh, sDigitPairs +(abs(exponent) * 2), 2 );	// Always 2 digits, we don't get here for larger exponents.
+		currCh += 2;
+	}
+	*currCh = 0;
+
+	return currCh -outBuf;
+}
+
+
+#pragma mark -
+// -----------------------------------------------------------------------------
+//	Parsing:
+// -----------------------------------------------------------------------------
+
+const char*	LEOParseNumber( const char* inStr, LEONumber* outNumber )
+{
+	const char*	currCh = inStr;
+	bool		isNegative = false;
+	if( *currCh == '-' || *currCh == '+' )
+		isNegative = (*(currCh++) == '-');
+
+	// strtod() also parses hexadecimal, which we leave to it:
+	if( currCh[0] == '0' && (currCh[1] == 'x' || currCh[1] == 'X') )
+		goto useLibC;
+
+	uint64_t	mantissa = 0;
+	int			numSignificantDigits = 0;
+	int			numDigits = 0;
+	long		exponent = 0;
+	for( ; *currCh >= '0' && *currCh <= '9'; currCh++, numDigits++ )
+	{
+		mantissa = (mantissa * 10) +(*currCh -'0');
+		if( mantissa != 0 )
+			numSignificantDigits++;
+	}
+	if( *currCh == '.' )
+	{
+		for( currCh++; *currCh >= '0' && *currCh <= '9'; currCh++, numDigits++ )
+		{
+			mantissa = (mantissa * 10) +(*currCh -'0');
+			if( mantissa != 0 )
+				numSignificantDigits++;
+			exponent--;
+		}
+	}
+	if( numDigits == 0 || numSignificantDigits > LEO_MAX_FAST_MANTISSA_DIGITS )	// "inf", "nan", white space, or too long.
+		goto useLibC;
+
+	if( *currCh == 'e' || *currCh == 'E' )
+	{
+		const char*	exponentCh = currCh +1;
+		bool		isNegativeExponent = false;
+		if( *exponentCh == '-' || *exponentCh == '+' )
+			isNegativeExponent = (*(exponentCh++) == '-');
+		if( *exponentCh >= '0' && *exponentCh <= '9' )	// Otherwise the 'e' isn't part of the number.
+		{
+			long	explicitExponent = 0;
+			for( ; *exponentCh >= '0' && *exponentCh <= '9'; exponentCh++ )
+			{
+				if( explicitExponent < 100000 )
+					explicitExponent = (explicitExponent * 10) +(*exponentCh -'0');
+			}
+			exponent += isNegativeExponent ? -explicitExponent : explicitExponent;
+			currCh = exponentCh;
+		}
+	}
+
+	if( mantissa == 0 )
+	{
+		*outNumber = isNegative ? -0.0 : 0.0;
+		return currCh;
+	}
+	if( mantissa > LEO_MAX_EXACT_MANTISSA || exponent > LEO_MAX_EXACT_POWER_OF_TEN || exponent < -LEO_MAX_EXACT_POWER_OF_TEN )
+		goto useLibC;
+
+	// Both the mantissa and the power of ten are exact doubles, so this
+	//	rounds only once and gives the correctly rounded result:
+	double	theNumber = (double) mantissa;
+	if( exponent < 0 )
+		theNumber /= sPowersOfTen[-exponent];
+	else
+		theNumber *= sPowersOfTen[exponent];
+	*outNumber = isNegative ? -theNumber : theNumber;
+	return currCh;
+
+useLibC:
+	{
+		char*	endPtr = NULL;
+		*outNumber = strtod( inStr, &endPtr );
+		return endPtr;
+	}
+}
+
+
+const char*	LEOParseInteger( const char* inStr, LEOInteger* outInteger )
+{
+	const char*	currCh = inStr;
+	bool		isNegative = false;
+	if( *currCh == '-' || *currCh == '+' )
+		isNegative = (*(currCh++) == '-');
+
+	const char*		digitsStart = currCh;
+	LEOInteger		theInteger = 0;
+	for( ; *currCh >= '0' && *currCh <= '9' && (currCh -digitsStart) < LEO_MAX_FAST_INTEGER_DIGITS; currCh++ )
+		theInteger = (theInteger * 10) +(*currCh -'0');
+
+	// No digits (e.g. white space) or so many they might overflow?
+	if( currCh == digitsStart || (*currCh >= '0' && *currCh <= '9') )
+	{
+		char*	endPtr = NULL;
+		*outInteger = strtoll( inStr, &endPtr, 10 );
+		return endPtr;
+	}
+
+	*outInteger = isNegative ? -theInteger : theInteger;
+	return currCh;
+}
@@ -0,0 +1,86 @@
+/*
+ *  LEONumberConversion.h
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*!
+	@header LEONumberConversion
+	Conversions between numbers and strings, which scripts that mix text and
+	arithmetic do all the time. These produce exactly the same results as
+	snprintf() with "%g" and "%lld" and as strtod() and strtoll() (in the
+	"C" locale), just without going through the format string parser and
+	locale machinery each time:
+
+	<ul>
+	<li>Integers are written two digits at a time from a table.</li>
+	<li>Numbers are scaled by an exactly representable power of ten and
+		rounded to the 6 significant digits "%g" gives. Where that rounding
+		is too close to call in double precision (or the number is huge,
+		tiny, infinite or NaN), we let snprintf() decide.</li>
+	<li>Decimal strings with at most 19 significant digits and a small
+		exponent are parsed into an integer mantissa and converted with a
+		single, correctly rounded multiplication or division. Anything else
+		(hexadecimal, "inf", leading white space, long mantissas...) goes to
+		strtod().</li>
+	</ul>
+*/
+
+#ifndef LEO_NUMBER_CONVERSION_H
+#define LEO_NUMBER_CONVERSION_H		1
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOValue.h"
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+/*! Size of a buffer that can hold any number or integer written by
+	LEOFormatNumber() or LEOFormatInteger(), including the terminating
+	zero byte. */
+#define LEO_NUMBER_STRING_MAX_LENGTH		32
+
+
+// -----------------------------------------------------------------------------
+//	Prototypes:
+// -----------------------------------------------------------------------------
+
+/*!
+	Write the given number to outBuf like snprintf( outBuf, ..., "%g", inNumber )
+	would. outBuf must be at least LEO_NUMBER_STRING_MAX_LENGTH bytes large.
+	@result The length of the string, not counting the terminating zero byte.
+*/
+size_t		LEOFormatNumber( LEONumber inNumber, char* outBuf );
+
+/*!
+	Write the given integer to outBuf like snprintf( outBuf, ..., "%lld", inInteger )
+	would. outBuf must be at least LEO_NUMBER_STRING_MAX_LENGTH bytes large.
+	@result The length of the string, not counting the terminating zero byte.
+*/
+size_t		LEOFormatInteger( LEOInteger inInteger, char* outBuf );
+
+/*!
+	Parse a number at the start of the given string like strtod() does.
+	@result A pointer to the first character after the number, or inStr if
+			there was no number to parse.
+*/
+const char*	LEOParseNumber( const char* inStr, LEONumber* outNumber );
+
+/*!
+	Parse a decimal integer at the start of the given string like
+	strtoll( inStr, ..., 10 ) does.
+	@result A pointer to the first character after the integer, or inStr if
+			there was no integer to parse.
+*/
+const char*	LEOParseInteger( const char* inStr, LEOInteger* outInteger );
+
+
+#endif // LEO_NUMBER_CONVERSION_H
@@ -0,0 +1,397 @@
+/*
+ *  LEOProfiler.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOProfiler.h"
+#include "LEOInstructions.h"
+#include "LEOContextGroup.h"
+#include "LEOScript.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+#define LEOProfilerChunkSize				16
+#define LEOProfilerNoInstruction			((LEOInstructionID)-1)
+
+#ifndef LEO_PROFILER_USE_RDTSC
+#define LEO_PROFILER_USE_RDTSC				0
+#endif
+
+
+
+static LEOProfilerTime	LEOProfilerGetTime( void )
+{
+#if LEO_PROFILER_USE_RDTSC && (defined(__x86_64__) || defined(__i386__))
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec		now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return ((LEOProfilerTime)now.tv_sec * 1000000000ULL) +now.tv_nsec;
+#endif
+}
+
+
+LEOProfiler*	LEOProfilerCreate( LEOProfilerMode inMode, size_t inSampleInterval )
+{
+	LEOProfiler*	theProfiler = calloc( 1, sizeof(LEOProfiler) );
+	theProfiler->mode = inMode;
+	theProfiler->sampleInterval = (inSampleInterval > 0) ? inSampleInterval : 1;
+	theProfiler->lastInstructionID = LEOProfilerNoInstruction;
+
+	return theProfiler;
+}
+
+
+void	LEOProfilerReset( LEOProfiler* inProfiler )
+{
+	for( size_t x = 0; x < inProfiler->numHandlerEntries; x++ )
+	{
+		if( inProfiler->handlerEntries[x].handlerName )
+			free( inProfiler->handlerEntries[x].handlerName );
+		if( inProfiler->handlerEntries[x].lineEntries )
+			free( inProfiler->handlerEntries[x].lineEntries );
+	}
+	inProfiler->numHandlerEntries = 0;
+	inProfiler->numCallStackEntries = 0;
+	inProfiler->numSamples = 0;
+	if( inProfiler->instructionEntries )
+		memset( inProfiler->instructionEntries, 0, inProfiler->numInstructionEntries * sizeof(LEOProfilerInstructionEntry) );
+}
+
+
+void	LEOProfilerFree( LEOProfiler* inProfiler )
+{
+	LEOProfilerReset( inProfiler );
+	if( inProfiler->instructionEntries )
+		free( inProfiler->instructionEntries );
+	if( inProfiler->handlerEntries )
+		free( inProfiler->handlerEntries );
+	if( inProfiler->callStackEntries )
+		free( inProfiler->callStackEntries );
+	free( inProfiler );
+}
+
+
+#pragma mark -
+#pragma mark Collecting data
+
+static size_t	LEOProfilerIndexForHandler( LEOProfiler* inProfiler, struct LEOHandler* inHandler, struct LEOScript* inScript, LEOContext* inContext )
+{
+	for( size_t x = 0; x < inProfiler->numHandlerEntries; x++ )
+	{
+		if( inProfiler->handlerEntries[x].handler == inHandler && inProfiler->handlerEntries[x].script == inScript )
+			return x;
+	}
+
+	if( inProfiler->numHandlerEntries >= inProfiler->numHandlerSlots )
+	{
+		inProfiler->numHandlerSlots += LEOProfilerChunkSize;
+		inProfiler->handlerEntries = realloc( inProfiler->handlerEntries, inProfiler->numHandlerSlots * sizeof(LEOProfilerHandlerEntry) );
+	}
+
+	LEOProfilerHandlerEntry*	newEntry = inProfiler->handlerEntries +inProfiler->numHandlerEntries;
+	const char*					handlerName = inHandler ? LEOContextGroupHandlerNameForHandlerID( inContext->group, inHandler->handlerName ) : NULL;
+	memset( newEntry, 0, sizeof(LEOProfilerHandlerEntry) );
+	newEntry->handler = inHandler;
+	newEntry->script = inScript;
+	newEntry->handlerName = strdup( handlerName ? handlerName : "(unknown)" );
+
+	return inProfiler->numHandlerEntries++;
+}
+
+
+// Bring our copy of the call stack up to date with the context's, counting
+//	calls and, in exact mode, inclusive time of handlers that returned:
+static void	LEOProfilerUpdateCallStack( LEOProfiler* inProfiler, LEOContext* inContext, LEOProfilerTime inNow )
+{
+	while( inProfiler->numCallStackEntries > inContext->numCallStackEntries )	// Handlers returned?
+	{
+		LEOProfilerCallStackEntry*	poppedEntry = inProfiler->callStackEntries +(--inProfiler->numCallStackEntries);
+		LEOProfilerHandlerEntry*	handlerEntry = inProfiler->handlerEntries +poppedEntry->handlerIndex;
+		if( --handlerEntry->numActivations == 0 && inProfiler->mode == kLEOProfilerModeExact )	// Outermost call of recursion?
+			handlerEntry->inclusiveTime += inNow -poppedEntry->startTime;
+	}
+
+	while( inProfiler->numCallStackEntries < inContext->numCallStackEntries )	// Handlers called?
+	{
+		if( inProfiler->numCallStackEntries >= inProfiler->numCallStackSlots )
+		{
+			inProfiler->numCallStackSlots += LEOProfilerChunkSize;
+			inProfiler->callStackEntries = realloc( inProfiler->callStackEntries, inProfiler->numCallStackSlots * sizeof(LEOProfilerCallStackEntry) );
+		}
+
+		LEOProfilerCallStackEntry*	pushedEntry = inProfiler->callStackEntries +inProfiler->numCallStackEntries;
+		LEOCallStackEntry*			contextEntry = inContext->callStackEntries +inProfiler->numCallStackEntries;
+		pushedEntry->handlerIndex = LEOProfilerIndexForHandler( inProfiler, contextEntry->handler, contextEntry->script, inContext );
+		pushedEntry->startTime = inNow;
+		pushedEntry->currentLine = 0;
+		inProfiler->handlerEntries[pushedEntry->handlerIndex].numCalls ++;
+		inProfiler->handlerEntries[pushedEntry->handlerIndex].numActivations ++;
+		inProfiler->numCallStackEntries ++;
+	}
+}
+
+
+static LEOProfilerLineEntry*	LEOProfilerLineEntryForLine( LEOProfilerHandlerEntry* inHandlerEntry, size_t inLine )
+{
+	if( inLine >= inHandlerEntry->numLineEntries )
+	{
+		size_t	oldNumEntries = inHandlerEntry->numLineEntries;
+		size_t	newNumEntries = inLine +LEOProfilerChunkSize;
+		inHandlerEntry->lineEntries = realloc( inHandlerEntry->lineEntries, newNumEntries * sizeof(LEOProfilerLineEntry) );
+		memset( inHandlerEntry->lineEntries +oldNumEntries, 0, (newNumEntries -oldNumEntries) * sizeof(LEOProfilerLineEntry) );
+		inHandlerEntry->numLineEntries = newNumEntries;
+	}
+	
+	return inHandlerEntry->lineEntries +inLine;
+}
+
+
+// If the instruction about to be executed is a line marker, remember that the
+//	current handler is now on that line:
+static void	LEOProfilerUpdateCurrentLine( LEOProfiler* inProfiler, LEOContext* inContext )
+{
+	if( inContext->currentInstruction && inContext->currentInstruction->instructionID == LINE_MARKER_INSTR
+		&& inProfiler->numCallStackEntries > 0 )
+	{
+		LEOProfilerCallStackEntry*	currFrame = inProfiler->callStackEntries +(inProfiler->numCallStackEntries -1);
+		currFrame->currentLine = inContext->currentInstruction->param2;
+		LEOProfilerLineEntryForLine( inProfiler->handlerEntries +currFrame->handlerIndex, currFrame->currentLine )->numHits ++;
+	}
+}
+
+
+// Charge the given time to the given instruction and the handler (and line)
+//	that is currently executing:
+static void	LEOProfilerAddTime( LEOProfiler* inProfiler, LEOInstructionID inInstructionID, LEOProfilerTime inTime )
+{
+	if( inInstructionID >= inProfiler->numInstructionEntries )
+	{
+		size_t	oldNumEntries = inProfiler->numInstructionEntries;
+		size_t	newNumEntries = (gNumInstructions > inInstructionID) ? gNumInstructions : (inInstructionID +1);
+		inProfiler->instructionEntries = realloc( inProfiler->instructionEntries, newNumEntries * sizeof(LEOProfilerInstructionEntry) );
+		memset( inProfiler->instructionEntries +oldNumEntries, 0, (newNumEntries -oldNumEntries) * sizeof(LEOProfilerInstructionEntry) );
+		inProfiler->numInstructionEntries = newNumEntries;
+	}
+
+	inProfiler->instructionEntries[inInstructionID].numExecutions ++;
+	inProfiler->instructionEntries[inInstructionID].time += inTime;
+
+	if( inProfiler->numCallStackEntries > 0 )
+	{
+		LEOProfilerCallStackEntry*	currFrame = inProfiler->callStackEntries +(inProfiler->numCallStackEntries -1);
+		inProfiler->handlerEntries[currFrame->handlerIndex].exclusiveTime += inTime;
+		
+		if( inProfiler->collectLines )
+		{
+			LEOProfilerLineEntry*	lineEntry = LEOProfilerLineEntryForLine( inProfiler->handlerEntries +currFrame->handlerIndex, currFrame->currentLine );
+			lineEntry->numInstructions ++;
+			lineEntry->time += inTime;
+		}
+	}
+}
+
+
+void	LEOProfilerPreInstructionProc( LEOContext* inContext )
+{
+	LEOProfiler*	theProfiler = inContext->profiler;
+
+	if( theProfiler->mode == kLEOProfilerModeExact )
+	{
+		LEOProfilerTime	now = LEOProfilerGetTime();
+		if( theProfiler->lastInstructionID != LEOProfilerNoInstruction )
+			LEOProfilerAddTime( theProfiler, theProfiler->lastInstructionID, now -theProfiler->lastTime );
+		LEOProfilerUpdateCallStack( theProfiler, inContext, now );
+		if( theProfiler->collectLines )
+			LEOProfilerUpdateCurrentLine( theProfiler, inContext );
+		theProfiler->lastInstructionID = inContext->currentInstruction ? inContext->currentInstruction->instructionID : LEOProfilerNoInstruction;
+
+		theProfiler->previousPreInstructionProc( inContext );
+		theProfiler->lastTime = LEOProfilerGetTime();	// Don't count our own overhead or that of a debugger.
+	}
+	else
+	{
+		LEOProfilerUpdateCallStack( theProfiler, inContext, 0 );
+		if( theProfiler->collectLines )
+			LEOProfilerUpdateCurrentLine( theProfiler, inContext );
+
+		if( --theProfiler->instructionsUntilSample == 0 && inContext->currentInstruction )
+		{
+			LEOProfilerTime	now = LEOProfilerGetTime();
+			LEOProfilerTime	elapsed = now -theProfiler->lastTime;
+			theProfiler->numSamples ++;
+			theProfiler->instructionsUntilSample = theProfiler->sampleInterval;
+			LEOProfilerAddTime( theProfiler, inContext->currentInstruction->instructionID, elapsed );
+			for( size_t x = 0; x < theProfiler->numCallStackEntries; x++ )
+			{
+				LEOProfilerHandlerEntry*	handlerEntry = theProfiler->handlerEntries +theProfiler->callStackEntries[x].handlerIndex;
+				if( handlerEntry->lastSample != theProfiler->numSamples )	// Recursive handlers only get charged once per sample.
+				{
+					handlerEntry->lastSample = theProfiler->numSamples;
+					handlerEntry->inclusiveTime += elapsed;
+				}
+			}
+			theProfiler->lastTime = now;
+		}
+		else if( theProfiler->instructionsUntilSample == 0 )
+			theProfiler->instructionsUntilSample = theProfiler->sampleInterval;
+
+		theProfiler->previousPreInstructionProc( inContext );
+	}
+}
+
+
+void	LEOProfilerAttachToContext( LEOProfiler* inProfiler, LEOContext* inContext )
+{
+	inProfiler->context = inContext;
+	inProfiler->previousPreInstructionProc = inContext->preInstructionProc;
+	inProfiler->lastInstructionID = LEOProfilerNoInstruction;
+	inProfiler->instructionsUntilSample = inProfiler->sampleInterval;
+	inProfiler->numCallStackEntries = 0;
+	inProfiler->lastTime = LEOProfilerGetTime();
+
+	inContext->profiler = inProfiler;
+	inContext->preInstructionProc = LEOProfilerPreInstructionProc;
+}
+
+
+void	LEOProfilerDetachFromContext( LEOProfiler* inProfiler )
+{
+	LEOContext*		theContext = inProfiler->context;
+	if( !theContext )
+		return;
+
+	LEOProfilerTime	now = LEOProfilerGetTime();
+	if( inProfiler->mode == kLEOProfilerModeExact && inProfiler->lastInstructionID != LEOProfilerNoInstruction )
+		LEOProfilerAddTime( inProfiler, inProfiler->lastInstructionID, now -inProfiler->lastTime );
+	inProfiler->lastInstructionID = LEOProfilerNoInstruction;
+
+	while( inProfiler->numCallStackEntries > 0 )	// Script was aborted while handlers were running?
+	{
+		LEOProfilerCallStackEntry*	poppedEntry = inProfiler->callStackEntries +(--inProfiler->numCallStackEntries);
+		LEOProfilerHandlerEntry*	handlerEntry = inProfiler->handlerEntries +poppedEntry->handlerIndex;
+		if( --handlerEntry->numActivations == 0 && inProfiler->mode == kLEOProfilerModeExact )
+			handlerEntry->inclusiveTime += now -poppedEntry->startTime;
+	}
+
+	if( theContext->preInstructionProc == LEOProfilerPreInstructionProc )
+		theContext->preInstructionProc = inProfiler->previousPreInstructionProc;
+	theContext->profiler = NULL;
+	inProfiler->context = NULL;
+}
+
+
+#pragma mark -
+#pragma mark Report
+
+static int	LEOProfilerCompareInstructionEntries( const void* inA, const void* inB )
+{
+	const LEOProfilerInstructionEntry*	a = *(const LEOProfilerInstructionEntry**)inA;
+	const LEOProfilerInstructionEntry*	b = *(const LEOProfilerInstructionEntry**)inB;
+	if( a->time != b->time )
+		return( (a->time > b->time) ? -1 : 1 );
+	if( a->numExecutions != b->numExecutions )
+		return( (a->numExecutions > b->numExecutions) ? -1 : 1 );
+	return( (a < b) ? -1 : 1 );	// Keep order stable.
+}
+
+
+static int	LEOProfilerCompareHandlerEntries( const void* inA, const void* inB )
+{
+	const LEOProfilerHandlerEntry*	a = *(const LEOProfilerHandlerEntry**)inA;
+	const LEOProfilerHandlerEntry*	b = *(const LEOProfilerHandlerEntry**)inB;
+	if( a->exclusiveTime != b->exclusiveTime )
+		return( (a->exclusiveTime > b->exclusiveTime) ? -1 : 1 );
+	if( a->inclusiveTime != b->inclusiveTime )
+		return( (a->inclusiveTime > b->inclusiveTime) ? -1 : 1 );
+	return( (a < b) ? -1 : 1 );
+}
+
+
+void	LEOProfilerPrintReport( LEOProfiler* inProfiler, FILE* outFile )
+{
+	LEOProfilerTime		totalTime = 0;
+	size_t				numUsedInstructions = 0;
+	const char*			unitName = LEO_PROFILER_USE_RDTSC ? "cycles" : "ns";
+
+	for( size_t x = 0; x < inProfiler->numInstructionEntries; x++ )
+	{
+		totalTime += inProfiler->instructionEntries[x].time;
+		if( inProfiler->instructionEntries[x].numExecutions > 0 )
+			numUsedInstructions++;
+	}
+
+	if( inProfiler->mode == kLEOProfilerModeExact )
+		fprintf( outFile, "Profile (exact), total time %llu %s\n\n", (unsigned long long)totalTime, unitName );
+	else
+		fprintf( outFile, "Profile (%zu samples, one every %zu instructions), total time %llu %s\n\n", inProfiler->numSamples, inProfiler->sampleInterval, (unsigned long long)totalTime, unitName );
+
+	// Instructions, most expensive first:
+	LEOProfilerInstructionEntry**	sortedInstructions = calloc( numUsedInstructions +1, sizeof(LEOProfilerInstructionEntry*) );
+	size_t							numSorted = 0;
+	for( size_t x = 0; x < inProfiler->numInstructionEntries; x++ )
+	{
+		if( inProfiler->instructionEntries[x].numExecutions > 0 )
+			sortedInstructions[numSorted++] = inProfiler->instructionEntries +x;
+	}
+	qsort( sortedInstructions, numSorted, sizeof(LEOProfilerInstructionEntry*), LEOProfilerCompareInstructionEntries );
+
+	fprintf( outFile, "%16s %7s %12s  %s\n", "time", "%", (inProfiler->mode == kLEOProfilerModeExact) ? "executions" : "samples", "instruction" );
+	for( size_t x = 0; x < numSorted; x++ )
+	{
+		LEOInstructionID	theID = sortedInstructions[x] -inProfiler->instructionEntries;
+		const char*			theName = (theID < gNumInstructions && gInstructionNames && gInstructionNames[theID]) ? gInstructionNames[theID] : "UNKNOWN";
+		double				percentage = totalTime ? (100.0 * sortedInstructions[x]->time) / totalTime : 0.0;
+		fprintf( outFile, "%16llu %6.2f%% %12zu  %s\n", (unsigned long long)sortedInstructions[x]->time, percentage, sortedInstructions[x]->numExecutions, theName );
+	}
+	free( sortedInstructions );
+
+	// Handlers, most expensive first:
+	LEOProfilerHandlerEntry**	sortedHandlers = calloc( inProfiler->numHandlerEntries +1, sizeof(LEOProfilerHandlerEntry*) );
+	for( size_t x = 0; x < inProfiler->numHandlerEntries; x++ )
+		sortedHandlers[x] = inProfiler->handlerEntries +x;
+	qsort( sortedHandlers, inProfiler->numHandlerEntries, sizeof(LEOProfilerHandlerEntry*), LEOProfilerCompareHandlerEntries );
+
+	fprintf( outFile, "\n%16s %16s %10s  %s\n", "exclusive", "inclusive", "calls", "handler" );
+	for( size_t x = 0; x < inProfiler->numHandlerEntries; x++ )
+	{
+		fprintf( outFile, "%16llu %16llu %10zu  %s\n", (unsigned long long)sortedHandlers[x]->exclusiveTime, (unsigned long long)sortedHandlers[x]->inclusiveTime,
+					sortedHandlers[x]->numCalls, sortedHandlers[x]->handlerName );
+	}
+	free( sortedHandlers );
+}
+
+
+void	LEOProfilerWriteCallgrindFile( LEOProfiler* inProfiler, FILE* outFile )
+{
+	fprintf( outFile, "# callgrind format\nversion: 1\ncreator: Leonie LEOProfiler\n" );
+	fprintf( outFile, "positions: line\nevents: %s Hits Instructions\n", LEO_PROFILER_USE_RDTSC ? "Cycles" : "Nanoseconds" );
+	
+	for( size_t x = 0; x < inProfiler->numHandlerEntries; x++ )
+	{
+		LEOProfilerHandlerEntry*	handlerEntry = inProfiler->handlerEntries +x;
+		
+		fprintf( outFile, "\nfl=script-%p\nfn=%s\n", handlerEntry->script, handlerEntry->handlerName );
+		for( size_t currLine = 0; currLine < handlerEntry->numLineEntries; currLine++ )
+		{
+			LEOProfilerLineEntry*	lineEntry = handlerEntry->lineEntries +currLine;
+			if( lineEntry->numHits == 0 && lineEntry->numInstructions == 0 )
+				continue;
+			fprintf( outFile, "%zu %llu %zu %zu\n", currLine, (unsigned long long)lineEntry->time, lineEntry->numHits, lineEntry->numInstructions );
+		}
+	}
+}
@@ -0,0 +1,236 @@
+/*
+ *  LEOProfiler.h
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*!
+	@header LEOProfiler
+	An instruction-level profiler that hooks into a LEOContext's
+	PreInstructionProc, just like LEODebugger does.
+
+	It records how often each instruction was executed and how much time was
+	spent in it, and for each handler how often it was called, how much time
+	was spent in its own instructions (exclusive time) and how much time was
+	spent until it returned, including the handlers it called (inclusive time).
+	Recursive calls are only counted once towards inclusive time.
+
+	In exact mode, the profiler takes a timestamp before every instruction.
+	In sampling mode, it only takes one every sampleInterval instructions and
+	attributes the time since the previous sample to the instruction and
+	handlers that are current at that point, which costs much less but only
+	gives statistically meaningful numbers for longer runs. Calls to handlers
+	are counted exactly in both modes.
+
+	If you set the profiler's collectLines field to TRUE, it also uses the
+	LINE_MARKER_INSTR instructions in the bytecode to keep track of the source
+	line each handler is currently executing, and charges the time of every
+	instruction to its line as well. LEOProfilerWriteCallgrindFile() writes
+	these per-line numbers in a format KCachegrind and other tools can read.
+
+	Attach a profiler to a context before running it, and detach it once the
+	context has finished. A profiler can only be attached to one context at a
+	time, but keeps accumulating data across successive attachments.
+*/
+
+#ifndef LEO_PROFILER_H
+#define LEO_PROFILER_H		1
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOInterpreter.h"
+#include "LEOHandlerID.h"
+#include <stdio.h>
+
+
+// -----------------------------------------------------------------------------
+//	Types:
+// -----------------------------------------------------------------------------
+
+/*! A point in time as measured by the profiler. Nanoseconds, or CPU cycles if
+	LEO_PROFILER_USE_RDTSC was defined to 1 when compiling LEOProfiler.c. */
+typedef uint64_t	LEOProfilerTime;
+
+
+/*! How a profiler collects its data. */
+enum
+{
+	kLEOProfilerModeExact,		// Take a timestamp for each instruction.
+	kLEOProfilerModeSampling	// Only take a timestamp every sampleInterval instructions.
+};
+typedef int		LEOProfilerMode;
+
+
+/*! What a profiler knows about one instruction.
+	@field	numExecutions	Number of times this instruction was executed (exact mode) or sampled (sampling mode).
+	@field	time			Time spent executing this instruction.
+*/
+typedef struct LEOProfilerInstructionEntry
+{
+	size_t				numExecutions;
+	LEOProfilerTime		time;
+} LEOProfilerInstructionEntry;
+
+
+/*! What a profiler knows about one source line of a handler.
+	@field	numHits				Number of times execution reached this line's LINE_MARKER_INSTR.
+	@field	numInstructions		Number of instructions executed (exact mode) or sampled (sampling mode) on this line.
+	@field	time				Time spent executing this line's instructions.
+*/
+typedef struct LEOProfilerLineEntry
+{
+	size_t				numHits;
+	size_t				numInstructions;
+	LEOProfilerTime		time;
+} LEOProfilerLineEntry;
+
+
+/*! What a profiler knows about one handler.
+	@field	handler			The handler this entry is about. Only used for identifying it, may have gone away by now.
+	@field	script			The script the handler belongs to. Only used for identifying it, may have gone away by now.
+	@field	handlerName		Copy of the handler's name.
+	@field	numCalls		Number of times this handler was called.
+	@field	exclusiveTime	Time spent in this handler's own instructions.
+	@field	inclusiveTime	Time spent in this handler and the handlers it called.
+	@field	numActivations	Number of calls to this handler currently on the call stack.
+	@field	lastSample		Sample during which inclusiveTime was last updated, so recursion doesn't count twice.
+	@field	numLineEntries	Number of items in lineEntries.
+	@field	lineEntries		Statistics per source line, indexed by line number. Line 0 is code before the first line marker.
+*/
+typedef struct LEOProfilerHandlerEntry
+{
+	struct LEOHandler*	handler;
+	struct LEOScript*	script;
+	char*				handlerName;
+	size_t				numCalls;
+	LEOProfilerTime		exclusiveTime;
+	LEOProfilerTime		inclusiveTime;
+	size_t				numActivations;
+	size_t				lastSample;
+	size_t				numLineEntries;
+	LEOProfilerLineEntry*	lineEntries;
+} LEOProfilerHandlerEntry;
+
+
+/*! One entry of the profiler's copy of the call stack.
+	@field	handlerIndex	Index of the called handler in the profiler's handlers array.
+	@field	startTime		When the handler was called (exact mode only).
+	@field	currentLine		Line number of the last LINE_MARKER_INSTR this call of the handler executed.
+*/
+typedef struct LEOProfilerCallStackEntry
+{
+	size_t				handlerIndex;
+	LEOProfilerTime		startTime;
+	size_t				currentLine;
+} LEOProfilerCallStackEntry;
+
+
+/*! A profiler. Create it using LEOProfilerCreate().
+	@field	mode					Whether to profile each instruction or only take samples.
+	@field	sampleInterval			Number of instructions between samples in sampling mode.
+	@field	collectLines			Set this to TRUE before attaching to also collect statistics per source line.
+	@field	numInstructionEntries	Number of items in instructionEntries.
+	@field	instructionEntries		Statistics per instruction, indexed by LEOInstructionID.
+	@field	numHandlerEntries		Number of items in handlerEntries.
+	@field	numHandlerSlots			Number of items allocated for handlerEntries.
+	@field	handlerEntries			Statistics per handler.
+	@field	numCallStackEntries		Number of items in callStackEntries.
+	@field	numCallStackSlots		Number of items allocated for callStackEntries.
+	@field	callStackEntries		Mirror of the current context's call stack.
+	@field	context					The context we're currently attached to, or NULL.
+	@field	previousPreInstructionProc	The context's PreInstructionProc before we were attached. We call it for every instruction.
+	@field	lastInstructionID		Instruction that was about to be executed when we were last called, or (LEOInstructionID)-1.
+	@field	lastTime				Time when we were last called (or took the last sample).
+	@field	instructionsUntilSample	Countdown to the next sample in sampling mode.
+	@field	numSamples				Number of samples taken so far.
+*/
+typedef struct LEOProfiler
+{
+	LEOProfilerMode					mode;
+	size_t							sampleInterval;
+	bool							collectLines;
+	size_t							numInstructionEntries;
+	LEOProfilerInstructionEntry		*instructionEntries;
+	size_t							numHandlerEntries;
+	size_t							numHandlerSlots;
+	LEOProfilerHandlerEntry			*handlerEntries;
+	size_t							numCallStackEntries;
+	size_t							numCallStackSlots;
+	LEOProfilerCallStackEntry		*callStackEntries;
+	LEOContext						*context;
+	LEOInstructionFuncPtr			previousPreInstructionProc;
+	LEOInstructionID				lastInstructionID;
+	LEOProfilerTime					lastTime;
+	size_t							instructionsUntilSample;
+	size_t							numSamples;
+} LEOProfiler;
+
+
+// -----------------------------------------------------------------------------
+//	Prototypes:
+// -----------------------------------------------------------------------------
+
+/*!
+	Create a new profiler. inSampleInterval is only used in sampling mode and
+	is the number of instructions between two samples.
+	@seealso //leo_ref/c/func/LEOProfilerFree LEOProfilerFree
+*/
+LEOProfiler*	LEOProfilerCreate( LEOProfilerMode inMode, size_t inSampleInterval );
+
+/*!
+	Dispose of the given profiler and all data it collected. The profiler must
+	not be attached to a context anymore.
+*/
+void			LEOProfilerFree( LEOProfiler* inProfiler );
+
+/*!
+	Start collecting data about the given context. This installs the
+	profiler's PreInstructionProc in the context. Any PreInstructionProc that
+	was already installed (e.g. LEODebugger's) keeps being called.
+	@seealso //leo_ref/c/func/LEOProfilerDetachFromContext LEOProfilerDetachFromContext
+*/
+void			LEOProfilerAttachToContext( LEOProfiler* inProfiler, LEOContext* inContext );
+
+/*!
+	Stop collecting data about the context the profiler is attached to. This
+	accounts for the last instruction that ran and for all handlers that are
+	still on the call stack, and restores the context's PreInstructionProc.
+	LEOCleanUpContext() and LEOResetContext() (and thus
+	LEOContextPoolReturnContext()) do this for you if the profiler is still
+	attached.
+*/
+void			LEOProfilerDetachFromContext( LEOProfiler* inProfiler );
+
+/*!
+	The PreInstructionProc that LEOProfilerAttachToContext() installs. You
+	shouldn't have to call this yourself.
+*/
+void			LEOProfilerPreInstructionProc( LEOContext* inContext );
+
+/*!
+	Forget all data collected so far. The profiler must not be attached to a
+	context.
+*/
+void			LEOProfilerReset( LEOProfiler* inProfiler );
+
+/*!
+	Write a report of the collected data to the given file, listing
+	instructions and handlers sorted by time spent, most expensive first.
+*/
+void			LEOProfilerPrintReport( LEOProfiler* inProfiler, FILE* outFile );
+
+/*!
+	Write the per-line statistics collected with collectLines turned on to
+	the given file in callgrind format, with one "file" per script and one
+	"function" per handler. The events are the time, the number of times each
+	line was reached, and the number of instructions executed on it.
+*/
+void			LEOProfilerWriteCallgrindFile( LEOProfiler* inProfiler, FILE* outFile );
+
+
+#endif // LEO_PROFILER_H
@@ -26,6 +26,8 @@ void	LEOInitHandlerWithID( LEOHandler* inStorage, LEOHandlerID inHandlerName )
 	inStorage->numInstructions = 0;
 	inStorage->numVariables = 0;
 	inStorage->varNames = NULL;
+	inStorage->verified = false;
+	inStorage->maxStackDepth = 0;
 	inStorage->instructions = calloc(NUM_INSTRUCTIONS_PER_CHUNK, sizeof(LEOInstruction));
 }
 
@@ -52,6 +54,7 @@ void	LEOCleanUpHandler( LEOHandler* inStorage )
 
 void	LEOHandlerAddInstruction( LEOHandler* inHandler, LEOInstructionID instructionID, uint16_t param1, uint32_t param2 )
 {
+	inHandler->verified = false;
 	inHandler->numInstructions ++;
 	if( (inHandler->numInstructions % NUM_INSTRUCTIONS_PER_CHUNK) == 1 && inHandler->numInstructions != 1 )
 	{
@@ -66,7 +66,14 @@ typedef struct LEOVariableNameMapping
 	@field numInstructions	The number of instructions in the instructions
 							array.
 	@field instructions		An array that holds the instructions for this
-							handler. */
+							handler.
+	@field verified			TRUE if LEOVerifyHandler() has checked the
+							instructions and LEORunInContext() may run them
+							without per-instruction checks. Adding an
+							instruction clears this again.
+	@field maxStackDepth	The most values the handler has on the stack
+							above its base pointer, as determined by
+							LEOVerifyHandler(). Only valid if verified is TRUE. */
 // -----------------------------------------------------------------------------
 
 typedef struct LEOHandler
@@ -76,6 +83,8 @@ typedef struct LEOHandler
 	LEOInstruction			*instructions;
 	size_t					numVariables;
 	LEOVariableNameMapping	*varNames;
+	bool					verified;
+	size_t					maxStackDepth;
 } LEOHandler;
 
 
@@ -0,0 +1,110 @@
+/*
+ *  LEOSlabAllocator.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOSlabAllocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+// Each slab starts with a pointer to the next slab, blocks follow after that
+//	(padded so they stay aligned for doubles and pointers):
+#define LEOSlabHeaderSize				LEO_SLAB_SIZE_CLASS_GRANULARITY
+
+#define LEOSlabSizeClassForSize(n)		(((n) +LEO_SLAB_SIZE_CLASS_GRANULARITY -1) / LEO_SLAB_SIZE_CLASS_GRANULARITY -1)
+#define LEOSlabBlockSizeForSizeClass(c)	(((c) +1) * LEO_SLAB_SIZE_CLASS_GRANULARITY)
+
+
+
+LEOSlabAllocator*	LEOSlabAllocatorCreate( void )
+{
+	return calloc( 1, sizeof(LEOSlabAllocator) );
+}
+
+
+void	LEOSlabAllocatorFree( LEOSlabAllocator* inAllocator )
+{
+	void*	currSlab = inAllocator->slabs;
+	while( currSlab )
+	{
+		void*	nextSlab = *(void**)currSlab;
+		free( currSlab );
+		currSlab = nextSlab;
+	}
+	inAllocator->slabs = NULL;
+	free( inAllocator );
+}
+
+
+void	LEOSlabAllocatorFreeWhenUnused( LEOSlabAllocator* inAllocator )
+{
+	if( inAllocator->statistics.numBlocksInUse == 0 )
+		LEOSlabAllocatorFree( inAllocator );
+	else
+		inAllocator->freeWhenUnused = true;
+}
+
+
+void*	LEOSlabAllocatorAllocate( LEOSlabAllocator* inAllocator, size_t inSize )
+{
+	if( inSize == 0 )
+		inSize = 1;
+	if( inSize > LEO_SLAB_MAX_BLOCK_SIZE )
+	{
+		inAllocator->statistics.numFallbackAllocations ++;
+		return NULL;
+	}
+
+	LEOSlabSizeClass*	theClass = inAllocator->sizeClasses +LEOSlabSizeClassForSize( inSize );
+	void*				theBlock = theClass->freeBlocks;
+	if( theBlock )	// Have a block that was given back? Re-use it.
+		theClass->freeBlocks = *(void**)theBlock;
+	else
+	{
+		size_t		blockSize = LEOSlabBlockSizeForSizeClass( LEOSlabSizeClassForSize( inSize ) );
+		if( blockSize > (size_t)(theClass->slabEnd -theClass->slabTop) )	// Current slab used up? Start a new one.
+		{
+			char*	newSlab = malloc( LEO_SLAB_SIZE );
+			*(void**)newSlab = inAllocator->slabs;
+			inAllocator->slabs = newSlab;
+			theClass->slabTop = newSlab +LEOSlabHeaderSize;
+			theClass->slabEnd = newSlab +LEO_SLAB_SIZE;
+			inAllocator->statistics.numSlabs ++;
+		}
+		theBlock = theClass->slabTop;
+		theClass->slabTop += blockSize;
+	}
+
+	inAllocator->statistics.numAllocations ++;
+	inAllocator->statistics.numBlocksInUse ++;
+
+	return theBlock;
+}
+
+
+void	LEOSlabAllocatorRelease( LEOSlabAllocator* inAllocator, void* inBlock, size_t inSize )
+{
+	if( inSize == 0 )
+		inSize = 1;
+	LEOSlabSizeClass*	theClass = inAllocator->sizeClasses +LEOSlabSizeClassForSize( inSize );
+	*(void**)inBlock = theClass->freeBlocks;
+	theClass->freeBlocks = inBlock;
+
+	inAllocator->statistics.numReleases ++;
+	inAllocator->statistics.numBlocksInUse --;
+	if( inAllocator->freeWhenUnused && inAllocator->statistics.numBlocksInUse == 0 )	// Owner went away and this was the last block?
+		LEOSlabAllocatorFree( inAllocator );
+}
@@ -0,0 +1,147 @@
+/*
+ *  LEOSlabAllocator.h
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*!
+	@header LEOSlabAllocator
+	An allocator for many small blocks of similar size, like the entries of
+	associative arrays (struct LEOArrayEntry plus its key).
+
+	Requests are rounded up to one of a few size classes. Each size class
+	carves its blocks out of large slabs and keeps a free list of blocks that
+	were given back, so allocating and releasing a block is just a few pointer
+	operations instead of a trip through malloc() and free(). All slabs are
+	disposed of at once when the allocator is freed, which can be deferred
+	until the last block has been given back.
+
+	The allocator doesn't remember the size of a block, callers must pass the
+	same size to LEOSlabAllocatorRelease() that they passed when allocating.
+	Requests bigger than LEO_SLAB_MAX_BLOCK_SIZE aren't handled, the allocator
+	returns NULL and the caller should use malloc() instead.
+
+	A slab allocator is not thread safe.
+*/
+
+#ifndef LEO_SLAB_ALLOCATOR_H
+#define LEO_SLAB_ALLOCATOR_H		1
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include <sys/types.h>
+#include <stdbool.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+/*! Blocks are handed out in multiples of this many bytes. */
+#define LEO_SLAB_SIZE_CLASS_GRANULARITY		32
+
+/*! Number of different block sizes an allocator manages. */
+#define LEO_SLAB_NUM_SIZE_CLASSES			16
+
+/*! Biggest block a LEOSlabAllocator will hand out. */
+#define LEO_SLAB_MAX_BLOCK_SIZE				(LEO_SLAB_SIZE_CLASS_GRANULARITY * LEO_SLAB_NUM_SIZE_CLASSES)
+
+/*! Size of one slab that blocks of one size class are carved from. */
+#define LEO_SLAB_SIZE						(16 * 1024)
+
+
+// -----------------------------------------------------------------------------
+//	Types:
+// -----------------------------------------------------------------------------
+
+/*! Counters that show how much a slab allocator is used.
+	@field	numAllocations			Number of blocks handed out, i.e. calls to malloc() avoided.
+	@field	numFallbackAllocations	Number of requests that were too large and returned NULL.
+	@field	numReleases				Number of blocks given back.
+	@field	numBlocksInUse			Number of blocks currently handed out.
+	@field	numSlabs				Number of slabs allocated so far.
+*/
+typedef struct LEOSlabAllocatorStatistics
+{
+	size_t		numAllocations;
+	size_t		numFallbackAllocations;
+	size_t		numReleases;
+	size_t		numBlocksInUse;
+	size_t		numSlabs;
+} LEOSlabAllocatorStatistics;
+
+
+/*! The state of one size class in a slab allocator.
+	@field	freeBlocks		Linked list of blocks that have been released and can be handed out again.
+	@field	slabTop			Next block in the current slab that hasn't been handed out yet.
+	@field	slabEnd			First byte after the current slab.
+*/
+typedef struct LEOSlabSizeClass
+{
+	void*		freeBlocks;
+	char*		slabTop;
+	char*		slabEnd;
+} LEOSlabSizeClass;
+
+
+/*! A size-class slab allocator. Create it using LEOSlabAllocatorCreate().
+	@field	slabs			Linked list of all slabs, so we can free them.
+	@field	sizeClasses		Free lists and current slab for each block size.
+	@field	statistics		Counters for the host to check how well the allocator works.
+	@field	freeWhenUnused	TRUE if the allocator should free itself once the last block is given back.
+*/
+typedef struct LEOSlabAllocator
+{
+	void*						slabs;
+	LEOSlabSizeClass			sizeClasses[LEO_SLAB_NUM_SIZE_CLASSES];
+	LEOSlabAllocatorStatistics	statistics;
+	bool						freeWhenUnused;
+} LEOSlabAllocator;
+
+
+// -----------------------------------------------------------------------------
+//	Prototypes:
+// -----------------------------------------------------------------------------
+
+/*!
+	Create a new, empty slab allocator. Slabs are only allocated once a block
+	of their size class is requested.
+	@seealso //leo_ref/c/func/LEOSlabAllocatorFree LEOSlabAllocatorFree
+*/
+LEOSlabAllocator*	LEOSlabAllocatorCreate( void );
+
+/*!
+	Dispose of the given allocator and all its slabs in one go. Any blocks
+	still handed out from it become invalid.
+*/
+void				LEOSlabAllocatorFree( LEOSlabAllocator* inAllocator );
+
+/*!
+	Dispose of the given allocator once all blocks handed out from it have
+	been given back, or right away if there are none. Use this instead of
+	LEOSlabAllocatorFree() if its owner goes away while others may still be
+	using its blocks. Don't allocate from it anymore after calling this.
+*/
+void				LEOSlabAllocatorFreeWhenUnused( LEOSlabAllocator* inAllocator );
+
+/*!
+	Hand out a block of at least inSize bytes of uninitialized memory, or
+	return NULL if inSize is larger than LEO_SLAB_MAX_BLOCK_SIZE, in which case
+	the caller should use malloc() instead.
+	@seealso //leo_ref/c/func/LEOSlabAllocatorRelease LEOSlabAllocatorRelease
+*/
+void*				LEOSlabAllocatorAllocate( LEOSlabAllocator* inAllocator, size_t inSize );
+
+/*!
+	Give back a block obtained from LEOSlabAllocatorAllocate(). inSize must
+	be the same size that was requested when the block was allocated.
+*/
+void				LEOSlabAllocatorRelease( LEOSlabAllocator* inAllocator, void* inBlock, size_t inSize );
+
+
+#endif // LEO_SLAB_ALLOCATOR_H
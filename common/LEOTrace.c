@@ -0,0 +1,272 @@
+/*
+ *  LEOTrace.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOTrace.h"
+#include "LEOContextGroup.h"
+#include "LEOScript.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+#define LEOTraceNamesChunkSize			16
+
+
+// -----------------------------------------------------------------------------
+//	Helpers:
+// -----------------------------------------------------------------------------
+
+static LEOTraceTime	LEOTraceNow( void )
+{
+	struct timespec		now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return ((LEOTraceTime)now.tv_sec * 1000000000ULL) +now.tv_nsec;
+}
+
+
+static LEOTraceChunk*	LEOTraceChunkCreate( LEOTraceBuffer* inBuffer )
+{
+	LEOTraceChunk*	theChunk = malloc( sizeof(LEOTraceChunk) );
+	theChunk->next = NULL;
+	theChunk->contextID = inBuffer->contextID;
+	theChunk->threadID = (uint64_t)(uintptr_t) pthread_self();
+	theChunk->numNames = 0;
+	theChunk->names = NULL;
+	theChunk->nameHandlerIDs = NULL;
+	theChunk->numEvents = 0;
+
+	return theChunk;
+}
+
+
+static void	LEOTraceChunkFree( LEOTraceChunk* inChunk )
+{
+	for( size_t x = 0; x < inChunk->numNames; x++ )
+		free( inChunk->names[x] );
+	if( inChunk->names )
+		free( inChunk->names );
+	if( inChunk->nameHandlerIDs )
+		free( inChunk->nameHandlerIDs );
+	free( inChunk );
+}
+
+
+// Look up the names of all handlers in the chunk while the context group is
+//	still around. Most chunks only mention a handful of handlers, so we just
+//	look through the names we already copied for the same handler ID:
+static void	LEOTraceChunkResolveNames( LEOTraceChunk* inChunk, struct LEOContextGroup* inGroup )
+{
+	for( size_t x = 0; x < inChunk->numEvents; x++ )
+	{
+		LEOTraceEvent*	currEvent = inChunk->events +x;
+		size_t			nameIndex = 0;
+		for( nameIndex = 0; nameIndex < inChunk->numNames; nameIndex++ )
+		{
+			if( inChunk->nameHandlerIDs[nameIndex] == currEvent->handlerID )
+				break;
+		}
+		
+		if( nameIndex == inChunk->numNames )
+		{
+			const char*	theName = (currEvent->handlerID != kLEOHandlerIDINVALID) ? LEOContextGroupHandlerNameForHandlerID( inGroup, currEvent->handlerID ) : NULL;
+			if( !theName )
+				theName = "(unknown)";
+			
+			if( (inChunk->numNames % LEOTraceNamesChunkSize) == 0 )
+			{
+				inChunk->names = realloc( inChunk->names, sizeof(char*) * (inChunk->numNames +LEOTraceNamesChunkSize) );
+				inChunk->nameHandlerIDs = realloc( inChunk->nameHandlerIDs, sizeof(LEOHandlerID) * (inChunk->numNames +LEOTraceNamesChunkSize) );
+			}
+			inChunk->names[nameIndex] = strdup( theName );
+			inChunk->nameHandlerIDs[nameIndex] = currEvent->handlerID;
+			inChunk->numNames++;
+		}
+		
+		currEvent->handlerName = inChunk->names[nameIndex];
+	}
+}
+
+
+// Give a chunk to the session so the next LEOTraceSessionFlush() writes it.
+//	Several contexts may do this at once, and a flush may be taking the list
+//	at the same time, so we swap the new chunk in atomically:
+static void	LEOTraceBufferHandOffChunk( LEOTraceBuffer* inBuffer )
+{
+	LEOTraceChunk*	theChunk = inBuffer->currentChunk;
+	inBuffer->currentChunk = NULL;
+	if( theChunk->numEvents == 0 )
+	{
+		LEOTraceChunkFree( theChunk );
+		return;
+	}
+
+	LEOTraceChunkResolveNames( theChunk, inBuffer->context->group );
+
+	LEOTraceChunk*	oldHead = __atomic_load_n( &inBuffer->session->fullChunks, __ATOMIC_RELAXED );
+	do
+	{
+		theChunk->next = oldHead;
+	}
+	while( !__atomic_compare_exchange_n( &inBuffer->session->fullChunks, &oldHead, theChunk, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED ) );
+}
+
+
+static void	LEOTraceBufferAppendEvent( LEOTraceBuffer* inBuffer, LEOTraceEventPhase inPhase, LEOHandlerID inHandlerID, LEOTraceTime inTimestamp )
+{
+	LEOTraceChunk*	theChunk = inBuffer->currentChunk;
+	if( theChunk->numEvents >= LEO_TRACE_CHUNK_NUM_EVENTS )
+	{
+		LEOTraceBufferHandOffChunk( inBuffer );
+		theChunk = inBuffer->currentChunk = LEOTraceChunkCreate( inBuffer );
+	}
+
+	LEOTraceEvent*	theEvent = theChunk->events +theChunk->numEvents;
+	theEvent->timestamp = inTimestamp;
+	theEvent->handlerID = inHandlerID;
+	theEvent->phase = inPhase;
+	theChunk->numEvents++;
+}
+
+
+static void	LEOTraceWriteEscapedString( FILE* outFile, const char* inString )
+{
+	for( const char* currCh = inString; *currCh != 0; currCh++ )
+	{
+		if( *currCh == '"' || *currCh == '\\' )
+			fprintf( outFile, "\\%c", *currCh );
+		else if( (unsigned char)*currCh < 0x20 )
+			fprintf( outFile, "\\u%04x", (unsigned char)*currCh );
+		else
+			fputc( *currCh, outFile );
+	}
+}
+
+
+#pragma mark -
+
+LEOTraceSession*	LEOTraceSessionCreate( FILE* outFile )
+{
+	LEOTraceSession*	theSession = calloc( 1, sizeof(LEOTraceSession) );
+	theSession->outFile = outFile;
+	theSession->startTime = LEOTraceNow();
+
+	fprintf( outFile, "[" );
+
+	return theSession;
+}
+
+
+void	LEOTraceSessionFree( LEOTraceSession* inSession )
+{
+	LEOTraceSessionFlush( inSession );
+
+	fprintf( inSession->outFile, "\n]\n" );
+	fflush( inSession->outFile );
+
+	free( inSession );
+}
+
+
+void	LEOTraceSessionAttachToContext( LEOTraceSession* inSession, LEOContext* inContext )
+{
+	LEOTraceBuffer*	theBuffer = calloc( 1, sizeof(LEOTraceBuffer) );
+	theBuffer->session = inSession;
+	theBuffer->context = inContext;
+	theBuffer->contextID = __atomic_fetch_add( &inSession->nextContextID, 1, __ATOMIC_RELAXED );
+	theBuffer->currentChunk = LEOTraceChunkCreate( theBuffer );
+
+	inContext->traceBuffer = theBuffer;
+}
+
+
+void	LEOTraceSessionDetachFromContext( LEOContext* inContext )
+{
+	LEOTraceBuffer*	theBuffer = inContext->traceBuffer;
+	if( !theBuffer )
+		return;
+
+	// End all handlers we saw begin that are still on the call stack, innermost first:
+	LEOTraceTime	now = LEOTraceNow();
+	size_t			numOpenHandlers = theBuffer->numOpenHandlers;
+	if( numOpenHandlers > inContext->numCallStackEntries )
+		numOpenHandlers = inContext->numCallStackEntries;
+	for( size_t x = inContext->numCallStackEntries; x > inContext->numCallStackEntries -numOpenHandlers; x-- )
+	{
+		LEOHandler*	runningHandler = inContext->callStackEntries[x -1].handler;
+		LEOTraceBufferAppendEvent( theBuffer, kLEOTraceEventEnd, runningHandler ? runningHandler->handlerName : kLEOHandlerIDINVALID, now );
+	}
+
+	LEOTraceBufferHandOffChunk( theBuffer );
+
+	inContext->traceBuffer = NULL;
+	free( theBuffer );
+}
+
+
+void	LEOTraceSessionFlush( LEOTraceSession* inSession )
+{
+	LEOTraceChunk*	theChunks = __atomic_exchange_n( &inSession->fullChunks, NULL, __ATOMIC_ACQUIRE );
+
+	// The list is newest first, turn it around so the file is roughly in order:
+	LEOTraceChunk*	reversedChunks = NULL;
+	while( theChunks )
+	{
+		LEOTraceChunk*	nextChunk = theChunks->next;
+		theChunks->next = reversedChunks;
+		reversedChunks = theChunks;
+		theChunks = nextChunk;
+	}
+
+	// Other threads may be flushing at the same time, the file's lock keeps
+	//	our events and numEventsWritten from getting mixed up with theirs:
+	FILE*	outFile = inSession->outFile;
+	long	processID = (long) getpid();
+	flockfile( outFile );
+	while( reversedChunks )
+	{
+		LEOTraceChunk*	currChunk = reversedChunks;
+		for( size_t x = 0; x < currChunk->numEvents; x++ )
+		{
+			LEOTraceEvent*	currEvent = currChunk->events +x;
+			LEOTraceTime	relativeTime = (currEvent->timestamp > inSession->startTime) ? (currEvent->timestamp -inSession->startTime) : 0;
+			fprintf( outFile, "%s\n{\"name\":\"", (inSession->numEventsWritten > 0) ? "," : "" );
+			LEOTraceWriteEscapedString( outFile, currEvent->handlerName );
+			fprintf( outFile, "\",\"cat\":\"handler\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%ld,\"tid\":%llu,\"args\":{\"context\":%zu}}",
+						currEvent->phase, (unsigned long long)(relativeTime / 1000), (unsigned)(relativeTime % 1000),
+						processID, (unsigned long long)currChunk->threadID, currChunk->contextID );
+			inSession->numEventsWritten++;
+		}
+
+		reversedChunks = currChunk->next;
+		LEOTraceChunkFree( currChunk );
+	}
+	funlockfile( outFile );
+}
+
+
+void	LEOTraceBufferRecordEvent( LEOTraceBuffer* inBuffer, LEOTraceEventPhase inPhase, LEOHandlerID inHandlerID )
+{
+	if( inPhase == kLEOTraceEventBegin )
+		inBuffer->numOpenHandlers++;
+	else if( inBuffer->numOpenHandlers > 0 )
+		inBuffer->numOpenHandlers--;
+	
+	LEOTraceBufferAppendEvent( inBuffer, inPhase, inHandlerID, LEOTraceNow() );
+}
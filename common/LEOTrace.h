@@ -0,0 +1,188 @@
+/*
+ *  LEOTrace.h
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*!
+	@header LEOTrace
+	Records a "begin" event whenever a handler is called and an "end" event
+	whenever it returns, and writes them to a file in the Trace Event format
+	that chrome://tracing and Perfetto can load, so you can look at the calls
+	of one or more contexts on a timeline.
+
+	A LEOTraceSession owns the output file. Each context that is attached to
+	a session gets its own LEOTraceBuffer, into which events are recorded as
+	the context's call stack changes. A context only runs on one thread at a
+	time, so recording an event takes no locks, it just stores a timestamp and
+	the handler ID in the buffer's current chunk. Once a chunk is full, its
+	handler IDs are looked up in the context group and the chunk is handed to
+	the session through a lock-free list. LEOTraceSessionFlush() takes all the
+	chunks handed over so far and writes them to the file. It may be called
+	from any thread, e.g. from a background thread every now and then, so
+	formatting and writing the JSON doesn't happen on the threads running
+	scripts.
+*/
+
+#ifndef LEO_TRACE_H
+#define LEO_TRACE_H		1
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOInterpreter.h"
+#include "LEOHandlerID.h"
+#include <stdio.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+/*! Number of events that fit in one chunk of a LEOTraceBuffer. */
+#define LEO_TRACE_CHUNK_NUM_EVENTS			4096
+
+
+/*! Kinds of events in a trace, their values are the Trace Event format's "ph" field. */
+enum
+{
+	kLEOTraceEventBegin	= 'B',	// A handler was called.
+	kLEOTraceEventEnd	= 'E'	// A handler returned.
+};
+typedef char	LEOTraceEventPhase;
+
+
+// -----------------------------------------------------------------------------
+//	Types:
+// -----------------------------------------------------------------------------
+
+/*! A point in time as recorded in a trace, in nanoseconds. */
+typedef uint64_t	LEOTraceTime;
+
+
+/*! One event in a trace.
+	@field	timestamp		When the event happened.
+	@field	handlerID		The handler that was called or returned from.
+	@field	phase			Whether the handler was called or returned.
+	@field	handlerName		Name of the handler. Only filled out when the chunk is handed over to the session.
+*/
+typedef struct LEOTraceEvent
+{
+	LEOTraceTime		timestamp;
+	LEOHandlerID		handlerID;
+	LEOTraceEventPhase	phase;
+	const char*			handlerName;
+} LEOTraceEvent;
+
+
+/*! A block of events recorded by one context.
+	@field	next			Next chunk in the session's list of chunks to write.
+	@field	contextID		Number the session gave the context that recorded these events.
+	@field	threadID		Thread that recorded these events.
+	@field	numNames		Number of items in names and nameHandlerIDs.
+	@field	names			Copies of the handler names used by the events, so the context group may go away before the chunk is written.
+	@field	nameHandlerIDs	The handler ID of each item in names.
+	@field	numEvents		Number of items in events.
+	@field	events			The events.
+*/
+typedef struct LEOTraceChunk
+{
+	struct LEOTraceChunk*	next;
+	size_t					contextID;
+	uint64_t				threadID;
+	size_t					numNames;
+	char**					names;
+	LEOHandlerID*			nameHandlerIDs;
+	size_t					numEvents;
+	LEOTraceEvent			events[LEO_TRACE_CHUNK_NUM_EVENTS];
+} LEOTraceChunk;
+
+
+/*! A trace that is being written to a file. Create it using LEOTraceSessionCreate().
+	@field	outFile				The file to write the events to.
+	@field	startTime			Time the session was created. Timestamps in the file are relative to this.
+	@field	fullChunks			Chunks handed over by the contexts that haven't been written yet, newest first.
+	@field	nextContextID		Number to give the next context that is attached.
+	@field	numEventsWritten	Number of events written to outFile so far.
+*/
+typedef struct LEOTraceSession
+{
+	FILE*					outFile;
+	LEOTraceTime			startTime;
+	LEOTraceChunk*			fullChunks;
+	size_t					nextContextID;
+	size_t					numEventsWritten;
+} LEOTraceSession;
+
+
+/*! The events one context records for a session. Created by LEOTraceSessionAttachToContext().
+	@field	session			The session to hand full chunks to.
+	@field	context			The context recording into this buffer.
+	@field	contextID		Number the session gave this context.
+	@field	currentChunk	The chunk events are currently recorded into.
+	@field	numOpenHandlers	Number of handlers that began since we were attached and haven't returned yet.
+*/
+typedef struct LEOTraceBuffer
+{
+	LEOTraceSession*		session;
+	LEOContext*				context;
+	size_t					contextID;
+	LEOTraceChunk*			currentChunk;
+	size_t					numOpenHandlers;
+} LEOTraceBuffer;
+
+
+// -----------------------------------------------------------------------------
+//	Prototypes:
+// -----------------------------------------------------------------------------
+
+/*!
+	Create a new trace session that writes to the given file, which must
+	already be open for writing and stay open until the session has been freed.
+	@seealso //leo_ref/c/func/LEOTraceSessionFree LEOTraceSessionFree
+*/
+LEOTraceSession*	LEOTraceSessionCreate( FILE* outFile );
+
+/*!
+	Write any events that are still waiting and finish the file. All contexts
+	must have been detached from the session. This doesn't close the file.
+*/
+void				LEOTraceSessionFree( LEOTraceSession* inSession );
+
+/*!
+	Start recording the handler calls of the given context. A context can only
+	be attached to one session at a time.
+	@seealso //leo_ref/c/func/LEOTraceSessionDetachFromContext LEOTraceSessionDetachFromContext
+*/
+void				LEOTraceSessionAttachToContext( LEOTraceSession* inSession, LEOContext* inContext );
+
+/*!
+	Stop recording the handler calls of the given context and hand the events
+	recorded so far to its session. Handlers that were called while attached
+	and are still running (e.g. because the script was aborted) get an end
+	event now, so every begin event in the trace has a matching end. LEOCleanUpContext() and LEOResetContext()
+	(and thus LEOContextPoolReturnContext()) do this for you if the context is
+	still attached. Must be called on the thread that runs the
+	context.
+*/
+void				LEOTraceSessionDetachFromContext( LEOContext* inContext );
+
+/*!
+	Write all events handed over to the session so far to its file. This may
+	be called from any thread, and from several threads at once.
+*/
+void				LEOTraceSessionFlush( LEOTraceSession* inSession );
+
+/*!
+	Record an event in the given buffer. LEOContextPushHandlerScriptReturnAddressAndBasePtr()
+	and LEOContextPopHandlerScriptReturnAddressAndBasePtr() call this for you,
+	you shouldn't have to call it yourself.
+*/
+void				LEOTraceBufferRecordEvent( LEOTraceBuffer* inBuffer, LEOTraceEventPhase inPhase, LEOHandlerID inHandlerID );
+
+
+#endif // LEO_TRACE_H
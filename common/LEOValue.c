@@ -21,14 +21,20 @@
 #include "LEOValue.h"
 #include "LEOInterpreter.h"
 #include "LEOContextGroup.h"
+#include "LEOArena.h"
+#include "LEOSlabAllocator.h"
+#include "LEONumberConversion.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <math.h>
 
 
 #define OTHER_VALUE_SHORT_STRING_MAX_LENGTH		256
 #define LEO_MAX_ARRAY_KEY_SIZE					1024
+#define LEO_ARRAY_COPY_STACK_CHUNK_SIZE			16
+#define LEO_ARRAY_PRINT_BUFFER_INITIAL_SIZE		256
 
 
 // Users shouldn't care if something is a variant, but it helps when debugging:
@@ -75,7 +81,10 @@ struct LEOValueType	kLeoValueTypeNumber =
 	LEOCantGetValueForKey,
 	LEOCantSetValueForKey,
 	LEOCantSetValueAsArray,
-	LEOCantGetKeyCount
+	LEOCantGetKeyCount,
+	
+	kLEOValueTypeTagNumber,
+	true
 };
 
 
@@ -110,7 +119,10 @@ struct LEOValueType	kLeoValueTypeInteger =
 	LEOCantGetValueForKey,
 	LEOCantSetValueForKey,
 	LEOCantSetValueAsArray,
-	LEOCantGetKeyCount
+	LEOCantGetKeyCount,
+	
+	kLEOValueTypeTagInteger,
+	true
 };
 
 
@@ -145,7 +157,10 @@ struct LEOValueType	kLeoValueTypeString =
 	LEOCantGetValueForKey,
 	LEOSetStringLikeValueForKey,
 	LEOSetStringLikeValueAsArray,
-	LEOCantGetKeyCount
+	LEOCantGetKeyCount,
+	
+	kLEOValueTypeTagString,
+	false
 };
 
 
@@ -180,7 +195,10 @@ struct LEOValueType	kLeoValueTypeStringConstant =
 	LEOCantGetValueForKey,
 	LEOCantSetValueForKey,
 	LEOSetStringLikeValueAsArray,
-	LEOCantGetKeyCount
+	LEOCantGetKeyCount,
+	
+	kLEOValueTypeTagString,
+	true
 };
 
 
@@ -217,7 +235,10 @@ struct LEOValueType	kLeoValueTypeBoolean =
 	LEOCantGetValueForKey,
 	LEOCantSetValueForKey,
 	LEOCantSetValueAsArray,
-	LEOCantGetKeyCount
+	LEOCantGetKeyCount,
+	
+	kLEOValueTypeTagBoolean,
+	true
 };
 
 
@@ -252,7 +273,10 @@ struct LEOValueType	kLeoValueTypeReference =
 	LEOGetReferenceValueValueForKey,
 	LEOSetReferenceValueValueForKey,
 	LEOSetReferenceValueAsArray,
-	LEOGetReferenceValueKeyCount
+	LEOGetReferenceValueKeyCount,
+	
+	kLEOValueTypeTagOther,
+	false
 };
 
 
@@ -287,7 +311,10 @@ struct LEOValueType	kLeoValueTypeNumberVariant =
 	LEOCantGetValueForKey,
 	LEOCantSetValueForKey,
 	LEOSetVariantValueAsArray,
-	LEOCantGetKeyCount
+	LEOCantGetKeyCount,
+	
+	kLEOValueTypeTagNumber,
+	true
 };
 
 
@@ -322,7 +349,10 @@ struct LEOValueType	kLeoValueTypeIntegerVariant =
 	LEOCantGetValueForKey,
 	LEOCantSetValueForKey,
 	LEOSetVariantValueAsArray,
-	LEOCantGetKeyCount
+	LEOCantGetKeyCount,
+	
+	kLEOValueTypeTagInteger,
+	true
 };
 
 
@@ -357,7 +387,10 @@ struct LEOValueType	kLeoValueTypeStringVariant =
 	LEOCantGetValueForKey,
 	LEOSetStringVariantValueValueForKey,
 	LEOSetVariantValueAsArray,
-	LEOCantGetKeyCount
+	LEOCantGetKeyCount,
+	
+	kLEOValueTypeTagString,
+	false
 };
 
 
@@ -392,7 +425,10 @@ struct LEOValueType	kLeoValueTypeBooleanVariant =
 	LEOCantGetValueForKey,
 	LEOCantSetValueForKey,
 	LEOSetVariantValueAsArray,
-	LEOCantGetKeyCount
+	LEOCantGetKeyCount,
+	
+	kLEOValueTypeTagBoolean,
+	true
 };
 
 
@@ -427,7 +463,10 @@ struct LEOValueType	kLeoValueTypeArray =
 	LEOGetArrayValueValueForKey,
 	LEOSetArrayValueValueForKey,
 	LEOSetArrayValueAsArray,
-	LEOGetArrayValueKeyCount
+	LEOGetArrayValueKeyCount,
+	
+	kLEOValueTypeTagOther,
+	false
 };
 
 
@@ -462,7 +501,48 @@ struct LEOValueType	kLeoValueTypeArrayVariant =
 	LEOGetArrayValueValueForKey,
 	LEOSetArrayValueValueForKey,
 	LEOSetArrayValueAsArray,
-	LEOGetArrayValueKeyCount
+	LEOGetArrayValueKeyCount,
+	
+	kLEOValueTypeTagOther,
+	false
+};
+
+
+struct LEOValueType	kLeoValueTypeDenseArray =
+{
+	"array",
+	sizeof(struct LEOValueDenseArray),
+	
+	LEOCantGetValueAsNumber,
+	LEOCantGetValueAsInteger,
+	LEOGetDenseArrayValueAsString,
+	LEOCantGetValueAsBoolean,
+	LEOGetArrayValueAsRangeOfString,
+	
+	LEOCantSetValueAsNumber,
+	LEOCantSetValueAsInteger,
+	LEOCantSetValueAsString,
+	LEOCantSetValueAsBoolean,
+	LEOCantSetValueRangeAsString,
+	LEOCantSetValuePredeterminedRangeAsString,
+	
+	LEOInitDenseArrayValueCopy,
+	LEOInitDenseArrayValueCopy,
+	LEOPutDenseArrayValueIntoValue,
+	LEOCantFollowReferencesAndReturnValueOfType,
+	LEODetermineChunkRangeOfSubstringOfArrayValue,
+	
+	LEOCleanUpDenseArrayValue,
+	
+	LEOCantCanGetValueAsNumber,
+	
+	LEOGetDenseArrayValueValueForKey,
+	LEOSetDenseArrayValueValueForKey,
+	LEOSetDenseArrayValueAsArray,
+	LEOGetDenseArrayValueKeyCount,
+	
+	kLEOValueTypeTagOther,
+	false
 };
 
 
@@ -545,25 +625,40 @@ void	LEOCantSetValueForKey( LEOValuePtr self, const char* keyName, LEOValuePtr i
 //}
 //
 //
-void	LEOSetStringLikeValueForKey( LEOValuePtr self, const char* keyName, LEOValuePtr inValue, struct LEOContext* inContext )
+/*
+	Turn the given string value into an array variant holding the array its
+	text describes (or an empty array if it is empty), so keys can be added to
+	it directly instead of parsing and printing the whole string again for
+	every key. It is only turned back into text when someone asks for it.
+	Returns FALSE (and leaves the value alone) if the text isn't an array.
+*/
+
+static bool	LEOConvertStringValueToArrayVariant( LEOValuePtr self, struct LEOContext* inContext )
 {
 	struct LEOArrayEntry	*	convertedArray = NULL;
-	if( self->string.string != NULL && strlen(self->string.string) != 0 )
+	if( self->string.string != NULL && self->string.string[0] != 0 )	// Not an empty string
 	{
 		convertedArray = LEOCreateArrayFromString( self->string.string, inContext );
 		if( !convertedArray )
-		{
-			LEOContextStopWithError( inContext, "Expected array, found %s", self->base.isa->displayTypeName );
-			return;
-		}
+			return false;
 	}
-	LEOAddArrayEntryToRoot( &convertedArray, keyName, inValue, inContext );
 	
-	char	str[1024] = { 0 };	// TODO: Make work with arbitrary string sizes.
-	LEOPrintArray( convertedArray, str, sizeof(str), inContext );
-	LEOSetValueAsString( self, str, inContext );	// TODO: Make this binary data safe.
+	LEOCleanUpValue( self, kLEOKeepReferences, inContext );
+	LEOInitArrayValue( self, convertedArray, kLEOKeepReferences, inContext );
+	self->base.isa = &kLeoValueTypeArrayVariant;
 	
-	LEOCleanUpArray( convertedArray, inContext );
+	return true;
+}
+
+
+void	LEOSetStringLikeValueForKey( LEOValuePtr self, const char* keyName, LEOValuePtr inValue, struct LEOContext* inContext )
+{
+	if( !LEOConvertStringValueToArrayVariant( self, inContext ) )
+	{
+		LEOContextStopWithError( inContext, "Expected array, found %s", self->base.isa->displayTypeName );
+		return;
+	}
+	LEOAddArrayEntryToRoot( &self->array.array, keyName, inValue, inContext );
 }
 
 
@@ -713,11 +808,23 @@ void	LEOCantSetValueAsArray( LEOValuePtr self, struct LEOArrayEntry *inArray, st
 }
 
 
+// Hand out a number's string like snprintf( outBuf, bufSize -1, ... ) used to:
+static void	LEOCopyNumberStringToBuffer( const char* inStr, size_t inLength, char* outBuf, size_t bufSize )
+{
+	if( bufSize < 2 )
+		return;
+	if( inLength > (bufSize -2) )
+		inLength = bufSize -2;
+	memcpy( outBuf, inStr, inLength );
+	outBuf[inLength] = 0;
+}
+
+
 void	LEOSetStringLikeValueAsArray( LEOValuePtr self, struct LEOArrayEntry *inArray, struct LEOContext* inContext )
 {
-	char	str[1024] = { 0 };	// TODO: Make work with arbitrary string sizes.
-	LEOPrintArray( inArray, str, sizeof(str), inContext );
+	char*	str = LEOCopyArrayAsString( inArray, NULL, inContext );
 	LEOSetValueAsString( self, str, inContext );	// TODO: Make this binary data safe.
+	free( str );
 }
 
 
@@ -769,7 +876,11 @@ LEOInteger LEOGetNumberValueAsInteger( LEOValuePtr self, struct LEOContext* inCo
 const char* LEOGetNumberValueAsString( LEOValuePtr self, char* outBuf, size_t bufSize, struct LEOContext* inContext )
 {
 	if( outBuf )	// Can never return as a string if we're not given a buffer.
-		snprintf( outBuf, bufSize -1, "%g", self->number.number );
+	{
+		char	numStr[LEO_NUMBER_STRING_MAX_LENGTH];
+		size_t	numLen = LEOFormatNumber( self->number.number, numStr );
+		LEOCopyNumberStringToBuffer( numStr, numLen, outBuf, bufSize );
+	}
 	return outBuf;
 }
 
@@ -802,9 +913,8 @@ void LEOSetNumberValueAsInteger( LEOValuePtr self, LEOInteger inInteger, struct
 
 void LEOSetNumberValueAsString( LEOValuePtr self, const char* inNumber, struct LEOContext* inContext )
 {
-	char*		endPtr = NULL;
-	LEONumber	theNum = strtod( inNumber, &endPtr );
-	if( endPtr != (inNumber +strlen(inNumber)) )
+	LEONumber	theNum = 0;
+	if( *LEOParseNumber( inNumber, &theNum ) != 0 )
 		LEOCantSetValueAsString( self, inNumber, inContext );
 	else
 		self->number.number = theNum;
@@ -890,7 +1000,11 @@ LEOInteger LEOGetIntegerValueAsInteger( LEOValuePtr self, struct LEOContext* inC
 const char*	LEOGetIntegerValueAsString( LEOValuePtr self, char* outBuf, size_t bufSize, struct LEOContext* inContext )
 {
 	if( outBuf )	// Can never return as string without buffer.
-		snprintf( outBuf, bufSize -1, "%lld", self->integer.integer );
+	{
+		char	numStr[LEO_NUMBER_STRING_MAX_LENGTH];
+		size_t	numLen = LEOFormatInteger( self->integer.integer, numStr );
+		LEOCopyNumberStringToBuffer( numStr, numLen, outBuf, bufSize );
+	}
 	return outBuf;
 }
 
@@ -928,9 +1042,8 @@ void LEOSetIntegerValueAsInteger( LEOValuePtr self, LEOInteger inInteger, struct
 
 void LEOSetIntegerValueAsString( LEOValuePtr self, const char* inInteger, struct LEOContext* inContext )
 {
-	char*		endPtr = NULL;
-	LEOInteger	theNum = strtoll( inInteger, &endPtr, 10 );
-	if( endPtr != (inInteger +strlen(inInteger)) )
+	LEOInteger	theNum = 0;
+	if( *LEOParseInteger( inInteger, &theNum ) != 0 )
 		LEOCantSetValueAsString( self, inInteger, inContext );
 	else
 		self->integer.integer = theNum;
@@ -980,13 +1093,173 @@ void	LEOCleanUpIntegerValue( LEOValuePtr self, LEOKeepReferencesFlag keepReferen
 	@functiongroup LEOValueString
 */
 
+/*!
+	Heap string buffers are preceded by a reference count, so copies of a
+	string value can share the same buffer, and by their size, so the
+	context's statistics can tell how much memory was given back. Setters
+	only overwrite a buffer in place if it isn't shared (see
+	LEOReuseOrAllocStringBuffer), otherwise they build the new string in a
+	new buffer and then free the old one, so sharing needs no further
+	precautions.
+	
+	Arena buffers have the same header, but their reference count is
+	LEO_STRING_BUFFER_TRANSIENT and the second field is the arena they came
+	from, so they can be told apart and given back to the right arena no
+	matter which context a value is cleaned up through.
+*/
+
+#define LEOStringBufferHeaderSize				(2 * sizeof(size_t))
+#define LEOStringBufferReferenceCount(b)		(((size_t*)((b) -LEOStringBufferHeaderSize))[0])
+#define LEOStringBufferSize(b)					(((size_t*)((b) -LEOStringBufferHeaderSize))[1])
+#define LEOStringBufferArena(b)					(((LEOArena**)((b) -LEOStringBufferHeaderSize))[1])
+
+#define LEO_STRING_BUFFER_TRANSIENT				SIZE_MAX	// Reference count of arena buffers, which are never shared.
+
+#define LEO_STRING_BUFFER_MAX_UNUSED_FACTOR		4	// Once a reused buffer would be more than this many times as large as needed, we shrink it.
+#define LEO_STRING_BUFFER_MIN_REUSED_SIZE		64	// Buffers up to this size are always reused if the string fits, not worth shrinking.
+
+
+/*!
+	Allocate a buffer for a string value. If inTransient is TRUE and the
+	context has an arena, the buffer comes from the arena, otherwise from the
+	heap. Arena buffers are not zeroed, so callers must terminate the string.
+*/
+
+static char*	LEOAllocStringBuffer( size_t inSize, bool inTransient, struct LEOContext* inContext )
+{
+	char*	theBuf = NULL;
+	if( inTransient && inContext && inContext->arena )
+	{
+		theBuf = LEOArenaAllocate( inContext->arena, LEOStringBufferHeaderSize +inSize );
+		if( theBuf )
+		{
+			theBuf += LEOStringBufferHeaderSize;
+			LEOStringBufferReferenceCount( theBuf ) = LEO_STRING_BUFFER_TRANSIENT;
+			LEOStringBufferArena( theBuf ) = inContext->arena;
+		}
+	}
+	if( !theBuf )
+	{
+		theBuf = calloc( LEOStringBufferHeaderSize +inSize, sizeof(char) );
+		theBuf += LEOStringBufferHeaderSize;
+		LEOStringBufferReferenceCount( theBuf ) = 1;
+		LEOStringBufferSize( theBuf ) = inSize;
+		if( inContext )
+		{
+			inContext->statistics.numStringsAllocated ++;
+			inContext->statistics.numStringBytesAllocated += inSize;
+		}
+	}
+	return theBuf;
+}
+
+
+/*!
+	Returns TRUE if the given string buffer was allocated from a context's
+	arena. Buffers derived from such a string are allocated there as well.
+*/
+
+static bool	LEOIsTransientStringBuffer( const char* inBuf )
+{
+	return( inBuf && LEOStringBufferReferenceCount( inBuf ) == LEO_STRING_BUFFER_TRANSIENT );
+}
+
+
+/*!
+	Free a buffer allocated using LEOAllocStringBuffer. If the buffer is shared
+	with other string values, this only gives up our claim on it.
+*/
+
+static void	LEOFreeStringBuffer( char* inBuf, struct LEOContext* inContext )
+{
+	if( LEOIsTransientStringBuffer( inBuf ) )
+		LEOArenaRelease( LEOStringBufferArena( inBuf ), inBuf -LEOStringBufferHeaderSize );
+	else if( inBuf && --LEOStringBufferReferenceCount( inBuf ) == 0 )
+	{
+		if( inContext )
+			inContext->statistics.numStringBytesFreed += LEOStringBufferSize( inBuf );
+		free( inBuf -LEOStringBufferHeaderSize );
+	}
+}
+
+
+/*!
+	Returns a buffer of inSize bytes for the new string of a string value
+	whose current buffer is inOldBuf. If nobody else uses inOldBuf and the
+	new string fits, that is inOldBuf itself, so assigning similar strings to
+	a variable over and over doesn't allocate. Otherwise it's a new buffer
+	(from the arena if inOldBuf is from there), and the caller must free
+	inOldBuf after copying the new string over, as the new string may be
+	part of the old one.
+*/
+
+static char*	LEOReuseOrAllocStringBuffer( char* inOldBuf, size_t inSize, struct LEOContext* inContext )
+{
+	bool	isTransient = LEOIsTransientStringBuffer( inOldBuf );
+	if( inOldBuf && !isTransient && LEOStringBufferReferenceCount( inOldBuf ) == 1 )
+	{
+		size_t	oldSize = LEOStringBufferSize( inOldBuf );
+		if( oldSize >= inSize
+			&& (oldSize <= LEO_STRING_BUFFER_MIN_REUSED_SIZE || oldSize <= inSize * LEO_STRING_BUFFER_MAX_UNUSED_FACTOR) )
+		{
+			return inOldBuf;
+		}
+	}
+	
+	return LEOAllocStringBuffer( inSize, isTransient, inContext );
+}
+
+
+/*!
+	Returns a buffer containing the same string as inBuf, which was allocated
+	using LEOAllocStringBuffer, for use by another string value. Heap buffers
+	are simply shared, while arena buffers are copied onto the heap, as the
+	copy may outlive the stack.
+*/
+
+static char*	LEOShareStringBuffer( char* inBuf, struct LEOContext* inContext )
+{
+	if( LEOIsTransientStringBuffer( inBuf ) )
+	{
+		size_t		theLen = strlen( inBuf ) +1;
+		char*		newStr = LEOAllocStringBuffer( theLen, false, inContext );
+		memmove( newStr, inBuf, theLen );
+		return newStr;
+	}
+	
+	LEOStringBufferReferenceCount( inBuf ) ++;
+	return inBuf;
+}
+
+
 void	LEOInitStringValue( LEOValuePtr inStorage, const char* inString, size_t inLen, LEOKeepReferencesFlag keepReferences, struct LEOContext* inContext )
 {
 	inStorage->base.isa = &kLeoValueTypeString;
 	if( keepReferences == kLEOInvalidateReferences )
+	{
+		inStorage->base.refObjectID = kLEOObjectIDINVALID;
+		inStorage->base.changeCount = 0;
+	}
+	else
+		inStorage->base.changeCount ++;	// Chunk references to us may have cached offsets into our old string.
+	inStorage->string.string = LEOAllocStringBuffer( inLen +1, false, inContext );
+	memmove( inStorage->string.string, inString, inLen );
+}
+
+
+void	LEOInitTransientStringValue( LEOValuePtr inStorage, const char* inString, size_t inLen, LEOKeepReferencesFlag keepReferences, struct LEOContext* inContext )
+{
+	inStorage->base.isa = &kLeoValueTypeString;
+	if( keepReferences == kLEOInvalidateReferences )
+	{
 		inStorage->base.refObjectID = kLEOObjectIDINVALID;
-	inStorage->string.string = calloc( inLen +1, sizeof(char) );
+		inStorage->base.changeCount = 0;
+	}
+	else
+		inStorage->base.changeCount ++;	// Chunk references to us may have cached offsets into our old string.
+	inStorage->string.string = LEOAllocStringBuffer( inLen +1, true, inContext );
 	memmove( inStorage->string.string, inString, inLen );
+	inStorage->string.string[inLen] = 0;
 }
 
 
@@ -998,9 +1271,8 @@ void	LEOInitStringValue( LEOValuePtr inStorage, const char* inString, size_t inL
 
 LEONumber	LEOGetStringValueAsNumber( LEOValuePtr self, struct LEOContext* inContext )
 {
-	char*		endPtr = NULL;
-	LEONumber	num = strtod( self->string.string, &endPtr );
-	if( endPtr != (self->string.string +strlen(self->string.string)) )
+	LEONumber	num = 0;
+	if( *LEOParseNumber( self->string.string, &num ) != 0 )
 		LEOCantGetValueAsNumber( self, inContext );
 	return num;
 }
@@ -1014,9 +1286,8 @@ LEONumber	LEOGetStringValueAsNumber( LEOValuePtr self, struct LEOContext* inCont
 
 LEOInteger	LEOGetStringValueAsInteger( LEOValuePtr self, struct LEOContext* inContext )
 {
-	char*		endPtr = NULL;
-	LEOInteger	num = strtoll( self->string.string, &endPtr, 10 );
-	if( endPtr != (self->string.string +strlen(self->string.string)) )
+	LEOInteger	num = 0;
+	if( *LEOParseInteger( self->string.string, &num ) != 0 )
 		LEOCantGetValueAsInteger( self, inContext );
 	return num;
 }
@@ -1040,10 +1311,14 @@ const char*	LEOGetStringValueAsString( LEOValuePtr self, char* outBuf, size_t bu
 
 void	LEOSetStringValueAsNumber( LEOValuePtr self, LEONumber inNumber, struct LEOContext* inContext )
 {
-	if( self->string.string )
-		free( self->string.string );
-	self->string.string = calloc( OTHER_VALUE_SHORT_STRING_MAX_LENGTH, sizeof(char) );
-	snprintf( self->string.string, OTHER_VALUE_SHORT_STRING_MAX_LENGTH, "%g", inNumber );
+	char	numStr[LEO_NUMBER_STRING_MAX_LENGTH];
+	size_t	numLen = LEOFormatNumber( inNumber, numStr );
+	char*	newStr = LEOReuseOrAllocStringBuffer( self->string.string, numLen +1, inContext );
+	memcpy( newStr, numStr, numLen +1 );
+	if( newStr != self->string.string )
+		LEOFreeStringBuffer( self->string.string, inContext );
+	self->string.string = newStr;
+	self->base.changeCount ++;
 }
 
 
@@ -1053,10 +1328,14 @@ void	LEOSetStringValueAsNumber( LEOValuePtr self, LEONumber inNumber, struct LEO
 
 void	LEOSetStringValueAsInteger( LEOValuePtr self, LEOInteger inInteger, struct LEOContext* inContext )
 {
-	if( self->string.string )
-		free( self->string.string );
-	self->string.string = calloc( OTHER_VALUE_SHORT_STRING_MAX_LENGTH, sizeof(char) );
-	snprintf( self->string.string, OTHER_VALUE_SHORT_STRING_MAX_LENGTH, "%lld", inInteger );
+	char	numStr[LEO_NUMBER_STRING_MAX_LENGTH];
+	size_t	numLen = LEOFormatInteger( inInteger, numStr );
+	char*	newStr = LEOReuseOrAllocStringBuffer( self->string.string, numLen +1, inContext );
+	memcpy( newStr, numStr, numLen +1 );
+	if( newStr != self->string.string )
+		LEOFreeStringBuffer( self->string.string, inContext );
+	self->string.string = newStr;
+	self->base.changeCount ++;
 }
 
 
@@ -1108,11 +1387,13 @@ void	LEOGetStringValueAsRangeOfString( LEOValuePtr self, LEOChunkType inType,
 
 void LEOSetStringValueAsString( LEOValuePtr self, const char* inString, struct LEOContext* inContext )
 {
-	if( self->string.string )
-		free( self->string.string );
 	size_t		theLen = strlen(inString) +1;
-	self->string.string = calloc( theLen, sizeof(char) );
-	strncpy( self->string.string, inString, theLen );
+	char*		newStr = LEOReuseOrAllocStringBuffer( self->string.string, theLen, inContext );
+	memmove( newStr, inString, theLen );	// memmove() because inString may be part of our own buffer.
+	if( newStr != self->string.string )
+		LEOFreeStringBuffer( self->string.string, inContext );
+	self->string.string = newStr;
+	self->base.changeCount ++;
 }
 
 
@@ -1136,11 +1417,11 @@ void LEOSetStringValueAsBoolean( LEOValuePtr self, bool inBoolean, struct LEOCon
 
 void LEOSetStringValueAsStringConstant( LEOValuePtr self, const char* inString, struct LEOContext* inContext )
 {
-	if( self->string.string )
-		free( self->string.string );
+	LEOFreeStringBuffer( self->string.string, inContext );
 	
 	self->base.isa = &kLeoValueTypeStringConstant;
 	self->string.string = (char*) inString;
+	self->base.changeCount ++;
 }
 
 
@@ -1152,10 +1433,13 @@ void	LEOInitStringValueCopy( LEOValuePtr self, LEOValuePtr dest, LEOKeepReferenc
 {
 	dest->base.isa = &kLeoValueTypeString;
 	if( keepReferences == kLEOInvalidateReferences )
+	{
 		dest->base.refObjectID = kLEOObjectIDINVALID;
-	size_t		theLen = strlen( self->string.string ) +1;
-	dest->string.string = calloc( theLen, sizeof(char) );
-	strncpy( dest->string.string, self->string.string, theLen );
+		dest->base.changeCount = 0;
+	}
+	else
+		dest->base.changeCount ++;	// Chunk references to us may have cached offsets into our old string.
+	dest->string.string = LEOShareStringBuffer( self->string.string, inContext );	// Copied once one of us is changed.
 }
 
 
@@ -1223,15 +1507,16 @@ void	LEOSetStringValueRangeAsString( LEOValuePtr self, LEOChunkType inType,
 	size_t		chunkLen = outChunkEnd -outChunkStart;
 	finalLen = selfLen -chunkLen +inBufLen;
 		
-	char*		newStr = calloc( finalLen +1, sizeof(char) );
+	char*		newStr = LEOAllocStringBuffer( finalLen +1, LEOIsTransientStringBuffer( self->string.string ), inContext );
 	memmove( newStr, self->string.string, outChunkStart );	// Copy before chunk.
 	if( inBufLen > 0 )
 		memmove( newStr +outChunkStart, inBuf, inBufLen );	// Copy new value of chunk.
 	memmove( newStr +outChunkStart +inBufLen, self->string.string +outChunkEnd, selfLen -outChunkEnd );	// Copy after chunk.
 	newStr[finalLen] = 0;
 	
-	free( self->string.string );
+	LEOFreeStringBuffer( self->string.string, inContext );
 	self->string.string = newStr;
+	self->base.changeCount ++;
 }
 
 
@@ -1249,15 +1534,16 @@ void	LEOSetStringValuePredeterminedRangeAsString( LEOValuePtr self,
 				chunkLen = inRangeEnd -inRangeStart;
 	finalLen = selfLen -chunkLen +inBufLen;
 		
-	char*		newStr = calloc( finalLen +1, sizeof(char) );
+	char*		newStr = LEOAllocStringBuffer( finalLen +1, LEOIsTransientStringBuffer( self->string.string ), inContext );
 	memmove( newStr, self->string.string, inRangeStart );	// Copy before chunk.
 	if( inBufLen > 0 )
 		memmove( newStr +inRangeStart, inBuf, inBufLen );	// Copy new value of chunk.
 	memmove( newStr +inRangeStart +inBufLen, self->string.string +inRangeEnd, selfLen -inRangeEnd );	// Copy after chunk.
 	newStr[finalLen] = 0;
 	
-	free( self->string.string );
+	LEOFreeStringBuffer( self->string.string, inContext );
 	self->string.string = newStr;
+	self->base.changeCount ++;
 }
 
 
@@ -1269,9 +1555,9 @@ void	LEOSetStringValuePredeterminedRangeAsString( LEOValuePtr self,
 void	LEOCleanUpStringValue( LEOValuePtr self, LEOKeepReferencesFlag keepReferences, struct LEOContext* inContext )
 {
 	self->base.isa = NULL;
-	if( self->string.string )
-		free( self->string.string );
+	LEOFreeStringBuffer( self->string.string, inContext );
 	self->string.string = NULL;
+	self->base.changeCount ++;
 	if( keepReferences == kLEOInvalidateReferences && self->base.refObjectID != kLEOObjectIDINVALID )
 	{
 		LEOContextGroupRecycleObjectID( inContext->group, self->base.refObjectID );
@@ -1306,7 +1592,12 @@ void	LEOInitStringConstantValue( LEOValuePtr inStorage, const char* inString, LE
 {
 	inStorage->base.isa = &kLeoValueTypeStringConstant;
 	if( keepReferences == kLEOInvalidateReferences )
+	{
 		inStorage->base.refObjectID = kLEOObjectIDINVALID;
+		inStorage->base.changeCount = 0;
+	}
+	else
+		inStorage->base.changeCount ++;	// Chunk references to us may have cached offsets into our old string.
 	inStorage->string.string = (char*)inString;
 }
 
@@ -1319,9 +1610,12 @@ void	LEOInitStringConstantValue( LEOValuePtr inStorage, const char* inString, LE
 void	LEOSetStringConstantValueAsNumber( LEOValuePtr self, LEONumber inNumber, struct LEOContext* inContext )
 {
 	// Turn this into a non-constant string:
+	char	numStr[LEO_NUMBER_STRING_MAX_LENGTH];
+	size_t	numLen = LEOFormatNumber( inNumber, numStr );
 	self->base.isa = &kLeoValueTypeString;
-	self->string.string = calloc( OTHER_VALUE_SHORT_STRING_MAX_LENGTH, sizeof(char) );
-	snprintf( self->string.string, OTHER_VALUE_SHORT_STRING_MAX_LENGTH, "%g", inNumber );
+	self->string.string = LEOAllocStringBuffer( numLen +1, false, inContext );
+	self->base.changeCount ++;
+	memcpy( self->string.string, numStr, numLen +1 );
 }
 
 
@@ -1333,9 +1627,12 @@ void	LEOSetStringConstantValueAsNumber( LEOValuePtr self, LEONumber inNumber, st
 void	LEOSetStringConstantValueAsInteger( LEOValuePtr self, LEOInteger inInteger, struct LEOContext* inContext )
 {
 	// Turn this into a non-constant string:
+	char	numStr[LEO_NUMBER_STRING_MAX_LENGTH];
+	size_t	numLen = LEOFormatInteger( inInteger, numStr );
 	self->base.isa = &kLeoValueTypeString;
-	self->string.string = calloc( OTHER_VALUE_SHORT_STRING_MAX_LENGTH, sizeof(char) );
-	snprintf( self->string.string, OTHER_VALUE_SHORT_STRING_MAX_LENGTH, "%lld", inInteger );
+	self->string.string = LEOAllocStringBuffer( numLen +1, false, inContext );
+	self->base.changeCount ++;
+	memcpy( self->string.string, numStr, numLen +1 );
 }
 
 
@@ -1349,7 +1646,8 @@ void	LEOSetStringConstantValueAsString( LEOValuePtr self, const char* inString,
 	// Turn this into a non-constant string:
 	self->base.isa = &kLeoValueTypeString;
 	size_t		theLen = strlen(inString) +1;
-	self->string.string = calloc( theLen, sizeof(char) );
+	self->string.string = LEOAllocStringBuffer( theLen, false, inContext );
+	self->base.changeCount ++;
 	strncpy( self->string.string, inString, theLen );
 }
 
@@ -1361,6 +1659,7 @@ void	LEOSetStringConstantValueAsString( LEOValuePtr self, const char* inString,
 void	LEOSetStringConstantValueAsBoolean( LEOValuePtr self, bool inBoolean, struct LEOContext* inContext )
 {
 	self->string.string = (inBoolean ? "true" : "false");
+	self->base.changeCount ++;
 }
 
 
@@ -1372,7 +1671,12 @@ void	LEOInitStringConstantValueCopy( LEOValuePtr self, LEOValuePtr dest, LEOKeep
 {
 	dest->base.isa = &kLeoValueTypeStringConstant;
 	if( keepReferences == kLEOInvalidateReferences )
+	{
 		dest->base.refObjectID = kLEOObjectIDINVALID;
+		dest->base.changeCount = 0;
+	}
+	else
+		dest->base.changeCount ++;	// Chunk references to us may have cached offsets into our old string.
 	dest->string.string = self->string.string;
 }
 
@@ -1405,7 +1709,7 @@ void	LEOSetStringConstantValueRangeAsString( LEOValuePtr self, LEOChunkType inTy
 	size_t		chunkLen = outChunkEnd -outChunkStart;
 	finalLen = selfLen -chunkLen +inBufLen;
 		
-	char*		newStr = calloc( finalLen +1, sizeof(char) );
+	char*		newStr = LEOAllocStringBuffer( finalLen +1, false, inContext );
 	memmove( newStr, self->string.string, outChunkStart );	// Copy before chunk.
 	if( inBufLen > 0 )
 		memmove( newStr +outChunkStart, inBuf, inBufLen );	// Copy new value of chunk.
@@ -1415,6 +1719,7 @@ void	LEOSetStringConstantValueRangeAsString( LEOValuePtr self, LEOChunkType inTy
 	// Turn this into a non-constant string:
 	self->base.isa = &kLeoValueTypeString;
 	self->string.string = newStr;
+	self->base.changeCount ++;
 }
 
 
@@ -1440,6 +1745,7 @@ void	LEOCleanUpStringConstantValue( LEOValuePtr self, LEOKeepReferencesFlag keep
 {
 	self->base.isa = NULL;
 	self->string.string = NULL;
+	self->base.changeCount ++;
 	if( keepReferences == kLEOInvalidateReferences && self->base.refObjectID != kLEOObjectIDINVALID )
 	{
 		LEOContextGroupRecycleObjectID( inContext->group, self->base.refObjectID );
@@ -1578,9 +1884,16 @@ void	LEOInitReferenceValue( LEOValuePtr self, LEOValuePtr originalValue, LEOKeep
 	self->reference.objectID = originalValue->base.refObjectID;
 	self->reference.objectSeed = LEOContextGroupGetSeedForObjectID( inContext->group, originalValue->base.refObjectID );
 	
-	self->reference.chunkType = inType;
-	self->reference.chunkStart = startOffs;
-	self->reference.chunkEnd = endOffs;
+	self->reference.chunk = NULL;
+	if( inType != kLEOChunkTypeINVALID )
+	{
+		self->reference.chunk = malloc( sizeof(struct LEOReferenceChunk) );
+		self->reference.chunk->referenceCount = 1;
+		self->reference.chunk->chunkType = inType;
+		self->reference.chunk->chunkStart = startOffs;
+		self->reference.chunk->chunkEnd = endOffs;
+		self->reference.chunk->cachedString = NULL;
+	}
 }
 
 
@@ -1594,9 +1907,65 @@ void	LEOInitReferenceValueWithIDs( LEOValuePtr self, LEOObjectID referencedObjec
 	self->reference.objectID = referencedObjectID;
 	self->reference.objectSeed = referencedObjectSeed;
 	
-	self->reference.chunkType = kLEOChunkTypeINVALID;
-	self->reference.chunkStart = 0;
-	self->reference.chunkEnd = 0;
+	self->reference.chunk = NULL;
+}
+
+
+/*!
+	Look up the byte range the chunk of the given chunk reference currently
+	covers in theValue, the value it refers to. If theValue is a string, the
+	result is remembered in the reference's chunk and reused until the string
+	(or the item delimiter) changes, so repeated accesses to the same item of
+	a long string don't each re-scan it from the start.
+	Returns FALSE (and does nothing) for any other kind of value, the caller
+	should then use the regular chunk functions.
+*/
+
+static bool	LEOGetReferenceChunkByteRange( LEOValuePtr self, LEOValuePtr theValue, size_t *outBytesStart, size_t *outBytesEnd,
+											size_t *outBytesDelStart, size_t *outBytesDelEnd, struct LEOContext* inContext )
+{
+	if( theValue->base.isa->tag != kLEOValueTypeTagString )
+		return false;
+	
+	struct LEOReferenceChunk*	chunk = self->reference.chunk;
+	if( chunk->cachedString != theValue->string.string || chunk->cachedChangeCount != theValue->base.changeCount
+		|| chunk->cachedDelimiter != inContext->itemDelimiter )
+	{
+		LEOGetChunkRanges( theValue->string.string, chunk->chunkType, chunk->chunkStart, chunk->chunkEnd,
+							&chunk->cachedBytesStart, &chunk->cachedBytesEnd,
+							&chunk->cachedBytesDelStart, &chunk->cachedBytesDelEnd, inContext->itemDelimiter );
+		chunk->cachedString = theValue->string.string;
+		chunk->cachedChangeCount = theValue->base.changeCount;
+		chunk->cachedDelimiter = inContext->itemDelimiter;
+	}
+	
+	*outBytesStart = chunk->cachedBytesStart;
+	*outBytesEnd = chunk->cachedBytesEnd;
+	*outBytesDelStart = chunk->cachedBytesDelStart;
+	*outBytesDelEnd = chunk->cachedBytesDelEnd;
+	
+	return true;
+}
+
+
+/*!
+	Copy the text of the chunk the given chunk reference refers to in theValue
+	into outBuf, using the cached byte range where possible.
+*/
+
+static void	LEOGetReferenceChunkAsString( LEOValuePtr self, LEOValuePtr theValue, char* outBuf, size_t bufSize, struct LEOContext* inContext )
+{
+	size_t		bytesStart = 0, bytesEnd = 0, bytesDelStart = 0, bytesDelEnd = 0;
+	if( LEOGetReferenceChunkByteRange( self, theValue, &bytesStart, &bytesEnd, &bytesDelStart, &bytesDelEnd, inContext ) )
+	{
+		size_t		len = bytesEnd -bytesStart;
+		if( len >= bufSize )
+			len = bufSize -1;
+		memmove( outBuf, theValue->string.string +bytesStart, len );
+		outBuf[len] = 0;
+	}
+	else
+		LEOGetValueAsRangeOfString( theValue, self->reference.chunk->chunkType, self->reference.chunk->chunkStart, self->reference.chunk->chunkEnd, outBuf, bufSize, inContext );
 }
 
 
@@ -1612,9 +1981,10 @@ const char*	LEOGetReferenceValueAsString( LEOValuePtr self, char* outBuf, size_t
 	{
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
-		LEOGetValueAsRangeOfString( theValue, self->reference.chunkType, self->reference.chunkStart, self->reference.chunkEnd, outBuf, bufSize, inContext );
+		if( outBuf )	// Chunks always need to be copied, so without a buffer we return NULL.
+			LEOGetReferenceChunkAsString( self, theValue, outBuf, bufSize, inContext );
 	}
 	else
 		theStr = LEOGetValueAsString( theValue, outBuf, bufSize, inContext );
@@ -1635,13 +2005,12 @@ LEONumber	LEOGetReferenceValueAsNumber( LEOValuePtr self, struct LEOContext* inC
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 		return 0.0;
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
 		char		str[OTHER_VALUE_SHORT_STRING_MAX_LENGTH] = {0};	// Can get away with this as long as they're only numbers, booleans etc.
-		LEOGetValueAsRangeOfString( theValue, self->reference.chunkType, self->reference.chunkStart, self->reference.chunkEnd, str, sizeof(str), inContext );
-		char*		endPtr = NULL;
-		LEONumber	num = strtod( str, &endPtr );
-		if( endPtr != (str +strlen(str)) )
+		LEOGetReferenceChunkAsString( self, theValue, str, sizeof(str), inContext );
+		LEONumber	num = 0;
+		if( *LEOParseNumber( str, &num ) != 0 )
 			LEOCantGetValueAsNumber( self, inContext );
 		return num;
 	}
@@ -1662,13 +2031,12 @@ LEOInteger	LEOGetReferenceValueAsInteger( LEOValuePtr self, struct LEOContext* i
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 		return 0LL;
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
 		char		str[OTHER_VALUE_SHORT_STRING_MAX_LENGTH] = {0};	// Can get away with this as long as they're only numbers, booleans etc.
-		LEOGetValueAsRangeOfString( theValue, self->reference.chunkType, self->reference.chunkStart, self->reference.chunkEnd, str, sizeof(str), inContext );
-		char*		endPtr = NULL;
-		LEOInteger	num = strtoll( str, &endPtr, 10 );
-		if( endPtr != (str +strlen(str)) )
+		LEOGetReferenceChunkAsString( self, theValue, str, sizeof(str), inContext );
+		LEOInteger	num = 0;
+		if( *LEOParseInteger( str, &num ) != 0 )
 			LEOCantGetValueAsInteger( self, inContext );
 		return num;
 	}
@@ -1689,10 +2057,10 @@ bool	LEOGetReferenceValueAsBoolean( LEOValuePtr self, struct LEOContext* inConte
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 		return false;
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
 		char		str[OTHER_VALUE_SHORT_STRING_MAX_LENGTH] = {0};	// Can get away with this as long as they're only numbers, booleans etc.
-		LEOGetValueAsRangeOfString( theValue, self->reference.chunkType, self->reference.chunkStart, self->reference.chunkEnd, str, sizeof(str), inContext );
+		LEOGetReferenceChunkAsString( self, theValue, str, sizeof(str), inContext );
 		if( strcasecmp( str, "true" ) == 0 )
 			return true;
 		else if( strcasecmp( str, "false" ) == 0 )
@@ -1718,7 +2086,7 @@ void	LEOGetReferenceValueAsRangeOfString( LEOValuePtr self, LEOChunkType inType,
 	{
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
 		size_t		chunkStart = 0, chunkEnd = SIZE_MAX, chunkDelStart, chunkDelEnd;
 		LEODetermineChunkRangeOfSubstring( self, &chunkStart, &chunkEnd, &chunkDelStart, &chunkDelEnd,
@@ -1741,11 +2109,12 @@ void	LEOSetReferenceValueAsString( LEOValuePtr self, const char* inString, struc
 	{
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
 		size_t		chunkStart = 0, chunkEnd = SIZE_MAX, chunkDelStart, chunkDelEnd;
-		LEODetermineChunkRangeOfSubstring( theValue, &chunkStart, &chunkEnd, &chunkDelStart, &chunkDelEnd,
-											self->reference.chunkType, self->reference.chunkStart, self->reference.chunkEnd, inContext );
+		if( !LEOGetReferenceChunkByteRange( self, theValue, &chunkStart, &chunkEnd, &chunkDelStart, &chunkDelEnd, inContext ) )
+			LEODetermineChunkRangeOfSubstring( theValue, &chunkStart, &chunkEnd, &chunkDelStart, &chunkDelEnd,
+												self->reference.chunk->chunkType, self->reference.chunk->chunkStart, self->reference.chunk->chunkEnd, inContext );
 		LEOSetValuePredeterminedRangeAsString( theValue, chunkStart, chunkEnd, inString, inContext );
 	}
 	else
@@ -1764,9 +2133,9 @@ void	LEOSetReferenceValueAsBoolean( LEOValuePtr self, bool inBoolean, struct LEO
 	{
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
-		LEOSetValueRangeAsString( theValue, self->reference.chunkType, self->reference.chunkStart, self->reference.chunkEnd,
+		LEOSetValueRangeAsString( theValue, self->reference.chunk->chunkType, self->reference.chunk->chunkStart, self->reference.chunk->chunkEnd,
 									(inBoolean) ? "true" : "false", inContext );
 	}
 	else
@@ -1785,11 +2154,11 @@ void	LEOSetReferenceValueAsNumber( LEOValuePtr self, LEONumber inNumber, struct
 	{
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
-		char		str[OTHER_VALUE_SHORT_STRING_MAX_LENGTH] = {0};	// Can get away with this as long as they're only numbers, booleans etc.
-		snprintf( str, sizeof(str), "%g", inNumber );
-		LEOSetValueRangeAsString( theValue, self->reference.chunkType, self->reference.chunkStart, self->reference.chunkEnd,
+		char		str[LEO_NUMBER_STRING_MAX_LENGTH] = {0};
+		LEOFormatNumber( inNumber, str );
+		LEOSetValueRangeAsString( theValue, self->reference.chunk->chunkType, self->reference.chunk->chunkStart, self->reference.chunk->chunkEnd,
 									str, inContext );
 	}
 	else
@@ -1808,11 +2177,11 @@ void	LEOSetReferenceValueAsInteger( LEOValuePtr self, LEOInteger inInteger, stru
 	{
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
-		char		str[OTHER_VALUE_SHORT_STRING_MAX_LENGTH] = {0};	// Can get away with this as long as they're only numbers, booleans etc.
-		snprintf( str, sizeof(str), "%lld", inInteger );
-		LEOSetValueRangeAsString( theValue, self->reference.chunkType, self->reference.chunkStart, self->reference.chunkEnd,
+		char		str[LEO_NUMBER_STRING_MAX_LENGTH] = {0};
+		LEOFormatInteger( inInteger, str );
+		LEOSetValueRangeAsString( theValue, self->reference.chunk->chunkType, self->reference.chunk->chunkStart, self->reference.chunk->chunkEnd,
 									str, inContext );
 	}
 	else
@@ -1831,11 +2200,11 @@ void		LEOSetReferenceValueAsArray( LEOValuePtr self, struct LEOArrayEntry * inAr
 	{
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
-		char		str[1024] = {0};	// TODO: Make this work for all lengths.
-		LEOPrintArray( inArray, str, sizeof(str), inContext );
-		LEOSetValueRangeAsString( theValue, self->reference.chunkType, self->reference.chunkStart, self->reference.chunkEnd, str, inContext );
+		char*		str = LEOCopyArrayAsString( inArray, NULL, inContext );
+		LEOSetValueRangeAsString( theValue, self->reference.chunk->chunkType, self->reference.chunk->chunkStart, self->reference.chunk->chunkEnd, str, inContext );
+		free( str );
 	}
 	else
 		LEOSetValueAsArray( theValue, inArray, inContext );
@@ -1855,7 +2224,7 @@ void	LEOSetReferenceValueRangeAsString( LEOValuePtr self, LEOChunkType inType,
 	{
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
 		size_t		chunkStart = 0, chunkEnd = SIZE_MAX, chunkDelStart, chunkDelEnd;
 		LEODetermineChunkRangeOfSubstring( self, &chunkStart, &chunkEnd, &chunkDelStart, &chunkDelEnd,
@@ -1897,9 +2266,9 @@ void	LEOInitReferenceValueCopy( LEOValuePtr self, LEOValuePtr dest, LEOKeepRefer
 	dest->reference.objectID = self->reference.objectID;
 	dest->reference.objectSeed = self->reference.objectSeed;
 	
-	dest->reference.chunkType = self->reference.chunkType;
-	dest->reference.chunkStart = self->reference.chunkStart;
-	dest->reference.chunkEnd = self->reference.chunkEnd;
+	dest->reference.chunk = self->reference.chunk;	// Never changed after creation, so copies can share it.
+	if( dest->reference.chunk )
+		dest->reference.chunk->referenceCount ++;
 }
 
 
@@ -1942,12 +2311,12 @@ void	LEODetermineChunkRangeOfSubstringOfReferenceValue( LEOValuePtr self, size_t
 	{
 		LEOContextStopWithError( inContext, "The referenced value doesn't exist anymore." );
 	}
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 	{
 		size_t		bytesStart = 0, bytesEnd = SIZE_MAX,
 					bytesDelStart, bytesDelEnd; 
 		LEODetermineChunkRangeOfSubstring( theValue, &bytesStart, &bytesEnd, &bytesDelStart, &bytesDelEnd,
-											self->reference.chunkType, self->reference.chunkStart, self->reference.chunkEnd, inContext );
+											self->reference.chunk->chunkType, self->reference.chunk->chunkStart, self->reference.chunk->chunkEnd, inContext );
 		LEODetermineChunkRangeOfSubstring( theValue, &bytesStart, &bytesEnd, &bytesDelStart, &bytesDelEnd,
 											kLEOChunkTypeByte, *ioBytesStart, *ioBytesEnd, inContext );
 		LEODetermineChunkRangeOfSubstring( theValue, &bytesStart, &bytesEnd, &bytesDelStart, &bytesDelEnd,
@@ -1986,6 +2355,9 @@ void	LEOCleanUpReferenceValue( LEOValuePtr self, LEOKeepReferencesFlag keepRefer
 	self->base.isa = NULL;
 	self->reference.objectID = kLEOObjectIDINVALID;
 	self->reference.objectSeed = 0;
+	if( self->reference.chunk && (--self->reference.chunk->referenceCount) == 0 )
+		free( self->reference.chunk );
+	self->reference.chunk = NULL;
 	if( keepReferences == kLEOInvalidateReferences && self->base.refObjectID != kLEOObjectIDINVALID )	// We have references? Make sure they all notice we've gone if they try to access us from now on.
 	{
 		LEOContextGroupRecycleObjectID( inContext->group, self->base.refObjectID );
@@ -2047,7 +2419,7 @@ LEOValuePtr	LEOReferenceValueFollowReferencesAndReturnValueOfType( LEOValuePtr s
 	}
 	else if( theValue->base.isa == inType )
 		return theValue;
-	else if( self->reference.chunkType != kLEOChunkTypeINVALID )
+	else if( self->reference.chunk != NULL )
 		return NULL;
 	else
 		return LEOFollowReferencesAndReturnValueOfType( theValue, inType, inContext );
@@ -2104,9 +2476,18 @@ void	LEOSetVariantValueAsInteger( LEOValuePtr self, LEOInteger inInteger, struct
 
 void	LEOSetVariantValueAsString( LEOValuePtr self, const char* inString, struct LEOContext* inContext )
 {
+	if( self->base.isa == &kLeoValueTypeStringVariant && !LEOIsTransientStringBuffer( self->string.string ) )
+	{
+		LEOSetStringValueAsString( self, inString, inContext );	// Reuses our buffer if it can.
+		return;
+	}
+	
+	union LEOValue	newValue;	// Copy first, inString may be our own text, e.g. an array's cached string.
+	LEOInitStringValue( &newValue, inString, strlen(inString), kLEOInvalidateReferences, inContext );
 	LEOCleanUpValue( self, kLEOKeepReferences, inContext );
-	LEOInitStringValue( self, inString, strlen(inString), kLEOKeepReferences, inContext );
 	self->base.isa = &kLeoValueTypeStringVariant;
+	self->base.changeCount++;
+	self->string.string = newValue.string.string;
 }
 
 
@@ -2120,9 +2501,9 @@ void	LEOSetVariantValueAsBoolean( LEOValuePtr self, bool inBoolean, struct LEOCo
 
 void	LEOSetVariantValueAsArray( LEOValuePtr self, struct LEOArrayEntry *inArray, struct LEOContext* inContext )
 {
+	struct LEOArrayEntry*	newArray = LEOShareArray( inArray );	// Share first, inArray may be our own array.
 	LEOCleanUpValue( self, kLEOKeepReferences, inContext );
-	LEOInitArrayValue( self, NULL, kLEOKeepReferences, inContext );
-	self->array.array = LEOCopyArray( inArray, inContext );
+	LEOInitArrayValue( self, newArray, kLEOKeepReferences, inContext );
 	self->base.isa = &kLeoValueTypeArrayVariant;
 }
 
@@ -2155,24 +2536,11 @@ void	LEOSetVariantValuePredeterminedRangeAsString( LEOValuePtr self,
 
 void	LEOSetStringVariantValueValueForKey( LEOValuePtr self, const char* inKey, LEOValuePtr inValue, struct LEOContext * inContext )
 {
-	if( self->string.string[0] != 0 )	// Not an empty string
-	{
-		struct LEOArrayEntry	*	convertedArray = LEOCreateArrayFromString( self->string.string, inContext );
-		if( !convertedArray )
-		{
-			LEOContextStopWithError( inContext, "Expected array here, found \"%s\".", self->string.string );
-			return;
-		}
-		
-		LEOCleanUpValue( self, kLEOKeepReferences, inContext );
-		LEOInitArrayValue( self, convertedArray, kLEOKeepReferences, inContext );
-	}
-	else
+	if( !LEOConvertStringValueToArrayVariant( self, inContext ) )
 	{
-		LEOCleanUpValue( self, kLEOKeepReferences, inContext );
-		LEOInitArrayValue( self, NULL, kLEOKeepReferences, inContext );
+		LEOContextStopWithError( inContext, "Expected array here, found \"%s\".", self->string.string );
+		return;
 	}
-	self->base.isa = &kLeoValueTypeArrayVariant;
 	LEOAddArrayEntryToRoot( &self->array.array, inKey, inValue, inContext );
 }
 
@@ -2220,19 +2588,42 @@ void	LEOInitArrayValue( LEOValuePtr self, struct LEOArrayEntry *inArray, LEOKeep
 	if( keepReferences == kLEOInvalidateReferences )
 		self->base.refObjectID = kLEOObjectIDINVALID;
 	self->array.array = inArray;	// *** takes over ownership.
+	self->array.cachedString = NULL;
 }
 
 
-const char*	LEOGetArrayValueAsString( LEOValuePtr self, char* outBuf, size_t bufSize, struct LEOContext* inContext )
+static char*	LEOCopyArrayValueAsString( LEOValuePtr inValue, struct LEOContext* inContext );
+
+
+// Throw away the text an array value made, the array is about to change:
+static void	LEOFlushCachedArrayString( char** ioCachedString )
 {
-	if( !outBuf )
-		return NULL;
+	if( *ioCachedString )
+	{
+		free( *ioCachedString );
+		*ioCachedString = NULL;
+	}
+}
+
+
+// Arrays of both kinds can be any size, so we keep our text around instead of printing into outBuf:
+static const char*	LEOGetCachedArrayString( LEOValuePtr self, char** ioCachedString, char* outBuf, size_t bufSize, struct LEOContext* inContext )
+{
+	if( !*ioCachedString )
+		*ioCachedString = LEOCopyArrayValueAsString( self, inContext );
 	
-	LEOPrintArray( self->array.array, outBuf, bufSize, inContext );
-	size_t	lastCh = strlen(outBuf)-1;
-	if( outBuf[lastCh] == '\n' )	// Remove trailing return, if there is one.
-		outBuf[lastCh] = 0;
-	return outBuf;
+	if( outBuf && bufSize > 0 )
+	{
+		strncpy( outBuf, *ioCachedString, bufSize -1 );
+		outBuf[bufSize -1] = 0;
+	}
+	return *ioCachedString;
+}
+
+
+const char*	LEOGetArrayValueAsString( LEOValuePtr self, char* outBuf, size_t bufSize, struct LEOContext* inContext )
+{
+	return LEOGetCachedArrayString( self, &self->array.cachedString, outBuf, bufSize, inContext );
 }
 
 
@@ -2258,7 +2649,8 @@ void	LEOInitArrayValueCopy( LEOValuePtr self, LEOValuePtr dest, LEOKeepReference
 	dest->base.isa = &kLeoValueTypeArray;
 	if( keepReferences == kLEOInvalidateReferences )
 		dest->base.refObjectID = kLEOObjectIDINVALID;
-	dest->array.array = LEOCopyArray( self->array.array, inContext );
+	dest->array.array = LEOShareArray( self->array.array );	// Copied lazily once one of us changes it.
+	dest->array.cachedString = NULL;
 }
 
 
@@ -2271,6 +2663,7 @@ void	LEOPutArrayValueIntoValue( LEOValuePtr self, LEOValuePtr dest, struct LEOCo
 void	LEOCleanUpArrayValue( LEOValuePtr self, LEOKeepReferencesFlag keepReferences, struct LEOContext* inContext )
 {
 	self->base.isa = NULL;
+	LEOFlushCachedArrayString( &self->array.cachedString );
 	LEOCleanUpArray( self->array.array, inContext );
 	self->array.array = NULL;
 	if( keepReferences == kLEOInvalidateReferences && self->base.refObjectID != kLEOObjectIDINVALID )	// We have references? Make sure they all notice we've gone if they try to access us from now on.
@@ -2289,6 +2682,7 @@ LEOValuePtr		LEOGetArrayValueValueForKey( LEOValuePtr self, const char* inKey, s
 
 void	LEOSetArrayValueValueForKey( LEOValuePtr self, const char* inKey, LEOValuePtr inValue, struct LEOContext * inContext )
 {
+	LEOFlushCachedArrayString( &self->array.cachedString );
 	LEOAddArrayEntryToRoot( &self->array.array, inKey, inValue, inContext );
 }
 
@@ -2301,101 +2695,219 @@ size_t	LEOGetArrayValueKeyCount( LEOValuePtr self, struct LEOContext* inContext
 
 void	LEOSetArrayValueAsArray( LEOValuePtr self, struct LEOArrayEntry *inArray, struct LEOContext* inContext )
 {
+	struct LEOArrayEntry*	newArray = LEOShareArray( inArray );	// Share first, inArray may be our own array.
+	LEOFlushCachedArrayString( &self->array.cachedString );
 	LEOCleanUpArray( self->array.array, inContext );
-	self->array.array = LEOCopyArray( self->array.array, inContext );
+	self->array.array = newArray;
 }
 
 
 #pragma mark -
 
 
-struct LEOArrayEntry	*	LEOCreateArrayFromString( const char* inString, struct LEOContext* inContext )
+static struct LEOArrayEntry*	LEOAllocArrayEntryOfSize( size_t inSize, struct LEOContext* inContext );
+
+
+// One key-value pair LEOCreateArrayFromString() found, pointing right into the string:
+struct LEOArrayStringEntry
 {
-	struct LEOArrayEntry*	theArray = NULL;
-	size_t					x = 0, keyStartOffs = 0, keyEndOffs = 0,
-							valueStartOffs = 0, valueEndOffs = 0;
-	bool					isInKey = true;
-	char					keyStr[LEO_MAX_ARRAY_KEY_SIZE] = { 0 };
-	
-	for( ; inString[x] != 0; x++ )
-	{
-		if( isInKey && inString[x] == ':' )
-		{
-			keyEndOffs = x;
-			valueStartOffs = valueEndOffs = x+1;
-			isInKey = false;
-		}
-		else if( !isInKey && inString[x] == '\n' )
-		{
-			if( x <= 1 || inString[x-2] != 0xc2 || inString[x-1] != 0xac )	// Is a real return end-of-entry, not an escaped return in data?
-			{
-				valueEndOffs = x;	// No +1, the return at the end is a delimiter that should be removed.
-				size_t	keyLen = keyEndOffs -keyStartOffs;
-				if( keyLen >= LEO_MAX_ARRAY_KEY_SIZE )
-					keyLen = LEO_MAX_ARRAY_KEY_SIZE -1;
-				if( keyLen > 0 )
-					memmove( keyStr, inString +keyStartOffs, keyLen );
-				else	// Error, not a valid array!
-				{
-					LEOCleanUpArray( &theArray, inContext );
-					return NULL;
-				}
-				keyStr[keyLen] = 0;
-				
-				struct LEOArrayEntry*	newValue = LEOAddArrayEntryToRoot( &theArray, keyStr, NULL, inContext );
-				LEOInitStringValue( newValue, inString +valueStartOffs, valueEndOffs -valueStartOffs, kLEOInvalidateReferences, inContext );
-				
-				isInKey = true;
-				keyEndOffs = keyStartOffs = valueEndOffs = valueStartOffs = x +1;
-			}
-		}
-		else if( !isInKey )
-			valueEndOffs = x +1;
-		else if( isInKey )
-			keyEndOffs = x+1;
-	}
-	
-	if( !isInKey && (keyEndOffs > keyStartOffs || valueEndOffs > valueStartOffs) )	// No return at end, we have one leftover key-value pair?
-	{
-		size_t	keyLen = keyEndOffs -keyStartOffs;
-		if( keyLen >= LEO_MAX_ARRAY_KEY_SIZE )
-			keyLen = LEO_MAX_ARRAY_KEY_SIZE -1;
-		if( keyLen > 0 )
-			memmove( keyStr, inString +keyStartOffs, keyLen );
-		else	// Error, not a valid array!
-		{
-			LEOCleanUpArray( &theArray, inContext );
-			return NULL;
-		}
-		keyStr[keyLen] = 0;
-		
-		struct LEOArrayEntry*	newValue = LEOAddArrayEntryToRoot( &theArray, keyStr, NULL, inContext );
-		LEOInitStringValue( newValue, inString +valueStartOffs, valueEndOffs -valueStartOffs, kLEOInvalidateReferences, inContext );
-	}
-	
-	return theArray;
+	const char*		key;
+	size_t			keyLength;
+	const char*		value;
+	size_t			valueLength;
+	size_t			index;			// Position in the string, so we know which duplicate of a key came last.
+};
+
+
+// Same order as strcasecmp() on the zero-terminated keys:
+static int	LEOCompareArrayStringKeys( const struct LEOArrayStringEntry* inA, const struct LEOArrayStringEntry* inB )
+{
+	size_t	minLength = (inA->keyLength < inB->keyLength) ? inA->keyLength : inB->keyLength;
+	int		result = strncasecmp( inA->key, inB->key, minLength );
+	if( result == 0 && inA->keyLength != inB->keyLength )
+		result = (inA->keyLength < inB->keyLength) ? -1 : 1;
+	return result;
 }
 
 
-struct LEOArrayEntry	*	LEOAllocNewEntry( const char* inKey, LEOValuePtr inValue, struct LEOContext* inContext )
+static int	LEOCompareArrayStringEntries( const void* inA, const void* inB )
 {
-	struct LEOArrayEntry	*	newEntry = NULL;
-	size_t						inKeyLen = strlen(inKey);
-	newEntry = calloc( sizeof(struct LEOArrayEntry) +inKeyLen +1, 1 );
-	memmove( newEntry->key, inKey, inKeyLen +1 );
-	if( inValue )
-		LEOInitCopy( inValue, &newEntry->value, kLEOInvalidateReferences, inContext );
-	newEntry->smallerItem = NULL;
-	newEntry->largerItem = NULL;
-	
-	return newEntry;
+	const struct LEOArrayStringEntry*	a = inA;
+	const struct LEOArrayStringEntry*	b = inB;
+	int		result = LEOCompareArrayStringKeys( a, b );
+	if( result == 0 )
+		result = (a->index < b->index) ? -1 : 1;
+	return result;
 }
 
 
-LEOValuePtr	LEOAddArrayEntryToRoot( struct LEOArrayEntry** arrayPtrByReference, const char* inKey, LEOValuePtr inValue, struct LEOContext* inContext )
+// Find the return that ends the value starting at inValueStart. Returns in the
+//	value itself are written as "¬\n", while "¬¬" is an escaped "¬" (see
+//	LEOPrintArray()), so a return ends the value if an even number of "¬"s
+//	comes right before it:
+static const char*	LEOFindArrayStringValueEnd( const char* inValueStart )
+{
+	const char*	currCh = inValueStart;
+	while( true )
+	{
+		const char*	valueEnd = strchr( currCh, '\n' );	// The C library usually scans many bytes at a time.
+		if( !valueEnd )
+			return currCh +strlen(currCh);
+		
+		size_t		numMarks = 0;
+		for( const char* markCh = valueEnd; (markCh -inValueStart) >= 2 && markCh[-2] == (char)0xc2 && markCh[-1] == (char)0xac; markCh -= 2 )
+			numMarks++;
+		if( (numMarks % 2) == 0 )
+			return valueEnd;
+		currCh = valueEnd +1;
+	}
+}
+
+
+// Build a balanced tree from entries sorted by key. LEOGetArrayValueForKey()
+//	looks for keys that sort before an entry on its 'larger' side:
+static struct LEOArrayEntry*	LEOCreateArrayFromSortedEntries( struct LEOArrayStringEntry* inEntries, size_t inNumEntries, struct LEOContext* inContext )
+{
+	if( inNumEntries == 0 )
+		return NULL;
+	
+	size_t							middle = inNumEntries / 2;
+	struct LEOArrayStringEntry*		currEntry = inEntries +middle;
+	struct LEOArrayEntry*			newEntry = LEOAllocArrayEntryOfSize( sizeof(struct LEOArrayEntry) +currEntry->keyLength +1, inContext );
+	newEntry->referenceCount = 1;
+	memcpy( newEntry->key, currEntry->key, currEntry->keyLength );
+	newEntry->key[currEntry->keyLength] = 0;
+	LEOInitStringValue( &newEntry->value, currEntry->value, currEntry->valueLength, kLEOInvalidateReferences, inContext );
+	newEntry->largerItem = LEOCreateArrayFromSortedEntries( inEntries, middle, inContext );
+	newEntry->smallerItem = LEOCreateArrayFromSortedEntries( inEntries +middle +1, inNumEntries -middle -1, inContext );
+	
+	return newEntry;
+}
+
+
+struct LEOArrayEntry	*	LEOCreateArrayFromString( const char* inString, struct LEOContext* inContext )
+{
+	// Each entry but the last one ends in a return, so this is enough room for all of them:
+	size_t		numEntrySlots = 1;
+	for( const char* currReturn = strchr( inString, '\n' ); currReturn != NULL; currReturn = strchr( currReturn +1, '\n' ) )
+		numEntrySlots++;
+	struct LEOArrayStringEntry*	entries = malloc( numEntrySlots * sizeof(struct LEOArrayStringEntry) );
+	size_t						numEntries = 0;
+	bool						isSorted = true;
+	
+	const char*		currCh = inString;
+	while( *currCh != 0 )
+	{
+		const char*	keyEnd = strchr( currCh, ':' );	// Returns before the colon are part of the key.
+		if( !keyEnd )	// Text without a value at the end? Ignore it.
+			break;
+		
+		size_t		keyLength = keyEnd -currCh;
+		if( keyLength == 0 )	// Error, not a valid array!
+		{
+			free( entries );
+			return NULL;
+		}
+		if( keyLength >= LEO_MAX_ARRAY_KEY_SIZE )
+			keyLength = LEO_MAX_ARRAY_KEY_SIZE -1;
+		
+		const char*	valueEnd = LEOFindArrayStringValueEnd( keyEnd +1 );
+		struct LEOArrayStringEntry*	newEntry = entries +numEntries;
+		newEntry->key = currCh;
+		newEntry->keyLength = keyLength;
+		newEntry->value = keyEnd +1;
+		newEntry->valueLength = valueEnd -(keyEnd +1);	// The return at the end is a delimiter that should be removed.
+		newEntry->index = numEntries;
+		if( numEntries > 0 && isSorted && LEOCompareArrayStringKeys( newEntry -1, newEntry ) >= 0 )
+			isSorted = false;
+		numEntries++;
+		
+		currCh = (*valueEnd == '\n') ? (valueEnd +1) : valueEnd;
+	}
+	
+	// Arrays we printed usually aren't sorted, ones other code wrote often are:
+	if( !isSorted )
+		qsort( entries, numEntries, sizeof(struct LEOArrayStringEntry), LEOCompareArrayStringEntries );
+	
+	// Like LEOAddArrayEntryToRoot(), keep the first spelling of a key, but the last value:
+	size_t		numUniqueEntries = 0;
+	for( size_t x = 0; x < numEntries; x++ )
+	{
+		if( numUniqueEntries > 0 && LEOCompareArrayStringKeys( entries +numUniqueEntries -1, entries +x ) == 0 )
+		{
+			entries[numUniqueEntries -1].value = entries[x].value;
+			entries[numUniqueEntries -1].valueLength = entries[x].valueLength;
+		}
+		else
+			entries[numUniqueEntries++] = entries[x];
+	}
+	
+	struct LEOArrayEntry*	theArray = LEOCreateArrayFromSortedEntries( entries, numUniqueEntries, inContext );
+	free( entries );
+	
+	return theArray;
+}
+
+
+// Array entries are taken from the slabs of the context group's allocator, if
+//	it has one. Each entry remembers that allocator, as arrays are shared
+//	between contexts and may be freed through another group's context (or
+//	none at all). Since the key is stored right in the entry, its length tells
+//	us which size class to give the entry back to.
+static struct LEOArrayEntry*	LEOAllocArrayEntryOfSize( size_t inSize, struct LEOContext* inContext )
+{
+	struct LEOArrayEntry*	newEntry = NULL;
+	struct LEOSlabAllocator*	allocator = inContext ? inContext->group->arrayEntryAllocator : NULL;
+	if( allocator )
+		newEntry = LEOSlabAllocatorAllocate( allocator, inSize );
+	if( !newEntry )	// No allocator or too large for it?
+	{
+		newEntry = malloc( inSize );
+		allocator = NULL;
+	}
+	newEntry->allocator = allocator;
+	if( inContext )
+		inContext->statistics.numArrayEntriesAllocated ++;
+	
+	return newEntry;
+}
+
+
+static void	LEOFreeArrayEntry( struct LEOArrayEntry* inEntry, struct LEOContext* inContext )
+{
+	size_t		entrySize = sizeof(struct LEOArrayEntry) +strlen(inEntry->key) +1;
+	if( inContext )
+		inContext->statistics.numArrayEntriesFreed ++;
+	if( inEntry->allocator )
+		LEOSlabAllocatorRelease( inEntry->allocator, inEntry, entrySize );
+	else
+		free( inEntry );
+}
+
+
+struct LEOArrayEntry	*	LEOAllocNewEntry( const char* inKey, LEOValuePtr inValue, struct LEOContext* inContext )
+{
+	struct LEOArrayEntry	*	newEntry = NULL;
+	size_t						inKeyLen = strlen(inKey);
+	newEntry = LEOAllocArrayEntryOfSize( sizeof(struct LEOArrayEntry) +inKeyLen +1, inContext );
+	memset( &newEntry->value, 0, sizeof(union LEOValue) );
+	newEntry->referenceCount = 1;
+	memmove( newEntry->key, inKey, inKeyLen +1 );
+	if( inValue )
+		LEOInitCopy( inValue, &newEntry->value, kLEOInvalidateReferences, inContext );
+	newEntry->smallerItem = NULL;
+	newEntry->largerItem = NULL;
+	
+	return newEntry;
+}
+
+
+LEOValuePtr	LEOAddArrayEntryToRoot( struct LEOArrayEntry** arrayPtrByReference, const char* inKey, LEOValuePtr inValue, struct LEOContext* inContext )
 {
 	struct LEOArrayEntry	*	currEntry = NULL;
 	
+	LEOMakeArrayUnique( arrayPtrByReference, inContext );
+	
 	if( *arrayPtrByReference == NULL )
 	{
 		*arrayPtrByReference = LEOAllocNewEntry( inKey, inValue, inContext );
@@ -2443,6 +2955,8 @@ LEOValuePtr	LEOAddArrayEntryToRoot( struct LEOArrayEntry** arrayPtrByReference,
 
 void	LEODeleteArrayEntryFromRoot( struct LEOArrayEntry** arrayPtrByReference, const char* inKey, struct LEOContext* inContext )
 {
+	LEOMakeArrayUnique( arrayPtrByReference, inContext );	// +++ Could check whether the key exists first and not copy if it doesn't.
+	
 	struct LEOArrayEntry**	parentPtr = arrayPtrByReference;
 	struct LEOArrayEntry*	currEntry = *arrayPtrByReference;
 	while( true )
@@ -2470,7 +2984,7 @@ void	LEODeleteArrayEntryFromRoot( struct LEOArrayEntry** arrayPtrByReference, co
 			{
 				// Append the smaller subtree to the larger subtree:
 				*parentPtr = currEntry->largerItem;
-				struct LEOArrayEntry*	currEntry2 = currEntry->smallerItem;
+				struct LEOArrayEntry*	currEntry2 = currEntry->largerItem;
 				
 				while( true )
 				{
@@ -2505,7 +3019,8 @@ void	LEODeleteArrayEntryFromRoot( struct LEOArrayEntry** arrayPtrByReference, co
 				*parentPtr = currEntry->largerItem;
 			}
 			
-			free( currEntry );
+			LEOFreeArrayEntry( currEntry, inContext );
+			return;
 		}
 	}
 }
@@ -2513,15 +3028,86 @@ void	LEODeleteArrayEntryFromRoot( struct LEOArrayEntry** arrayPtrByReference, co
 
 struct LEOArrayEntry*	LEOCopyArray( struct LEOArrayEntry* arrayPtr, struct LEOContext* inContext )
 {
-	struct LEOArrayEntry*	entryCopy = LEOAllocNewEntry( arrayPtr->key, &arrayPtr->value, inContext );
+	// We walk the tree using our own stack instead of recursing, so arrays
+	//	that degenerated into long lists can't overflow the C stack:
+	struct LEOArrayEntryCopyJob
+	{
+		struct LEOArrayEntry	*	original;
+		struct LEOArrayEntry	**	copyPtrByReference;
+	};
+	struct LEOArrayEntryCopyJob		localJobs[LEO_ARRAY_COPY_STACK_CHUNK_SIZE];
+	struct LEOArrayEntryCopyJob	*	jobs = localJobs;
+	size_t							numJobs = 0,
+									numJobSlots = LEO_ARRAY_COPY_STACK_CHUNK_SIZE;
+	struct LEOArrayEntry		*	arrayCopy = NULL;
+	
+	if( arrayPtr )
+	{
+		jobs[numJobs].original = arrayPtr;
+		jobs[numJobs++].copyPtrByReference = &arrayCopy;
+	}
 	
-	if( arrayPtr->smallerItem )
-		entryCopy->smallerItem = LEOCopyArray( arrayPtr->smallerItem, inContext );
+	while( numJobs > 0 )
+	{
+		struct LEOArrayEntryCopyJob	currJob = jobs[--numJobs];
+		struct LEOArrayEntry*		original = currJob.original;
+		size_t						entrySize = sizeof(struct LEOArrayEntry) +strlen(original->key) +1;
+		struct LEOArrayEntry*		entryCopy = LEOAllocArrayEntryOfSize( entrySize, inContext );
+		
+		memmove( entryCopy->key, original->key, entrySize -sizeof(struct LEOArrayEntry) );	// We already know the length, no need to go through LEOAllocNewEntry.
+		entryCopy->smallerItem = NULL;
+		entryCopy->largerItem = NULL;
+		entryCopy->referenceCount = 1;
+		LEOInitCopy( &original->value, &entryCopy->value, kLEOInvalidateReferences, inContext );
+		*currJob.copyPtrByReference = entryCopy;
+		
+		if( (numJobs +2) > numJobSlots )
+		{
+			numJobSlots += LEO_ARRAY_COPY_STACK_CHUNK_SIZE;
+			if( jobs == localJobs )
+			{
+				jobs = malloc( numJobSlots * sizeof(struct LEOArrayEntryCopyJob) );
+				memmove( jobs, localJobs, numJobs * sizeof(struct LEOArrayEntryCopyJob) );
+			}
+			else
+				jobs = realloc( jobs, numJobSlots * sizeof(struct LEOArrayEntryCopyJob) );
+		}
+		if( original->smallerItem )
+		{
+			jobs[numJobs].original = original->smallerItem;
+			jobs[numJobs++].copyPtrByReference = &entryCopy->smallerItem;
+		}
+		if( original->largerItem )
+		{
+			jobs[numJobs].original = original->largerItem;
+			jobs[numJobs++].copyPtrByReference = &entryCopy->largerItem;
+		}
+	}
 	
-	if( arrayPtr->largerItem )
-		entryCopy->largerItem = LEOCopyArray( arrayPtr->largerItem, inContext );
+	if( jobs != localJobs )
+		free( jobs );
+	
+	return arrayCopy;
+}
+
+
+struct LEOArrayEntry*	LEOShareArray( struct LEOArrayEntry* arrayPtr )
+{
+	if( arrayPtr )
+		arrayPtr->referenceCount ++;
 	
-	return entryCopy;
+	return arrayPtr;
+}
+
+
+void	LEOMakeArrayUnique( struct LEOArrayEntry** arrayPtrByReference, struct LEOContext* inContext )
+{
+	struct LEOArrayEntry*	sharedArray = *arrayPtrByReference;
+	if( sharedArray && sharedArray->referenceCount > 1 )	// Somebody else is using this array, too? Get our own copy before we change it.
+	{
+		*arrayPtrByReference = LEOCopyArray( sharedArray, inContext );
+		sharedArray->referenceCount --;
+	}
 }
 
 
@@ -2544,103 +3130,174 @@ LEOValuePtr		LEOGetArrayValueForKey( struct LEOArrayEntry* arrayPtr, const char*
 }
 
 
-void	LEOPrintArray( struct LEOArrayEntry* arrayPtr, char* strBuf, size_t bufSize, struct LEOContext* inContext )
+// Text we print an array into. Once it is full, we either grow it (if it is
+//	our own buffer) or stop writing (if it is the caller's):
+struct LEOArrayPrintBuffer
 {
-	if( bufSize <= 1 )
-		return;
-	
-	strBuf[0] = 0;
-	if( arrayPtr == NULL )
-		return;
-	
-	char valBuf[1024];
-	
-	const char* valStr = LEOGetValueAsString( &arrayPtr->value, valBuf, sizeof(valBuf), inContext );
-	
-	size_t	offs = snprintf( strBuf, bufSize, "%s:", arrayPtr->key );
-	for( int x = 0; true; x++ )
+	char*	string;
+	size_t	length;		// Not counting the terminating zero byte.
+	size_t	capacity;	// Including room for the terminating zero byte.
+	bool	canGrow;
+};
+
+
+static void	LEOArrayPrintBufferAppend( struct LEOArrayPrintBuffer* ioBuffer, const char* inBytes, size_t inLength )
+{
+	if( (ioBuffer->length +inLength) >= ioBuffer->capacity )
 	{
-		if( (bufSize -offs) == 0 )
+		if( ioBuffer->canGrow )
 		{
-			strBuf[offs] = 0;
-			break;
+			size_t	newCapacity = ioBuffer->capacity * 2;	// Doubling keeps printing linear in the size of the text.
+			while( (ioBuffer->length +inLength) >= newCapacity )
+				newCapacity *= 2;
+			ioBuffer->string = realloc( ioBuffer->string, newCapacity );
+			ioBuffer->capacity = newCapacity;
 		}
-		if( valStr[x] == '\n' )	// Replace with "¬\n" (2-byte char + line feed).
+		else
+			inLength = ioBuffer->capacity -1 -ioBuffer->length;
+	}
+	memcpy( ioBuffer->string +ioBuffer->length, inBytes, inLength );
+	ioBuffer->length += inLength;
+}
+
+
+// Returns in values are written as "¬\n" so they don't end the entry, and
+//	any "¬" that was already there as "¬¬". Everything in between is copied
+//	in one go:
+static void	LEOArrayPrintBufferAppendEscaped( struct LEOArrayPrintBuffer* ioBuffer, const char* inStr )
+{
+	while( true )
+	{
+		size_t	runLength = strcspn( inStr, "\n\xc2" );	// The C library usually scans many bytes at a time.
+		LEOArrayPrintBufferAppend( ioBuffer, inStr, runLength );
+		inStr += runLength;
+		
+		if( inStr[0] == 0 )
+			break;
+		else if( inStr[0] == '\n' )
 		{
-			strBuf[offs++] = 0xc2;
-			if( (bufSize -offs) == 0 )
-			{
-				strBuf[offs -1] = 0;
-				break;
-			}
-			strBuf[offs++] = 0xac;
-			if( (bufSize -offs) == 0 )
-			{
-				strBuf[offs -2] = 0;
-				break;
-			}
-			strBuf[offs++] = '\n';
+			LEOArrayPrintBufferAppend( ioBuffer, "\xc2\xac\n", 3 );
+			inStr++;
 		}
-		else if( valStr[x] == (char)0xc2 )
+		else if( inStr[1] == (char)0xac )
 		{
-			if( valStr[x+1] == (char)0xac )
-			{
-				x++;
-				
-				strBuf[offs++] = 0xc2;
-				if( (bufSize -offs) == 0 )
-				{
-					strBuf[offs -1] = 0;
-					break;
-				}
-				strBuf[offs++] = 0xac;
-				if( (bufSize -offs) == 0 )
-				{
-					strBuf[offs -2] = 0;
-					break;
-				}
-				strBuf[offs++] = 0xc2;
-				if( (bufSize -offs) == 0 )
-				{
-					strBuf[offs -1] = 0;
-					break;
-				}
-				strBuf[offs++] = 0xac;
-				if( (bufSize -offs) == 0 )
-				{
-					strBuf[offs -2] = 0;
-					break;
-				}
-			}
-			else
-				strBuf[offs++] = valStr[x];
+			LEOArrayPrintBufferAppend( ioBuffer, "\xc2\xac\xc2\xac", 4 );
+			inStr += 2;
 		}
-		else
-			strBuf[offs++] = valStr[x];
-		if( (bufSize -offs) <= 1 )
+		else	// Some other character that starts with 0xc2.
 		{
-			strBuf[offs] = 0;
-			break;
+			LEOArrayPrintBufferAppend( ioBuffer, inStr, 1 );
+			inStr++;
 		}
-		if( valStr[x] == 0 )
-			break;
 	}
-	if( (bufSize -offs) > 0 )
+}
+
+
+static void	LEOPrintArrayIntoBuffer( struct LEOArrayEntry* arrayPtr, struct LEOArrayPrintBuffer* ioBuffer, struct LEOContext* inContext );
+static void	LEOPrintDenseArrayIntoBuffer( struct LEODenseArray* inArray, struct LEOArrayPrintBuffer* ioBuffer, struct LEOContext* inContext );
+
+
+// The whole text of an array or dense array value, without the trailing return:
+static char*	LEOCopyArrayValueAsString( LEOValuePtr inValue, struct LEOContext* inContext )
+{
+	struct LEOArrayPrintBuffer	buffer = { malloc( LEO_ARRAY_PRINT_BUFFER_INITIAL_SIZE ), 0, LEO_ARRAY_PRINT_BUFFER_INITIAL_SIZE, true };
+	if( inValue->base.isa == &kLeoValueTypeDenseArray )
+		LEOPrintDenseArrayIntoBuffer( inValue->denseArray.denseArray, &buffer, inContext );
+	else
+		LEOPrintArrayIntoBuffer( inValue->array.array, &buffer, inContext );
+	if( buffer.length > 0 && buffer.string[buffer.length -1] == '\n' )
+		buffer.string[buffer.length -1] = 0;
+	return buffer.string;
+}
+
+
+static void	LEOArrayPrintBufferAppendKeyAndValue( struct LEOArrayPrintBuffer* ioBuffer, const char* inKey, size_t inKeyLength, LEOValuePtr inValue, struct LEOContext* inContext )
+{
+	LEOArrayPrintBufferAppend( ioBuffer, inKey, inKeyLength );
+	LEOArrayPrintBufferAppend( ioBuffer, ":", 1 );
+	
+	if( inValue->base.isa == &kLeoValueTypeArray || inValue->base.isa == &kLeoValueTypeArrayVariant
+		|| inValue->base.isa == &kLeoValueTypeDenseArray )	// Nested arrays can be any size.
 	{
-		strBuf[offs -1] = '\n';
-		strBuf[offs++] = 0;
+		char*	nestedStr = LEOCopyArrayValueAsString( inValue, inContext );
+		LEOArrayPrintBufferAppendEscaped( ioBuffer, nestedStr );
+		free( nestedStr );
 	}
-	
-	if( arrayPtr->smallerItem )
+	else
 	{
-		offs = strlen(strBuf);
-		LEOPrintArray( arrayPtr->smallerItem, strBuf +offs, bufSize -offs, inContext );
+		const char*	valStr = LEOGetValueAsString( inValue, NULL, 0, inContext );	// Strings give us their own buffer without copying.
+		char		valBuf[1024];
+		if( !valStr )	// Numbers and the like need a buffer to be written to.
+			valStr = LEOGetValueAsString( inValue, valBuf, sizeof(valBuf), inContext );
+		LEOArrayPrintBufferAppendEscaped( ioBuffer, valStr );
 	}
-	if( arrayPtr->largerItem )
+	
+	LEOArrayPrintBufferAppend( ioBuffer, "\n", 1 );
+}
+
+
+static void	LEOPrintArrayIntoBuffer( struct LEOArrayEntry* arrayPtr, struct LEOArrayPrintBuffer* ioBuffer, struct LEOContext* inContext )
+{
+	// We walk the tree using our own stack instead of recursing, like
+	//	LEOCopyArray(). Entries are printed before their 'smaller' side, which
+	//	comes before their 'larger' side:
+	struct LEOArrayEntry	*	localEntries[LEO_ARRAY_COPY_STACK_CHUNK_SIZE];
+	struct LEOArrayEntry	**	entries = localEntries;
+	size_t						numEntries = 0,
+								numEntrySlots = LEO_ARRAY_COPY_STACK_CHUNK_SIZE;
+	
+	if( arrayPtr )
+		entries[numEntries++] = arrayPtr;
+	
+	while( numEntries > 0 )
 	{
-		offs = strlen(strBuf);
-		LEOPrintArray( arrayPtr->largerItem, strBuf +offs, bufSize -offs, inContext );
+		struct LEOArrayEntry*	currEntry = entries[--numEntries];
+		LEOArrayPrintBufferAppendKeyAndValue( ioBuffer, currEntry->key, strlen(currEntry->key), &currEntry->value, inContext );
+		if( !ioBuffer->canGrow && (ioBuffer->length +1) >= ioBuffer->capacity )	// Caller's buffer is full, no use printing the rest.
+			break;
+		
+		if( (numEntries +2) > numEntrySlots )
+		{
+			numEntrySlots += LEO_ARRAY_COPY_STACK_CHUNK_SIZE;
+			if( entries == localEntries )
+			{
+				entries = malloc( numEntrySlots * sizeof(struct LEOArrayEntry*) );
+				memmove( entries, localEntries, numEntries * sizeof(struct LEOArrayEntry*) );
+			}
+			else
+				entries = realloc( entries, numEntrySlots * sizeof(struct LEOArrayEntry*) );
+		}
+		if( currEntry->largerItem )
+			entries[numEntries++] = currEntry->largerItem;
+		if( currEntry->smallerItem )
+			entries[numEntries++] = currEntry->smallerItem;
 	}
+	
+	if( entries != localEntries )
+		free( entries );
+	
+	ioBuffer->string[ioBuffer->length] = 0;
+}
+
+
+void	LEOPrintArray( struct LEOArrayEntry* arrayPtr, char* strBuf, size_t bufSize, struct LEOContext* inContext )
+{
+	if( bufSize == 0 )
+		return;
+	
+	struct LEOArrayPrintBuffer	buffer = { strBuf, 0, bufSize, false };
+	LEOPrintArrayIntoBuffer( arrayPtr, &buffer, inContext );
+}
+
+
+char*	LEOCopyArrayAsString( struct LEOArrayEntry* arrayPtr, size_t* outLength, struct LEOContext* inContext )
+{
+	struct LEOArrayPrintBuffer	buffer = { malloc( LEO_ARRAY_PRINT_BUFFER_INITIAL_SIZE ), 0, LEO_ARRAY_PRINT_BUFFER_INITIAL_SIZE, true };
+	LEOPrintArrayIntoBuffer( arrayPtr, &buffer, inContext );
+	if( outLength )
+		*outLength = buffer.length;
+	
+	return buffer.string;
 }
 
 
@@ -2663,22 +3320,256 @@ size_t	LEOGetArrayKeyCount( struct LEOArrayEntry* arrayPtr )
 
 void	LEOCleanUpArray( struct LEOArrayEntry* arrayPtr, struct LEOContext* inContext )
 {
-	if( !arrayPtr )
-		return;	// Nothing to do, never added a value to the array.
+	struct LEOArrayEntry*	currEntry = arrayPtr;	// If NULL, nothing to do, never added a value to the array.
 	
-	if( arrayPtr->smallerItem )
+	if( currEntry && currEntry->referenceCount > 1 )	// Still shared with someone else? They get to keep it.
 	{
-		LEOCleanUpArray( arrayPtr->smallerItem, inContext );
-		arrayPtr->smallerItem = NULL;
+		currEntry->referenceCount --;
+		return;
 	}
-	if( arrayPtr->largerItem )
+	
+	// Instead of recursing, we rotate each smaller subtree up until the
+	//	current entry has none left, then dispose of the entry and continue
+	//	with its larger subtree. Each entry gets rotated at most once, so this
+	//	is linear and needs no extra memory:
+	while( currEntry )
+	{
+		if( currEntry->smallerItem )
+		{
+			struct LEOArrayEntry*	smallerEntry = currEntry->smallerItem;
+			currEntry->smallerItem = smallerEntry->largerItem;
+			smallerEntry->largerItem = currEntry;
+			currEntry = smallerEntry;
+		}
+		else
+		{
+			struct LEOArrayEntry*	largerEntry = currEntry->largerItem;
+			LEOCleanUpValue( &currEntry->value, kLEOInvalidateReferences, inContext );
+			LEOFreeArrayEntry( currEntry, inContext );
+			currEntry = largerEntry;
+		}
+	}
+}
+
+
+#pragma mark -
+#pragma mark Dense arrays
+
+
+// Returns the index of the item for the given key, or SIZE_MAX if the key
+//	isn't one of "1" to "inNumItems" (written exactly like that, "01" or "+1"
+//	are different keys):
+static size_t	LEOGetDenseArrayIndexForKey( const char* inKey, size_t inNumItems )
+{
+	if( inKey[0] < '1' || inKey[0] > '9' )
+		return SIZE_MAX;
+	
+	size_t		keyNumber = 0;
+	for( const char* currCh = inKey; *currCh != 0; currCh++ )
+	{
+		if( *currCh < '0' || *currCh > '9' || keyNumber > inNumItems )	// Not a number, or already too large?
+			return SIZE_MAX;
+		keyNumber = (keyNumber * 10) +(*currCh -'0');
+	}
+	
+	return (keyNumber <= inNumItems) ? (keyNumber -1) : SIZE_MAX;
+}
+
+
+struct LEODenseArray*	LEOCreateDenseArray( size_t inNumItems, struct LEOContext* inContext )
+{
+	struct LEODenseArray*	newArray = malloc( sizeof(struct LEODenseArray) +inNumItems * sizeof(union LEOValue) );
+	newArray->referenceCount = 1;
+	newArray->numItems = inNumItems;
+	
+	return newArray;
+}
+
+
+void	LEOCleanUpDenseArray( struct LEODenseArray* inArray, struct LEOContext* inContext )
+{
+	if( !inArray )
+		return;
+	
+	if( inArray->referenceCount > 1 )	// Still shared with someone else? They get to keep it.
+	{
+		inArray->referenceCount --;
+		return;
+	}
+	
+	for( size_t x = 0; x < inArray->numItems; x++ )
+		LEOCleanUpValue( inArray->items +x, kLEOInvalidateReferences, inContext );
+	free( inArray );
+}
+
+
+// Give the value its own copy of its items before we change one of them:
+static void	LEOMakeDenseArrayUnique( struct LEODenseArray** arrayPtrByReference, struct LEOContext* inContext )
+{
+	struct LEODenseArray*	sharedArray = *arrayPtrByReference;
+	if( sharedArray->referenceCount > 1 )
+	{
+		struct LEODenseArray*	arrayCopy = LEOCreateDenseArray( sharedArray->numItems, inContext );
+		for( size_t x = 0; x < sharedArray->numItems; x++ )
+			LEOInitCopy( sharedArray->items +x, arrayCopy->items +x, kLEOInvalidateReferences, inContext );
+		sharedArray->referenceCount --;
+		*arrayPtrByReference = arrayCopy;
+	}
+}
+
+
+// Keys in the order the array tree expects, which is strcasecmp() order. Our
+//	keys are all digits, for which that is the same as strcmp() order (so "10"
+//	comes before "2"):
+static int	LEOCompareDenseArrayKeys( const void* inA, const void* inB )
+{
+	const char*	a = *(const char**)inA;
+	const char*	b = *(const char**)inB;
+	return strcmp( a, b );
+}
+
+
+// Build a balanced tree from the given items (see LEOCreateArrayFromSortedEntries()):
+static struct LEOArrayEntry*	LEOCreateArrayFromSortedDenseItems( char** inSortedKeys, size_t inNumKeys, struct LEODenseArray* inArray, struct LEOContext* inContext )
+{
+	if( inNumKeys == 0 )
+		return NULL;
+	
+	size_t					middle = inNumKeys / 2;
+	const char*				key = inSortedKeys[middle];
+	struct LEOArrayEntry*	newEntry = LEOAllocNewEntry( key, inArray->items +LEOGetDenseArrayIndexForKey( key, inArray->numItems ), inContext );
+	newEntry->largerItem = LEOCreateArrayFromSortedDenseItems( inSortedKeys, middle, inArray, inContext );
+	newEntry->smallerItem = LEOCreateArrayFromSortedDenseItems( inSortedKeys +middle +1, inNumKeys -middle -1, inArray, inContext );
+	
+	return newEntry;
+}
+
+
+struct LEOArrayEntry*	LEOCreateArrayFromDenseArray( struct LEODenseArray* inArray, struct LEOContext* inContext )
+{
+	if( inArray->numItems == 0 )
+		return NULL;
+	
+	char	**	keys = malloc( inArray->numItems * sizeof(char*) );
+	char	*	keyStrings = malloc( inArray->numItems * LEO_NUMBER_STRING_MAX_LENGTH );
+	for( size_t x = 0; x < inArray->numItems; x++ )
 	{
-		LEOCleanUpArray( arrayPtr->largerItem, inContext );
-		arrayPtr->smallerItem = NULL;
+		keys[x] = keyStrings +(x * LEO_NUMBER_STRING_MAX_LENGTH);
+		LEOFormatInteger( x +1, keys[x] );
 	}
+	qsort( keys, inArray->numItems, sizeof(char*), LEOCompareDenseArrayKeys );
+	
+	struct LEOArrayEntry*	theArray = LEOCreateArrayFromSortedDenseItems( keys, inArray->numItems, inArray, inContext );
 	
-	LEOCleanUpValue( &arrayPtr->value, kLEOInvalidateReferences, inContext );
-	free( arrayPtr );
+	free( keyStrings );
+	free( keys );
+	
+	return theArray;
+}
+
+
+static void	LEOPrintDenseArrayIntoBuffer( struct LEODenseArray* inArray, struct LEOArrayPrintBuffer* ioBuffer, struct LEOContext* inContext )
+{
+	char		keyStr[LEO_NUMBER_STRING_MAX_LENGTH];
+	for( size_t x = 0; x < inArray->numItems; x++ )
+	{
+		size_t		keyLength = LEOFormatInteger( x +1, keyStr );
+		LEOArrayPrintBufferAppendKeyAndValue( ioBuffer, keyStr, keyLength, inArray->items +x, inContext );
+		if( !ioBuffer->canGrow && (ioBuffer->length +1) >= ioBuffer->capacity )	// Caller's buffer is full, no use printing the rest.
+			break;
+	}
+	ioBuffer->string[ioBuffer->length] = 0;
+}
+
+
+void	LEOInitDenseArrayValue( LEOValuePtr self, struct LEODenseArray *inArray, LEOKeepReferencesFlag keepReferences, struct LEOContext* inContext )
+{
+	self->base.isa = &kLeoValueTypeDenseArray;
+	if( keepReferences == kLEOInvalidateReferences )
+		self->base.refObjectID = kLEOObjectIDINVALID;
+	self->denseArray.denseArray = inArray;	// *** takes over ownership.
+	self->denseArray.cachedString = NULL;
+}
+
+
+const char*	LEOGetDenseArrayValueAsString( LEOValuePtr self, char* outBuf, size_t bufSize, struct LEOContext* inContext )
+{
+	return LEOGetCachedArrayString( self, &self->denseArray.cachedString, outBuf, bufSize, inContext );
 }
 
 
+void	LEOInitDenseArrayValueCopy( LEOValuePtr self, LEOValuePtr dest, LEOKeepReferencesFlag keepReferences, struct LEOContext* inContext )
+{
+	dest->base.isa = &kLeoValueTypeDenseArray;
+	if( keepReferences == kLEOInvalidateReferences )
+		dest->base.refObjectID = kLEOObjectIDINVALID;
+	dest->denseArray.denseArray = self->denseArray.denseArray;	// Copied lazily once one of us changes it.
+	dest->denseArray.denseArray->referenceCount ++;
+	dest->denseArray.cachedString = NULL;
+}
+
+
+void	LEOPutDenseArrayValueIntoValue( LEOValuePtr self, LEOValuePtr dest, struct LEOContext* inContext )
+{
+	struct LEOArrayEntry*	theArray = LEOCreateArrayFromDenseArray( self->denseArray.denseArray, inContext );
+	LEOSetValueAsArray( dest, theArray, inContext );
+	LEOCleanUpArray( theArray, inContext );
+}
+
+
+void	LEOCleanUpDenseArrayValue( LEOValuePtr self, LEOKeepReferencesFlag keepReferences, struct LEOContext* inContext )
+{
+	self->base.isa = NULL;
+	LEOFlushCachedArrayString( &self->denseArray.cachedString );
+	LEOCleanUpDenseArray( self->denseArray.denseArray, inContext );
+	self->denseArray.denseArray = NULL;
+	if( keepReferences == kLEOInvalidateReferences && self->base.refObjectID != kLEOObjectIDINVALID )	// We have references? Make sure they all notice we've gone if they try to access us from now on.
+	{
+		LEOContextGroupRecycleObjectID( inContext->group, self->base.refObjectID );
+		self->base.refObjectID = 0;
+	}
+}
+
+
+LEOValuePtr		LEOGetDenseArrayValueValueForKey( LEOValuePtr self, const char* inKey, struct LEOContext * inContext )
+{
+	struct LEODenseArray*	theArray = self->denseArray.denseArray;
+	size_t					index = LEOGetDenseArrayIndexForKey( inKey, theArray->numItems );
+	return (index != SIZE_MAX) ? (theArray->items +index) : NULL;
+}
+
+
+void	LEOSetDenseArrayValueValueForKey( LEOValuePtr self, const char* inKey, LEOValuePtr inValue, struct LEOContext * inContext )
+{
+	size_t		index = LEOGetDenseArrayIndexForKey( inKey, self->denseArray.denseArray->numItems );
+	LEOFlushCachedArrayString( &self->denseArray.cachedString );
+	if( index != SIZE_MAX )
+	{
+		LEOMakeDenseArrayUnique( &self->denseArray.denseArray, inContext );
+		LEOValuePtr		theItem = self->denseArray.denseArray->items +index;
+		LEOCleanUpValue( theItem, kLEOKeepReferences, inContext );
+		LEOInitCopy( inValue, theItem, kLEOKeepReferences, inContext );
+	}
+	else	// Any other key, we're not dense anymore:
+	{
+		struct LEOArrayEntry*	theArray = LEOCreateArrayFromDenseArray( self->denseArray.denseArray, inContext );
+		LEOCleanUpDenseArray( self->denseArray.denseArray, inContext );
+		LEOInitArrayValue( self, theArray, kLEOKeepReferences, inContext );
+		LEOAddArrayEntryToRoot( &self->array.array, inKey, inValue, inContext );
+	}
+}
+
+
+size_t	LEOGetDenseArrayValueKeyCount( LEOValuePtr self, struct LEOContext* inContext )
+{
+	return self->denseArray.denseArray->numItems;
+}
+
+
+void	LEOSetDenseArrayValueAsArray( LEOValuePtr self, struct LEOArrayEntry *inArray, struct LEOContext* inContext )
+{
+	struct LEOArrayEntry*	newArray = LEOShareArray( inArray );
+	LEOFlushCachedArrayString( &self->denseArray.cachedString );
+	LEOCleanUpDenseArray( self->denseArray.denseArray, inContext );
+	LEOInitArrayValue( self, newArray, kLEOKeepReferences, inContext );
+}
@@ -30,6 +30,9 @@
 #include <limits.h>
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
 #include "LEOChunks.h"
 
 
@@ -59,9 +62,9 @@ typedef struct LEOValueType *	LEOValueTypePtr;
 /*! A LEOValuePtr is a generic pointer to a LEOValue or one of its subclasses. */
 typedef union LEOValue	*		LEOValuePtr;
 /*! Object IDs are indexes used internally by reference values to look up the referenced value in a way that's safe even after the original has been disposed of. */
-typedef unsigned long			LEOObjectID;
+typedef uint32_t				LEOObjectID;
 /*! An Object Seed is a value used internally to allow reference values to detect whether the slot in which their value used to be has already been reused. */
-typedef unsigned long			LEOObjectSeed;
+typedef uint32_t				LEOObjectSeed;
 
 /*! The type of integers in the language. This is guaranteed to be signed, but large enough to hold a pointer. */
 typedef long long				LEOInteger;
@@ -71,6 +74,25 @@ typedef double					LEONumber;
 
 
 struct LEOContext;
+struct LEOArrayEntry;
+struct LEODenseArray;
+struct LEOSlabAllocator;
+
+
+/*! Built-in value types whose most common accessors the LEOGetValueAsXXX()
+	macros handle right away, instead of calling through the isa's function
+	pointers. All others, e.g. references, arrays and any types the host
+	application defines, are kLEOValueTypeTagOther and always go through
+	their isa. Variants get the same tag as the type they currently hold. */
+enum
+{
+	kLEOValueTypeTagOther = 0,	// Zero, so types that don't specify a tag default to it.
+	kLEOValueTypeTagNumber,
+	kLEOValueTypeTagInteger,
+	kLEOValueTypeTagString,		// Both dynamic strings and string constants.
+	kLEOValueTypeTagBoolean
+};
+typedef int		LEOValueTypeTag;
 
 
 // Layout of the virtual function tables:
@@ -117,6 +139,9 @@ struct LEOValueType
 	void		(*SetValueAsArray)( LEOValuePtr self, struct LEOArrayEntry* inArray, struct LEOContext* inContext );
 	
 	size_t		(*GetKeyCount)( LEOValuePtr self, struct LEOContext* inContext );
+	
+	LEOValueTypeTag	tag;			// Which built-in type this is, for the fast paths in the accessor macros. Must only be set if all the getters behave exactly like that type's.
+	bool		triviallyDestructible;	// Values of this type own nothing, so CleanUp only has to be called if there are references to them.
 };
 
 
@@ -131,6 +156,7 @@ struct LEOValueBase
 {
 	LEOValueTypePtr		isa;			// Virtual function dispatch table.
 	LEOObjectID			refObjectID;	// If we have a reference to us, this is it, so we can clear it on destruction.
+	uint32_t			changeCount;	// Incremented whenever the text of a string value changes, so chunk references can tell whether their cached offsets are still valid.
 };
 
 
@@ -143,6 +169,7 @@ extern struct LEOValueType	kLeoValueTypeBoolean;
 extern struct LEOValueType	kLeoValueTypeReference;
 extern struct LEOValueType	kLeoValueTypeArray;
 extern struct LEOValueType	kLeoValueTypeArrayVariant;
+extern struct LEOValueType	kLeoValueTypeDenseArray;
 extern struct LEOValueType	kLeoValueTypeNumberVariant;
 extern struct LEOValueType	kLeoValueTypeIntegerVariant;
 extern struct LEOValueType	kLeoValueTypeStringVariant;
@@ -187,7 +214,8 @@ typedef struct LEOValueInteger	LEOValueInteger;
 	@field	base	The instance variables inherited from the base class.
 	@field	string	A pointer to the string constant, or to a malloced block
 					of memory holding the string, depending on what kind of
-					string class it is.
+					string class it is. Copies of a dynamic string share the
+					same block, so never change the string in place.
 */
 struct LEOValueString
 {
@@ -212,6 +240,46 @@ struct LEOValueBoolean
 typedef struct LEOValueBoolean	LEOValueBoolean;
 
 
+/*!
+	The chunk range a reference value refers to. Most references refer to a
+	whole value, so we keep this out of the reference itself, which would
+	otherwise make every value on the stack and in an array larger. Copies of
+	a reference share it. The range is never changed once created.
+	
+	Finding a chunk means scanning the referenced string from the start, so
+	when the referenced value is a string, we also remember the byte offsets
+	we found, and reuse them until the string changes. Unlike the range, this
+	cache is shared, mutable state: reading through any copy of the reference
+	may update it for all of them. That is fine because a context's values
+	(and so its references) are only ever used from one thread at a time.
+	@field	referenceCount		Number of reference values using this chunk.
+	@field	chunkType			The type of chunk of the original value this references.
+	@field	chunkStart			The start of the chunk range of the referenced object.
+	@field	chunkEnd			The end of the chunk range of the referenced object.
+	@field	cachedString		The string the cached offsets were found in, or NULL.
+	@field	cachedChangeCount	The referenced value's changeCount when the offsets were found.
+	@field	cachedDelimiter		The item delimiter the offsets were found with.
+	@field	cachedBytesStart	Byte offset of the start of the chunk.
+	@field	cachedBytesEnd		Byte offset of the end of the chunk.
+	@field	cachedBytesDelStart	Byte offset of the start of the chunk plus delimiters, for deleting it.
+	@field	cachedBytesDelEnd	Byte offset of the end of the chunk plus delimiters, for deleting it.
+*/
+struct LEOReferenceChunk
+{
+	size_t			referenceCount;
+	LEOChunkType	chunkType;
+	size_t			chunkStart;
+	size_t			chunkEnd;
+	const char*		cachedString;
+	uint32_t		cachedChangeCount;
+	char			cachedDelimiter;
+	size_t			cachedBytesStart;
+	size_t			cachedBytesEnd;
+	size_t			cachedBytesDelStart;
+	size_t			cachedBytesDelEnd;
+};
+
+
 /*!
 	Essentially our castrated version of a pointer, without pointer arithmetics
 	or other type-unsafeties you wouldn't like to have in our language. A
@@ -227,22 +295,15 @@ typedef struct LEOValueBoolean	LEOValueBoolean;
 						the slot's seed is incremented, and by comparing it to
 						this one, we can detect that even if the slot has been
 						reused in the meantime.
-	@field	chunkType	The type of chunk of the original value this references,
-						or kLEOChunkTypeINVALID if this references the full
-						value.
-	@field	chunkStart	If chunkType isn't kLEOChunkTypeINVALID, this specifies
-						the start of the chunk range of the referenced object.
-	@field	chunkEnd	If chunkType isn't kLEOChunkTypeINVALID, this specifies
-						the end of the chunk range of the referenced object.
+	@field	chunk		NULL if this references the full value, otherwise the
+						chunk of the original value this references.
 */
 struct LEOValueReference
 {
-	struct LEOValueBase	base;
-	LEOObjectID			objectID;
-	LEOObjectSeed		objectSeed;
-	LEOChunkType		chunkType;
-	size_t				chunkStart;
-	size_t				chunkEnd;
+	struct LEOValueBase			base;
+	LEOObjectID					objectID;
+	LEOObjectSeed				objectSeed;
+	struct LEOReferenceChunk	*chunk;
 };
 typedef struct LEOValueReference	LEOValueReference;
 
@@ -252,15 +313,41 @@ typedef struct LEOValueReference	LEOValueReference;
 	continuously numbered, but rather contain items associated with a string.
 	@field	base	The instance variables inherited from the base class.
 	@field	array	Pointer to the root of a B-tree that holds all the array items.
+					Copies of an array value share the same tree until one of them
+					is modified, see LEOShareArray().
+	@field	cachedString	The array written out as text, NULL until someone asks
+					for it, so that LEOGetValueAsString() can hand out the whole
+					text without truncating it. Freed whenever the array is changed.
 */
 struct LEOValueArray
 {
 	struct LEOValueBase		base;
 	struct LEOArrayEntry	*array;
+	char					*cachedString;
 };
 typedef struct LEOValueArray	LEOValueArray;
 
 
+/*!
+	An array whose keys are exactly "1" to "n", like the ones we get when
+	splitting text into lines or items. Instead of a tree, the items are
+	kept in one block, indexed by their key. As soon as anything but one of
+	the existing keys is set, the value turns into a regular LEOValueArray.
+	@field	base		The instance variables inherited from the base class.
+	@field	denseArray	The items. Copies of a dense array value share them
+						until one of them is modified, like LEOValueArray.
+	@field	cachedString	The items written out as text, like the one in
+						LEOValueArray.
+*/
+struct LEOValueDenseArray
+{
+	struct LEOValueBase		base;
+	struct LEODenseArray	*denseArray;
+	char					*cachedString;
+};
+typedef struct LEOValueDenseArray	LEOValueDenseArray;
+
+
 /*!
 	A generic wrapper around foreign objects. The host may provide its own
 	LEOValueType for an individual instance, so don't make any assumptions.
@@ -280,7 +367,8 @@ struct LEOValueObject
 	check the size of each item before initializing.
 	
 	It's probably a good idea to keep all the value structs small, so the stack
-	doesn't grow too large.
+	doesn't grow too large. Right now, the largest one is a reference, at 32
+	bytes on 64-bit CPUs.
 */
 union LEOValue
 {
@@ -291,6 +379,7 @@ union LEOValue
 	struct LEOValueBoolean		boolean;
 	struct LEOValueReference	reference;
 	struct LEOValueArray		array;
+	struct LEOValueDenseArray	denseArray;
 	struct LEOValueObject		object;
 };
 
@@ -327,6 +416,16 @@ void		LEOInitIntegerValue( LEOValuePtr inStorage, LEOInteger inNumber, LEOKeepRe
 */
 void		LEOInitStringValue( LEOValuePtr inStorage, const char* inString, size_t inLen, LEOKeepReferencesFlag keepReferences, struct LEOContext *inContext );
 
+/*!
+	Like LEOInitStringValue, but if the context has an arena, the string's
+	buffer is taken from that instead of the heap. Only use this for values
+	that live on the given context's stack, and that will be cleaned up using
+	the same context. Copies of such a value are regular heap strings.
+
+	@seealso //leo_ref/c/func/LEOContextSetArenaSize LEOContextSetArenaSize
+*/
+void		LEOInitTransientStringValue( LEOValuePtr inStorage, const char* inString, size_t inLen, LEOKeepReferencesFlag keepReferences, struct LEOContext *inContext );
+
 /*!
 	Initialize the given storage so it's a valid string constant value directly
 	referencing the given string. The caller is responsible for ensuring that
@@ -515,6 +614,70 @@ void		LEOInitBooleanVariantValue( LEOValuePtr self, bool inBoolean, LEOKeepRefer
 */
 #define		LEOGetVariantValueSize()				(sizeof(union LEOValue))		
 
+// Fast paths for the built-in types behind the LEOGetValueAsXXX() macros
+//	below. Anything unusual (conversion errors, references, host types...)
+//	still goes through the isa:
+static inline LEONumber		LEOGetValueAsNumberInline( LEOValuePtr v, struct LEOContext* c ) __attribute__((always_inline));
+static inline LEONumber		LEOGetValueAsNumberInline( LEOValuePtr v, struct LEOContext* c )
+{
+	switch( v->base.isa->tag )
+	{
+		case kLEOValueTypeTagNumber:
+			return v->number.number;
+		case kLEOValueTypeTagInteger:
+			return (LEONumber) v->integer.integer;
+		default:
+			return v->base.isa->GetAsNumber( v, c );
+	}
+}
+
+static inline LEOInteger	LEOGetValueAsIntegerInline( LEOValuePtr v, struct LEOContext* c ) __attribute__((always_inline));
+static inline LEOInteger	LEOGetValueAsIntegerInline( LEOValuePtr v, struct LEOContext* c )
+{
+	switch( v->base.isa->tag )
+	{
+		case kLEOValueTypeTagInteger:
+			return v->integer.integer;
+		case kLEOValueTypeTagNumber:
+			if( trunc(v->number.number) == v->number.number )	// Let the isa report fractional numbers.
+				return (LEOInteger) v->number.number;
+			// Fall through.
+		default:
+			return v->base.isa->GetAsInteger( v, c );
+	}
+}
+
+static inline const char*	LEOGetValueAsStringInline( LEOValuePtr v, char* s, size_t l, struct LEOContext* c ) __attribute__((always_inline));
+static inline const char*	LEOGetValueAsStringInline( LEOValuePtr v, char* s, size_t l, struct LEOContext* c )
+{
+	if( v->base.isa->tag == kLEOValueTypeTagString )
+	{
+		if( s )
+			strncpy( s, v->string.string, l );
+		return v->string.string;
+	}
+	return v->base.isa->GetAsString( v, s, l, c );
+}
+
+static inline bool			LEOGetValueAsBooleanInline( LEOValuePtr v, struct LEOContext* c ) __attribute__((always_inline));
+static inline bool			LEOGetValueAsBooleanInline( LEOValuePtr v, struct LEOContext* c )
+{
+	if( v->base.isa->tag == kLEOValueTypeTagBoolean )
+		return v->boolean.boolean;
+	return v->base.isa->GetAsBoolean( v, c );
+}
+
+
+static inline void			LEOCleanUpValueInline( LEOValuePtr v, LEOKeepReferencesFlag k, struct LEOContext* c ) __attribute__((always_inline));
+static inline void			LEOCleanUpValueInline( LEOValuePtr v, LEOKeepReferencesFlag k, struct LEOContext* c )
+{
+	if( v->base.isa->triviallyDestructible && (k == kLEOKeepReferences || v->base.refObjectID == kLEOObjectIDINVALID) )
+		v->base.isa = NULL;
+	else
+		v->base.isa->CleanUp( v, k, c );
+}
+
+
 // Convenience macros for calling virtual methods w/o knowing what object it is:
 /*! @functiongroup LEOValue methods */
 
@@ -527,7 +690,7 @@ void		LEOInitBooleanVariantValue( LEOValuePtr self, bool inBoolean, LEOKeepRefer
 	@param	c	The context in which your script is currently running and in
 				which errors will be stored.
 */
-#define 	LEOGetValueAsNumber(v,c)		((LEOValuePtr)(v))->base.isa->GetAsNumber(((LEOValuePtr)(v)),(c))
+#define 	LEOGetValueAsNumber(v,c)		LEOGetValueAsNumberInline(((LEOValuePtr)(v)),(c))
 
 /*!
 	@function LEOGetValueAsInteger
@@ -538,7 +701,7 @@ void		LEOInitBooleanVariantValue( LEOValuePtr self, bool inBoolean, LEOKeepRefer
 	@param	c	The context in which your script is currently running and in
 				which errors will be stored.
 */
-#define 	LEOGetValueAsInteger(v,c)		((LEOValuePtr)(v))->base.isa->GetAsInteger(((LEOValuePtr)(v)),(c))
+#define 	LEOGetValueAsInteger(v,c)		LEOGetValueAsIntegerInline(((LEOValuePtr)(v)),(c))
 
 /*!
 	@function LEOGetValueAsString
@@ -553,7 +716,7 @@ void		LEOInitBooleanVariantValue( LEOValuePtr self, bool inBoolean, LEOKeepRefer
 	@result		Either s, or a pointer to an internal buffer, if the value has
 				one that contains the entire requested value.
 */
-#define 	LEOGetValueAsString(v,s,l,c)	((LEOValuePtr)(v))->base.isa->GetAsString(((LEOValuePtr)(v)),(s),(l),(c))
+#define 	LEOGetValueAsString(v,s,l,c)	LEOGetValueAsStringInline(((LEOValuePtr)(v)),(s),(l),(c))
 
 /*!
 	@function LEOGetValueAsBoolean
@@ -564,7 +727,7 @@ void		LEOInitBooleanVariantValue( LEOValuePtr self, bool inBoolean, LEOKeepRefer
 	@param	c	The context in which your script is currently running and in
 				which errors will be stored.
 */
-#define 	LEOGetValueAsBoolean(v,c)		((LEOValuePtr)(v))->base.isa->GetAsBoolean(((LEOValuePtr)(v)),(c))
+#define 	LEOGetValueAsBoolean(v,c)		LEOGetValueAsBooleanInline(((LEOValuePtr)(v)),(c))
 
 /*!
 	@function LEOGetValueAsRangeOfString
@@ -775,7 +938,7 @@ void		LEOInitBooleanVariantValue( LEOValuePtr self, bool inBoolean, LEOKeepRefer
 	@param	c	The context in which your script is currently running and in
 				which errors will be stored.
 */
-#define 	LEOCleanUpValue(v,k,c)			do { if( ((LEOValuePtr)(v)) && ((LEOValuePtr)(v))->base.isa ) ((LEOValuePtr)(v))->base.isa->CleanUp(((LEOValuePtr)(v)),(k),(c)); } while(0)
+#define 	LEOCleanUpValue(v,k,c)			do { if( ((LEOValuePtr)(v)) && ((LEOValuePtr)(v))->base.isa ) LEOCleanUpValueInline(((LEOValuePtr)(v)),(k),(c)); } while(0)
 
 
 /*!
@@ -995,16 +1158,35 @@ size_t		LEOGetArrayValueKeyCount( LEOValuePtr self, struct LEOContext* inContext
 
 void		LEOSetArrayValueAsArray( LEOValuePtr self, struct LEOArrayEntry* inArray, struct LEOContext* inContext );
 
+// Dense array value-specific:
+void		LEOInitDenseArrayValue( LEOValuePtr self, struct LEODenseArray *inArray, LEOKeepReferencesFlag keepReferences, struct LEOContext* inContext );	// Takes over ownership of the array.
+void		LEOInitDenseArrayValueCopy( LEOValuePtr self, LEOValuePtr dest, LEOKeepReferencesFlag keepReferences, struct LEOContext* inContext );
+void		LEOPutDenseArrayValueIntoValue( LEOValuePtr self, LEOValuePtr dest, struct LEOContext* inContext );
+const char*	LEOGetDenseArrayValueAsString( LEOValuePtr self, char* outBuf, size_t bufSize, struct LEOContext* inContext );
+void		LEOCleanUpDenseArrayValue( LEOValuePtr self, LEOKeepReferencesFlag keepReferences, struct LEOContext* inContext );
+LEOValuePtr	LEOGetDenseArrayValueValueForKey( LEOValuePtr self, const char* inKey, struct LEOContext * inContext );
+void		LEOSetDenseArrayValueValueForKey( LEOValuePtr self, const char* inKey, LEOValuePtr inValue, struct LEOContext * inContext );
+size_t		LEOGetDenseArrayValueKeyCount( LEOValuePtr self, struct LEOContext* inContext );
+void		LEOSetDenseArrayValueAsArray( LEOValuePtr self, struct LEOArrayEntry* inArray, struct LEOContext* inContext );
+
+// Dense arrays:
+struct LEODenseArray	*	LEOCreateDenseArray( size_t inNumItems, struct LEOContext* inContext );	// The caller must initialize all items before using the array.
+struct LEOArrayEntry	*	LEOCreateArrayFromDenseArray( struct LEODenseArray* inArray, struct LEOContext* inContext );	// Returns a regular array with the same keys and values.
+void						LEOCleanUpDenseArray( struct LEODenseArray* inArray, struct LEOContext* inContext );	// Gives up one owner's claim on the array, disposes of it once nobody shares it anymore.
+
 // Associative arrays:
 struct LEOArrayEntry	*	LEOAllocNewEntry( const char* inKey, LEOValuePtr inValue /* may be NULL */, struct LEOContext* inContext );
 struct LEOArrayEntry	*	LEOCreateArrayFromString( const char* inString, struct LEOContext* inContext );
 LEOValuePtr					LEOAddArrayEntryToRoot( struct LEOArrayEntry** arrayPtrByReference, const char* inKey, LEOValuePtr inValue /* may be NULL */, struct LEOContext* inContext );
 void						LEODeleteArrayEntryFromRoot( struct LEOArrayEntry** arrayPtrByReference, const char* inKey, struct LEOContext* inContext );
 struct LEOArrayEntry*		LEOCopyArray( struct LEOArrayEntry* arrayPtr, struct LEOContext* inContext );
-LEOValuePtr					LEOGetArrayValueForKey( struct LEOArrayEntry* arrayPtr, const char* inKey );
+struct LEOArrayEntry*		LEOShareArray( struct LEOArrayEntry* arrayPtr );	// Adds another owner to the array, returns arrayPtr. Balance with LEOCleanUpArray.
+void						LEOMakeArrayUnique( struct LEOArrayEntry** arrayPtrByReference, struct LEOContext* inContext );	// Call before modifying an array you may share with others.
+LEOValuePtr					LEOGetArrayValueForKey( struct LEOArrayEntry* arrayPtr, const char* inKey );	// Don't modify the value you get, the array may be shared.
 size_t						LEOGetArrayKeyCount( struct LEOArrayEntry* arrayPtr );
 void						LEOPrintArray( struct LEOArrayEntry* arrayPtr, char* strBuf, size_t bufSize, struct LEOContext* inContext );
-void						LEOCleanUpArray( struct LEOArrayEntry* arrayPtr, struct LEOContext* inContext );
+char*						LEOCopyArrayAsString( struct LEOArrayEntry* arrayPtr, size_t* outLength /* may be NULL */, struct LEOContext* inContext );	// Like LEOPrintArray(), but never truncates. Returns a malloc()ed string, free() it when done.
+void						LEOCleanUpArray( struct LEOArrayEntry* arrayPtr, struct LEOContext* inContext );	// Gives up one owner's claim on the array, disposes of it once nobody shares it anymore.
 
 
 // One array entry:
@@ -1012,9 +1194,20 @@ struct LEOArrayEntry
 {
 	struct LEOArrayEntry	*	smallerItem;
 	struct LEOArrayEntry	*	largerItem;
+	size_t						referenceCount;	// Number of owners sharing this array. Only meaningful for the root entry, always 1 for all others.
+	struct LEOSlabAllocator	*	allocator;		// Allocator this entry was taken from, NULL if it was malloc()ed.
 	union LEOValue				value;
 	char						key[0];	// Must be last, dynamically sized array.
 };
 
 
+// A dense array, items[x] is the value for key "x+1":
+struct LEODenseArray
+{
+	size_t			referenceCount;	// Number of owners sharing this array.
+	size_t			numItems;
+	union LEOValue	items[0];		// Must be last, dynamically sized array.
+};
+
+
 #endif // LEO_VALUE_H
@@ -0,0 +1,323 @@
+/*
+ *  LEOVerifier.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOVerifier.h"
+#include "LEOInstructions.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+enum
+{
+	kLEOVerifyParam1IsAddress	= (1 << 0),	// param1 is a basePtr-relative address or BACK_OF_STACK.
+	kLEOVerifyParam1NeverBack	= (1 << 1),	// param1 is a basePtr-relative address, BACK_OF_STACK is not allowed.
+	kLEOVerifyJumps				= (1 << 2),	// param2 is the relative offset of another instruction to continue at.
+	kLEOVerifyNoFallThrough		= (1 << 3),	// Never continues with the next instruction.
+	kLEOVerifyReturns			= (1 << 4),	// Leaves the handler, so the stack must be balanced.
+	kLEOVerifyInvalid			= (1 << 5)	// Never valid in a handler.
+};
+
+
+// -----------------------------------------------------------------------------
+//	Types:
+// -----------------------------------------------------------------------------
+
+// How an instruction changes the stack. 'needed' is the number of values it
+//	expects on the stack (its operands), 'popped' how many of them it removes,
+//	'pushed' how many it adds afterwards. The 'back' variants apply instead
+//	when param1 is BACK_OF_STACK.
+typedef struct LEOInstructionStackEffect
+{
+	int		flags;
+	int		needed;
+	int		popped;
+	int		pushed;
+	int		backNeeded;
+	int		backPopped;
+	int		backPushed;
+} LEOInstructionStackEffect;
+
+
+// -----------------------------------------------------------------------------
+//	Globals:
+// -----------------------------------------------------------------------------
+
+#define ADDRESS		kLEOVerifyParam1IsAddress
+
+static LEOInstructionStackEffect	sInstructionStackEffects[LEO_NUMBER_OF_INSTRUCTIONS] =
+{
+	[INVALID_INSTR]						= { kLEOVerifyInvalid },
+	[EXIT_TO_TOP_INSTR]					= { kLEOVerifyNoFallThrough },
+	[NO_OP_INSTR]						= { 0 },
+	[PUSH_STR_FROM_TABLE_INSTR]			= { 0, 0, 0, 1 },
+	[POP_VALUE_INSTR]					= { ADDRESS, 1, 1, 0, 1, 1, 0 },
+	[PUSH_BOOLEAN_INSTR]				= { 0, 0, 0, 1 },
+	[ASSIGN_STRING_FROM_TABLE_INSTR]	= { ADDRESS, 0, 0, 0, 1, 0, 0 },
+	[JUMP_RELATIVE_INSTR]				= { kLEOVerifyJumps | kLEOVerifyNoFallThrough },
+	[JUMP_RELATIVE_IF_TRUE_INSTR]		= { ADDRESS | kLEOVerifyJumps, 0, 0, 0, 1, 1, 0 },
+	[JUMP_RELATIVE_IF_FALSE_INSTR]		= { ADDRESS | kLEOVerifyJumps, 0, 0, 0, 1, 1, 0 },
+	[JUMP_RELATIVE_IF_GT_ZERO_INSTR]	= { ADDRESS | kLEOVerifyJumps, 0, 0, 0, 1, 1, 0 },
+	[JUMP_RELATIVE_IF_LT_ZERO_INSTR]	= { ADDRESS | kLEOVerifyJumps, 0, 0, 0, 1, 1, 0 },
+	[JUMP_RELATIVE_IF_GT_SAME_ZERO_INSTR] = { ADDRESS | kLEOVerifyJumps, 0, 0, 0, 1, 1, 0 },
+	[JUMP_RELATIVE_IF_LT_SAME_ZERO_INSTR] = { ADDRESS | kLEOVerifyJumps, 0, 0, 0, 1, 1, 0 },
+	[PUSH_NUMBER_INSTR]					= { 0, 0, 0, 1 },
+	[PUSH_INTEGER_INSTR]				= { 0, 0, 0, 1 },
+	[ADD_NUMBER_INSTR]					= { ADDRESS, 0, 0, 0, 1, 0, 0 },
+	[ADD_INTEGER_INSTR]					= { ADDRESS, 0, 0, 0, 1, 0, 0 },
+	[CALL_HANDLER_INSTR]				= { 0 },	// Callers push and pop parameters themselves.
+	[RETURN_FROM_HANDLER_INSTR]			= { kLEOVerifyReturns | kLEOVerifyNoFallThrough },
+	[PUSH_REFERENCE_INSTR]				= { ADDRESS, 0, 0, 1, 1, 0, 1 },
+	[PUSH_CHUNK_REFERENCE_INSTR]		= { ADDRESS | kLEOVerifyParam1NeverBack, 2, 2, 1 },
+	[PARAMETER_INSTR]					= { ADDRESS, 0, 0, 0, 0, 0, 1 },
+	[PARAMETER_COUNT_INSTR]				= { ADDRESS, 0, 0, 0, 0, 0, 1 },
+	[SET_RETURN_VALUE_INSTR]			= { 0, 1, 1, 0 },
+	[PARAMETER_KEEPREFS_INSTR]			= { ADDRESS, 0, 0, 0, 0, 0, 1 },
+	[CONCATENATE_VALUES_INSTR]			= { 0, 2, 2, 1 },
+	[AND_INSTR]							= { 0, 2, 2, 1 },
+	[OR_INSTR]							= { 0, 2, 2, 1 },
+	[CONCATENATE_VALUES_WITH_SPACE_INSTR] = { 0, 2, 2, 1 },
+	[NEGATE_BOOL_INSTR]					= { 0, 1, 1, 1 },
+	[SUBTRACT_COMMAND_INSTR]			= { 0, 2, 2, 0 },
+	[ADD_COMMAND_INSTR]					= { 0, 2, 2, 0 },
+	[MULTIPLY_COMMAND_INSTR]			= { 0, 2, 2, 0 },
+	[DIVIDE_COMMAND_INSTR]				= { 0, 2, 2, 0 },
+	[SUBTRACT_OPERATOR_INSTR]			= { 0, 2, 2, 1 },
+	[ADD_OPERATOR_INSTR]				= { 0, 2, 2, 1 },
+	[MULTIPLY_OPERATOR_INSTR]			= { 0, 2, 2, 1 },
+	[DIVIDE_OPERATOR_INSTR]				= { 0, 2, 2, 1 },
+	[GREATER_THAN_OPERATOR_INSTR]		= { 0, 2, 2, 1 },
+	[LESS_THAN_OPERATOR_INSTR]			= { 0, 2, 2, 1 },
+	[GREATER_THAN_EQUAL_OPERATOR_INSTR]	= { 0, 2, 2, 1 },
+	[LESS_THAN_EQUAL_OPERATOR_INSTR]	= { 0, 2, 2, 1 },
+	[NEGATE_NUMBER_INSTR]				= { 0, 1, 1, 1 },
+	[MODULO_OPERATOR_INSTR]				= { 0, 2, 2, 1 },
+	[POWER_OPERATOR_INSTR]				= { 0, 2, 2, 1 },
+	[EQUAL_OPERATOR_INSTR]				= { 0, 2, 2, 1 },
+	[NOT_EQUAL_OPERATOR_INSTR]			= { 0, 2, 2, 1 },
+	[LINE_MARKER_INSTR]					= { 0 },
+	[ASSIGN_CHUNK_ARRAY_INSTR]			= { ADDRESS, 1, 1, 0, 1, 1, 1 },
+	[GET_ARRAY_ITEM_INSTR]				= { ADDRESS, 2, 0, 0, 2, 0, 1 },
+	[COUNT_CHUNKS_INSTR]				= { 0, 1, 0, 0 },
+	[GET_ARRAY_ITEM_COUNT_INSTR]		= { ADDRESS, 1, 0, 0, 1, 0, 1 },
+	[POP_SIMPLE_VALUE_INSTR]			= { ADDRESS, 1, 1, 0, 1, 1, 0 },
+	[SET_STRING_INSTR]					= { ADDRESS, 1, 1, 0, 2, 2, 0 },
+	[PUSH_CHUNK_INSTR]					= { ADDRESS, 3, 2, 0, 3, 2, 0 },	// Replaces the value below the chunk range with the chunk.
+	[PUSH_ITEMDELIMITER_INSTR]			= { 0, 0, 0, 1 },
+	[SET_ITEMDELIMITER_INSTR]			= { 0, 1, 1, 0 },
+	[PUSH_GLOBAL_REFERENCE_INSTR]		= { 0, 1, 1, 1 },
+	[PUT_VALUE_INTO_VALUE_INSTR]		= { 0, 2, 2, 0 },
+	[PUSH_STR_VARIANT_FROM_TABLE_INSTR]	= { 0, 0, 0, 1 },
+	[NUM_TO_CHAR_INSTR]					= { 0, 1, 1, 1 },
+	[CHAR_TO_NUM_INSTR]					= { 0, 1, 1, 1 },
+	[NUM_TO_HEX_INSTR]					= { 0, 1, 1, 1 },
+	[HEX_TO_NUM_INSTR]					= { 0, 1, 1, 1 }
+};
+
+#undef ADDRESS
+
+
+#pragma mark -
+// -----------------------------------------------------------------------------
+//	Verifier:
+// -----------------------------------------------------------------------------
+
+static bool	LEOVerifierFail( LEOHandler* inHandler, size_t inInstructionIndex, char* outErrMsg, size_t inErrMsgSize, const char* inFormat, ... )
+{
+	char		message[512] = { 0 };
+	va_list		args;
+	va_start( args, inFormat );
+	vsnprintf( message, sizeof(message), inFormat, args );
+	va_end( args );
+
+	LEOInstructionID	instructionID = inHandler->instructions[inInstructionIndex].instructionID;
+	const char*			instructionName = (instructionID < gNumInstructions && gInstructionNames[instructionID]) ? gInstructionNames[instructionID] : "?";
+	snprintf( outErrMsg, inErrMsgSize, "instruction %zu (%s): %s", inInstructionIndex, instructionName, message );
+
+	return false;
+}
+
+
+bool	LEOVerifyHandler( LEOHandler* inHandler, char* outErrMsg, size_t inErrMsgSize )
+{
+	inHandler->verified = false;
+	inHandler->maxStackDepth = 0;
+
+	if( inHandler->numInstructions == 0 )
+	{
+		snprintf( outErrMsg, inErrMsgSize, "Handler has no instructions." );
+		return false;
+	}
+
+	LEOInitInstructionArray();
+
+	// Number of values above the base pointer before each instruction, or -1
+	//	if we haven't found a path to that instruction yet:
+	long*		depths = malloc( inHandler->numInstructions * sizeof(long) );
+	size_t*		pending = malloc( inHandler->numInstructions * sizeof(size_t) );
+	size_t		numPending = 0;
+	size_t		maxDepth = 0;
+	bool		success = true;
+	if( !depths || !pending )
+	{
+		snprintf( outErrMsg, inErrMsgSize, "Out of memory." );
+		success = false;
+	}
+	else
+	{
+		for( size_t x = 0; x < inHandler->numInstructions; x++ )
+			depths[x] = -1;
+		depths[0] = 0;
+		pending[numPending++] = 0;
+	}
+
+	while( success && numPending > 0 )
+	{
+		size_t				currIndex = pending[--numPending];
+		LEOInstruction*		currInstr = inHandler->instructions +currIndex;
+		long				depth = depths[currIndex];
+
+		if( currInstr->instructionID >= gNumInstructions )
+		{
+			success = LEOVerifierFail( inHandler, currIndex, outErrMsg, inErrMsgSize, "Unknown instruction %u.", currInstr->instructionID );
+			break;
+		}
+		if( currInstr->instructionID >= LEO_NUMBER_OF_INSTRUCTIONS )
+		{
+			success = LEOVerifierFail( inHandler, currIndex, outErrMsg, inErrMsgSize, "Host instructions can't be verified." );
+			break;
+		}
+
+		const LEOInstructionStackEffect*	effect = sInstructionStackEffects +currInstr->instructionID;
+		if( effect->flags & kLEOVerifyInvalid )
+		{
+			success = LEOVerifierFail( inHandler, currIndex, outErrMsg, inErrMsgSize, "Invalid instruction." );
+			break;
+		}
+
+		bool	onStack = (effect->flags & kLEOVerifyParam1IsAddress) && currInstr->param1 == BACK_OF_STACK;
+		int		needed = onStack ? effect->backNeeded : effect->needed;
+		int		popped = onStack ? effect->backPopped : effect->popped;
+		int		pushed = onStack ? effect->backPushed : effect->pushed;
+
+		if( depth < needed )
+		{
+			success = LEOVerifierFail( inHandler, currIndex, outErrMsg, inErrMsgSize, "Needs %d operands, but the stack only holds %ld values.", needed, depth );
+			break;
+		}
+		if( (effect->flags & kLEOVerifyParam1IsAddress) && !onStack )
+		{
+			// Addresses must refer to a value below the operands, or we'd
+			//	overwrite an operand or a value that is popped off the stack:
+			long	address = *(int16_t*)&currInstr->param1;
+			if( address < 0 || address >= (depth -needed) )
+			{
+				success = LEOVerifierFail( inHandler, currIndex, outErrMsg, inErrMsgSize, "Address %ld is outside the handler's %ld local values.", address, depth -needed );
+				break;
+			}
+		}
+		else if( onStack && (effect->flags & kLEOVerifyParam1NeverBack) )
+		{
+			success = LEOVerifierFail( inHandler, currIndex, outErrMsg, inErrMsgSize, "Needs an address, not BACK_OF_STACK." );
+			break;
+		}
+
+		long	newDepth = depth -popped +pushed;
+		if( newDepth > LEO_STACK_SIZE )
+		{
+			success = LEOVerifierFail( inHandler, currIndex, outErrMsg, inErrMsgSize, "Pushes more values than fit on the stack." );
+			break;
+		}
+		if( (size_t)newDepth > maxDepth )
+			maxDepth = newDepth;
+
+		if( (effect->flags & kLEOVerifyReturns) && newDepth != 0 )
+		{
+			success = LEOVerifierFail( inHandler, currIndex, outErrMsg, inErrMsgSize, "Returns without popping %ld values off the stack.", newDepth );
+			break;
+		}
+
+		// Queue up the instructions that can run after this one:
+		size_t		successors[2] = { 0 };
+		size_t		numSuccessors = 0;
+		if( (effect->flags & kLEOVerifyNoFallThrough) == 0 )
+		{
+			if( (currIndex +1) >= inHandler->numInstructions )
+			{
+				success = LEOVerifierFail( inHandler, currIndex, outErrMsg, inErrMsgSize, "Runs past the end of the handler." );
+				break;
+			}
+			successors[numSuccessors++] = currIndex +1;
+		}
+		if( effect->flags & kLEOVerifyJumps )
+		{
+			long long	target = (long long)currIndex +LEOCastUInt32ToInt32( currInstr->param2 );
+			if( target < 0 || target >= (long long)inHandler->numInstructions )
+			{
+				success = LEOVerifierFail( inHandler, currIndex, outErrMsg, inErrMsgSize, "Jumps to instruction %lld outside the handler.", target );
+				break;
+			}
+			successors[numSuccessors++] = (size_t) target;
+		}
+
+		for( size_t x = 0; x < numSuccessors; x++ )
+		{
+			if( depths[successors[x]] < 0 )
+			{
+				depths[successors[x]] = newDepth;
+				pending[numPending++] = successors[x];
+			}
+			else if( depths[successors[x]] != newDepth )
+			{
+				success = LEOVerifierFail( inHandler, successors[x], outErrMsg, inErrMsgSize, "Reached with %ld and with %ld values on the stack.", depths[successors[x]], newDepth );
+				break;
+			}
+		}
+	}
+
+	if( depths )
+		free( depths );
+	if( pending )
+		free( pending );
+
+	if( success )
+	{
+		inHandler->maxStackDepth = maxDepth;
+		inHandler->verified = true;
+	}
+
+	return success;
+}
+
+
+bool	LEOVerifyScript( LEOScript* inScript, char* outErrMsg, size_t inErrMsgSize )
+{
+	bool	success = true;
+	char	errMsg[1024] = { 0 };
+
+	for( size_t x = 0; x < inScript->numCommands +inScript->numFunctions; x++ )
+	{
+		LEOHandler*	theHandler = (x < inScript->numCommands) ? (inScript->commands +x) : (inScript->functions +x -inScript->numCommands);
+		if( !LEOVerifyHandler( theHandler, errMsg, sizeof(errMsg) ) && success )
+		{
+			snprintf( outErrMsg, inErrMsgSize, "%s", errMsg );
+			success = false;
+		}
+	}
+
+	return success;
+}
@@ -0,0 +1,75 @@
+/*
+ *  LEOVerifier.h
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*!
+	@header LEOVerifier
+	Instructions trust their parameters: a basePtr-relative address in param1
+	is used without checking that there is a value at that address, and
+	instructions that pop values off the stack don't check that there are
+	any. That's fine for bytecode generated by a compiler, but the
+	interpreter still has to check every instruction's ID before calling it.
+
+	The verifier goes over all paths through a handler once before it is
+	run, and proves that:
+	<ul>
+	<li>every instruction ID is one of the built-in instructions,</li>
+	<li>every relative jump lands on an instruction of the same handler, and
+		no path runs past the last instruction,</li>
+	<li>every path arriving at an instruction has the same number of values
+		on the stack, no instruction pops more values than are there, and
+		every handler has popped all values it pushed when it returns,</li>
+	<li>every basePtr-relative address refers to a value the handler pushed
+		earlier, and that isn't one of the instruction's own operands.</li>
+	</ul>
+	It also remembers the most values the handler ever has on the stack, so
+	LEORunInContext() only has to check once per call that they fit, and can
+	run verified handlers without any per-instruction checks.
+
+	Host instructions can't be verified, as we don't know what they do to the
+	stack. Handlers using them are just run with the usual checks.
+*/
+
+#ifndef LEO_VERIFIER_H
+#define LEO_VERIFIER_H		1
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOScript.h"
+
+
+// -----------------------------------------------------------------------------
+//	Prototypes:
+// -----------------------------------------------------------------------------
+
+/*!
+	Check the given handler's instructions as described above and set its
+	verified and maxStackDepth fields accordingly. Call this again if you
+	change a handler's instructions directly instead of using
+	LEOHandlerAddInstruction().
+	@result TRUE if the handler may be run without per-instruction checks.
+			FALSE if it can't, in which case a message describing the first
+			problem found has been written to outErrMsg (which is
+			inErrMsgSize bytes large).
+*/
+bool	LEOVerifyHandler( LEOHandler* inHandler, char* outErrMsg, size_t inErrMsgSize );
+
+/*!
+	Verify all commands and functions in the given script using
+	LEOVerifyHandler(). Handlers that fail verification still run, just with
+	per-instruction checks.
+	@result TRUE if all handlers were verified. FALSE if at least one wasn't,
+			in which case the message for the first one that wasn't has been
+			written to outErrMsg (which is inErrMsgSize bytes large).
+*/
+bool	LEOVerifyScript( LEOScript* inScript, char* outErrMsg, size_t inErrMsgSize );
+
+
+#endif // LEO_VERIFIER_H
@@ -0,0 +1,378 @@
+/*
+ *  RunnerMain.c
+ *  Leonie
+ *
+ *  Created by Uli Kusterer on 19.10.26.
+ *  Copyright 2010 Uli Kusterer. All rights reserved.
+ *
+ */
+
+/*
+	Loads scripts saved using LEOBytecodeFileWriteScript() or written in
+	LEOAssembler's text format and runs one of their command handlers.
+
+	Usage: leonie-run [--no-verify] [--handler <name>] <script file> [<parameter> ...]
+	       leonie-run --batch [--jobs <n>] [--no-verify] [--handler <name>] <script file> ...
+	       leonie-run --assemble <script file> <bytecode file>
+	       leonie-run --disassemble <script file>
+
+	The handler defaults to "main". The generic message instructions (e.g.
+	"Print") are available to the scripts.
+
+	The first form runs a single script, passing it the remaining arguments
+	as parameters. The second form runs each of the given scripts (without
+	parameters) on a pool of worker threads, one context group per script,
+	and then prints how long each of them took and how many instructions it
+	executed. --jobs defaults to the number of CPUs.
+
+	Scripts are verified after loading (see LEOVerifier.h), so handlers that
+	pass run without per-instruction checks. --no-verify turns that off.
+
+	--assemble saves a script as a bytecode file, --disassemble prints it as
+	assembly text.
+
+	Exits with EXIT_FAILURE if a file couldn't be loaded or a script stopped
+	with an error.
+*/
+
+// -----------------------------------------------------------------------------
+//	Headers:
+// -----------------------------------------------------------------------------
+
+#include "LEOInterpreter.h"
+#include "LEOContextGroup.h"
+#include "LEOScript.h"
+#include "LEOBytecodeFile.h"
+#include "LEOAssembler.h"
+#include "LEOVerifier.h"
+#include "LEOMsgInstructions.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+
+// -----------------------------------------------------------------------------
+//	Constants:
+// -----------------------------------------------------------------------------
+
+#define LEO_RUNNER_DEFAULT_HANDLER		"main"
+#define LEO_RUNNER_ERROR_MESSAGE_SIZE	1024
+
+
+// -----------------------------------------------------------------------------
+//	Globals:
+// -----------------------------------------------------------------------------
+
+static bool		sVerifyScripts = true;	// Cleared by --no-verify.
+
+
+// -----------------------------------------------------------------------------
+//	Types:
+// -----------------------------------------------------------------------------
+
+/*! One script to run and what happened when we ran it.
+	@field	filePath			The bytecode or assembly file to load the script from.
+	@field	succeeded			TRUE if the script was loaded and ran without an error.
+	@field	errMsg				What went wrong, if succeeded is FALSE.
+	@field	elapsedTime			Nanoseconds spent loading and running the script.
+	@field	numInstructions		Number of instructions the script executed.
+*/
+typedef struct LEORunnerJob
+{
+	const char*		filePath;
+	bool			succeeded;
+	char			errMsg[LEO_RUNNER_ERROR_MESSAGE_SIZE];
+	double			elapsedTime;
+	size_t			numInstructions;
+} LEORunnerJob;
+
+
+/*! The jobs of a batch, shared by all worker threads.
+	@field	handlerName		The handler to run in each script.
+	@field	numJobs			Number of items in jobs.
+	@field	jobs			The scripts to run.
+	@field	nextJob			Index of the next job a worker should pick up.
+*/
+typedef struct LEORunnerBatch
+{
+	const char*		handlerName;
+	size_t			numJobs;
+	LEORunnerJob*	jobs;
+	size_t			nextJob;
+} LEORunnerBatch;
+
+
+// -----------------------------------------------------------------------------
+//	Helpers:
+// -----------------------------------------------------------------------------
+
+static double	LEORunnerNow( void )
+{
+	struct timespec		now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (now.tv_sec * 1000000000.0) +now.tv_nsec;
+}
+
+
+static void	PrintUsage( const char* inToolName )
+{
+	fprintf( stderr, "Usage: %s [--no-verify] [--handler <name>] <script file> [<parameter> ...]\n", inToolName );
+	fprintf( stderr, "       %s --batch [--jobs <n>] [--no-verify] [--handler <name>] <script file> ...\n", inToolName );
+	fprintf( stderr, "       %s --assemble <script file> <bytecode file>\n", inToolName );
+	fprintf( stderr, "       %s --disassemble <script file>\n", inToolName );
+}
+
+
+// Load a bytecode file, or assemble the file if it isn't one:
+static LEOScript*	LEORunnerLoadScript( const char* inFilePath, LEOContextGroup* inGroup, char* outErrMsg, size_t inErrMsgSize )
+{
+	FILE*	theFile = fopen( inFilePath, "rb" );
+	if( !theFile )
+	{
+		snprintf( outErrMsg, inErrMsgSize, "Couldn't open file." );
+		return NULL;
+	}
+
+	LEOScript*	theScript = NULL;
+	char		magic[4] = { 0 };
+	if( fread( magic, 1, sizeof(magic), theFile ) == sizeof(magic) && memcmp( magic, "LEOB", sizeof(magic) ) == 0 )
+	{
+		rewind( theFile );
+		theScript = LEOBytecodeFileReadScript( theFile, inGroup, outErrMsg, inErrMsgSize );
+	}
+	else
+	{
+		size_t	textLength = 0;
+		char*	theText = NULL;
+		fseek( theFile, 0, SEEK_END );
+		long	fileSize = ftell( theFile );
+		rewind( theFile );
+		if( fileSize >= 0 )
+		{
+			theText = malloc( fileSize +1 );
+			textLength = fread( theText, 1, fileSize, theFile );
+		}
+		if( theText && textLength == (size_t)fileSize )
+			theScript = LEOAssembleScript( theText, textLength, inGroup, outErrMsg, inErrMsgSize );
+		else
+			snprintf( outErrMsg, inErrMsgSize, "Couldn't read file." );
+		if( theText )
+			free( theText );
+	}
+	fclose( theFile );
+
+	// Handlers that can't be verified (e.g. because they use host
+	//	instructions) still run, just with all checks, so ignore failures:
+	if( theScript && sVerifyScripts )
+	{
+		char	verifyErrMsg[LEO_RUNNER_ERROR_MESSAGE_SIZE] = { 0 };
+		LEOVerifyScript( theScript, verifyErrMsg, sizeof(verifyErrMsg) );
+	}
+
+	return theScript;
+}
+
+
+// Assemble or disassemble the given script file:
+static int	LEORunnerConvertScript( const char* inFilePath, const char* inOutputPath )
+{
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	char				errMsg[LEO_RUNNER_ERROR_MESSAGE_SIZE] = { 0 };
+	LEOScript*			theScript = LEORunnerLoadScript( inFilePath, group, errMsg, sizeof(errMsg) );
+	bool				succeeded = false;
+	if( !theScript )
+		fprintf( stderr, "error: %s: %s\n", inFilePath, errMsg );
+	else if( inOutputPath )
+	{
+		FILE*	outFile = fopen( inOutputPath, "wb" );
+		succeeded = outFile && LEOBytecodeFileWriteScript( theScript, group, outFile );
+		if( outFile && fclose( outFile ) != 0 )
+			succeeded = false;
+		if( !succeeded )
+			fprintf( stderr, "error: Couldn't write \"%s\".\n", inOutputPath );
+	}
+	else
+		succeeded = LEODisassembleScript( theScript, group, stdout );
+
+	if( theScript )
+		LEOScriptRelease( theScript );
+	LEOContextGroupRelease( group );
+
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+// Load the job's script into a context group of its own and run the given
+//	handler, passing it the given parameters. Each job gets its own group, so
+//	jobs on different threads don't share anything:
+static void	LEORunnerRunJob( LEORunnerJob* ioJob, const char* inHandlerName, int inNumParams, const char** inParams )
+{
+	double		startTime = LEORunnerNow();
+
+	ioJob->succeeded = false;
+	ioJob->errMsg[0] = 0;
+	ioJob->numInstructions = 0;
+
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	LEOScript*			theScript = LEORunnerLoadScript( ioJob->filePath, group, ioJob->errMsg, sizeof(ioJob->errMsg) );
+	if( theScript )
+	{
+		LEOHandler*	theHandler = LEOScriptFindCommandHandlerWithID( theScript, LEOContextGroupHandlerIDForHandlerName( group, inHandlerName ) );
+		if( theHandler )
+		{
+			// Push the parameters in reverse, followed by their count, like CALL_HANDLER_INSTR's caller would:
+			LEOContext		ctx;
+			LEOStatistics	stats;
+			LEOInitContext( &ctx, group );
+			for( int x = inNumParams -1; x >= 0; x-- )
+				LEOPushStringValueOnStack( &ctx, inParams[x], strlen(inParams[x]) );
+			LEOPushIntegerOnStack( &ctx, inNumParams );
+
+			LEOContextPushHandlerScriptReturnAddressAndBasePtr( &ctx, theHandler, theScript, NULL, NULL );
+			LEORunInContext( theHandler->instructions, &ctx );
+
+			ioJob->succeeded = (ctx.errMsg[0] == 0);
+			if( !ioJob->succeeded )
+				snprintf( ioJob->errMsg, sizeof(ioJob->errMsg), "%s", ctx.errMsg );
+			LEOContextGetStatistics( &ctx, &stats );
+			ioJob->numInstructions = stats.numInstructions;
+
+			LEOCleanUpContext( &ctx );
+		}
+		else
+			snprintf( ioJob->errMsg, sizeof(ioJob->errMsg), "No handler named \"%s\".", inHandlerName );
+
+		LEOScriptRelease( theScript );
+	}
+	LEOContextGroupRelease( group );
+
+	ioJob->elapsedTime = LEORunnerNow() -startTime;
+}
+
+
+static void*	LEORunnerWorkerThread( void* inBatch )
+{
+	LEORunnerBatch*	theBatch = inBatch;
+
+	while( true )
+	{
+		size_t	jobIndex = __atomic_fetch_add( &theBatch->nextJob, 1, __ATOMIC_RELAXED );
+		if( jobIndex >= theBatch->numJobs )
+			break;
+		LEORunnerRunJob( theBatch->jobs +jobIndex, theBatch->handlerName, 0, NULL );
+	}
+
+	return NULL;
+}
+
+
+static int	LEORunnerRunBatch( const char* inHandlerName, size_t inNumThreads, int inNumFiles, const char** inFilePaths )
+{
+	LEORunnerBatch	theBatch = { inHandlerName, inNumFiles, calloc( inNumFiles, sizeof(LEORunnerJob) ), 0 };
+	for( int x = 0; x < inNumFiles; x++ )
+		theBatch.jobs[x].filePath = inFilePaths[x];
+
+	if( inNumThreads > (size_t)inNumFiles )
+		inNumThreads = inNumFiles;
+	pthread_t*	threads = calloc( inNumThreads, sizeof(pthread_t) );
+	double		startTime = LEORunnerNow();
+	size_t		numThreadsStarted = 0;
+	for( numThreadsStarted = 0; numThreadsStarted < inNumThreads; numThreadsStarted++ )
+	{
+		if( pthread_create( threads +numThreadsStarted, NULL, LEORunnerWorkerThread, &theBatch ) != 0 )
+			break;
+	}
+	if( numThreadsStarted == 0 )	// Couldn't start any threads? Do the work ourselves.
+		LEORunnerWorkerThread( &theBatch );
+	for( size_t x = 0; x < numThreadsStarted; x++ )
+		pthread_join( threads[x], NULL );
+	double		elapsedTime = LEORunnerNow() -startTime;
+	free( threads );
+
+	size_t		numFailed = 0;
+	size_t		totalInstructions = 0;
+	double		totalScriptTime = 0;
+	printf( "%-6s %12s %14s  %s\n", "status", "time (ms)", "instructions", "script" );
+	for( size_t x = 0; x < theBatch.numJobs; x++ )
+	{
+		LEORunnerJob*	currJob = theBatch.jobs +x;
+		printf( "%-6s %12.3f %14zu  %s", currJob->succeeded ? "ok" : "FAILED", currJob->elapsedTime / 1000000.0, currJob->numInstructions, currJob->filePath );
+		if( !currJob->succeeded )
+		{
+			printf( ": %s", currJob->errMsg );
+			numFailed++;
+		}
+		printf( "\n" );
+		totalInstructions += currJob->numInstructions;
+		totalScriptTime += currJob->elapsedTime;
+	}
+	printf( "\n%zu scripts, %zu failed, %zu instructions, %.3f ms (%.3f ms in scripts) on %zu threads.\n",
+			theBatch.numJobs, numFailed, totalInstructions, elapsedTime / 1000000.0, totalScriptTime / 1000000.0,
+			(numThreadsStarted > 0) ? numThreadsStarted : 1 );
+
+	free( theBatch.jobs );
+
+	return (numFailed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+#pragma mark -
+
+int main( int argc, const char * argv[] )
+{
+	const char*		handlerName = LEO_RUNNER_DEFAULT_HANDLER;
+	bool			batchMode = false;
+	bool			assemble = false;
+	bool			disassemble = false;
+	long			numThreads = sysconf( _SC_NPROCESSORS_ONLN );
+	int				currArg = 1;
+
+	for( ; currArg < argc && argv[currArg][0] == '-'; currArg++ )
+	{
+		if( strcmp( argv[currArg], "--handler" ) == 0 && (currArg +1) < argc )
+			handlerName = argv[++currArg];
+		else if( strcmp( argv[currArg], "--batch" ) == 0 )
+			batchMode = true;
+		else if( strcmp( argv[currArg], "--assemble" ) == 0 )
+			assemble = true;
+		else if( strcmp( argv[currArg], "--disassemble" ) == 0 )
+			disassemble = true;
+		else if( strcmp( argv[currArg], "--no-verify" ) == 0 )
+			sVerifyScripts = false;
+		else if( strcmp( argv[currArg], "--jobs" ) == 0 && (currArg +1) < argc )
+			numThreads = strtol( argv[++currArg], NULL, 10 );
+		else
+		{
+			PrintUsage( argv[0] );
+			return EXIT_FAILURE;
+		}
+	}
+	if( currArg >= argc || numThreads < 1 || (assemble && (currArg +2) != argc) || (disassemble && (currArg +1) != argc) )
+	{
+		PrintUsage( argv[0] );
+		return EXIT_FAILURE;
+	}
+
+	// Instruction IDs are global, so set them up before any threads are started:
+	LEOInitInstructionArray();
+	LEOAddInstructionsToInstructionArray( gMsgInstructions, gMsgInstructionNames, LEO_NUMBER_OF_MSG_INSTRUCTIONS, &kFirstMsgInstruction );
+
+	if( assemble || disassemble )
+		return LEORunnerConvertScript( argv[currArg], assemble ? argv[currArg +1] : NULL );
+	if( batchMode )
+		return LEORunnerRunBatch( handlerName, numThreads, argc -currArg, argv +currArg );
+
+	LEORunnerJob	theJob = { 0 };
+	theJob.filePath = argv[currArg];
+	LEORunnerRunJob( &theJob, handlerName, argc -currArg -1, argv +currArg +1 );
+	if( !theJob.succeeded )
+	{
+		fprintf( stderr, "error: %s: %s\n", theJob.filePath, theJob.errMsg );
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -11,14 +11,28 @@
 #include "LEOChunks.h"
 #include "LEOContextGroup.h"
 #include "LEOScript.h"
+#include "LEOContextPool.h"
+#include "LEOArena.h"
+#include "LEOSlabAllocator.h"
+#include "LEOProfiler.h"
+#include "LEOTrace.h"
+#include "LEOBytecodeFile.h"
+#include "LEOAssembler.h"
+#include "LEOVerifier.h"
+#include "LEONumberConversion.h"
+#include "LEOInstructions.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <math.h>
 
 
-#define ASSERT(expr)	({ if( !(expr) ) printf( "error: Test failed: %s\n", #expr ); else printf( "note: Test passed: %s\n", #expr ); })
-#define ASSERT_STRING_MATCH(a,b)	({ if( strcmp( (a), (b) ) != 0 ) printf( "error: Test failed: \"%s\" != \"%s\"\n", (a), (b) ); else printf( "note: Test passed: \"%s\" == \"%s\"\n", (a), (b) ); })
+static size_t	gNumFailedTests = 0;
+
+
+#define ASSERT(expr)	({ if( !(expr) ) { printf( "error: Test failed: %s\n", #expr ); gNumFailedTests++; } else printf( "note: Test passed: %s\n", #expr ); })
+#define ASSERT_STRING_MATCH(a,b)	({ if( strcmp( (a), (b) ) != 0 ) { printf( "error: Test failed: \"%s\" != \"%s\"\n", (a), (b) ); gNumFailedTests++; } else printf( "note: Test passed: \"%s\" == \"%s\"\n", (a), (b) ); })
 
 
 void	ASSERT_RANGE_MATCHES_STRING( const char* theStr, size_t chunkStart, size_t chunkEnd, const char* matchStr )
@@ -34,7 +48,10 @@ void	ASSERT_RANGE_MATCHES_STRING( const char* theStr, size_t chunkStart, size_t
 	if( strcmp(substr, matchStr) == 0 )
 		printf( "note: Range %lu to %lu of \"%s\" matches \"%s\"\n", chunkStart, chunkEnd, theStr, matchStr );
 	else
+	{
 		printf( "error: Test failed: Range %lu to %lu of \"%s\" doesn't match \"%s\"\n", chunkStart, chunkEnd, theStr, matchStr );
+		gNumFailedTests++;
+	}
 }
 
 
@@ -42,7 +59,7 @@ void	ASSERT_RANGE_MATCHES_STRING( const char* theStr, size_t chunkStart, size_t
 void	DoScriptTest( void )
 {
 	LEOContextGroup	*	group = LEOContextGroupCreate();
-	LEOScript		*	theScript = LEOScriptCreateForOwner( 0, 0 );
+	LEOScript		*	theScript = LEOScriptCreateForOwner( 0, 0, NULL );
 	LEOHandler		*	newHandler = NULL;
 	LEOHandler		*	foundHandler = NULL;
 	
@@ -549,6 +566,101 @@ void	DoReferenceTest( void )
 }
 
 
+static LEONumber	LEOGetHostValueAsNumber( LEOValuePtr self, struct LEOContext* inContext )
+{
+	return 42.0;
+}
+
+
+void	DoValueTypeTagTest( void )
+{
+	LEOContext			ctx;
+	union LEOValue		theValue;
+	char				str[256];
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: Value type tag tests\n" );
+	
+	// The fast paths must agree with the isa:
+	LEOInitNumberValue( &theValue, 12.0, kLEOInvalidateReferences, &ctx );
+	ASSERT( LEOGetValueAsNumber( &theValue, &ctx ) == 12.0 );
+	ASSERT( LEOGetValueAsInteger( &theValue, &ctx ) == 12 );
+	LEOSetValueAsNumber( &theValue, 1.5, &ctx );
+	ASSERT( ctx.keepRunning == true );
+	LEOGetValueAsInteger( &theValue, &ctx );	// Fractional numbers are still reported by the isa.
+	ASSERT( ctx.keepRunning == false );
+	ctx.keepRunning = true;
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	
+	LEOInitIntegerValue( &theValue, -7, kLEOInvalidateReferences, &ctx );
+	ASSERT( LEOGetValueAsNumber( &theValue, &ctx ) == -7.0 );
+	ASSERT( LEOGetValueAsInteger( &theValue, &ctx ) == -7 );
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	
+	LEOInitStringConstantValue( &theValue, "true", kLEOInvalidateReferences, &ctx );
+	ASSERT( LEOGetValueAsString( &theValue, str, sizeof(str), &ctx ) == theValue.string.string );
+	ASSERT( strcmp( str, "true" ) == 0 );
+	ASSERT( LEOGetValueAsBoolean( &theValue, &ctx ) == true );
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	
+	LEOInitBooleanValue( &theValue, true, kLEOInvalidateReferences, &ctx );
+	ASSERT( LEOGetValueAsBoolean( &theValue, &ctx ) == true );
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	
+	// Types the host defines don't set a tag, and always go through their isa:
+	struct LEOValueType	hostType = kLeoValueTypeNumber;
+	hostType.displayTypeName = "host number";
+	hostType.GetAsNumber = LEOGetHostValueAsNumber;
+	hostType.tag = kLEOValueTypeTagOther;
+	LEOInitNumberValue( &theValue, 12.0, kLEOInvalidateReferences, &ctx );
+	theValue.base.isa = &hostType;
+	ASSERT( LEOGetValueAsNumber( &theValue, &ctx ) == 42.0 );
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	
+	LEOCleanUpContext( &ctx );
+}
+
+
+void	DoStackUnwindingTest( void )
+{
+	LEOContext			ctx;
+	union LEOValue		theReference;
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	ctx.stackEndPtr = ctx.stack;
+	
+	printf( "\nnote: Stack unwinding tests\n" );
+	
+	LEOInitIntegerValue( ctx.stackEndPtr++, 1, kLEOInvalidateReferences, &ctx );
+	LEOInitNumberValue( ctx.stackEndPtr++, 2.5, kLEOInvalidateReferences, &ctx );
+	LEOInitStringValue( ctx.stackEndPtr++, "three", 5, kLEOInvalidateReferences, &ctx );
+	LEOInitBooleanValue( ctx.stackEndPtr++, true, kLEOInvalidateReferences, &ctx );
+	LEOInitReferenceValue( &theReference, ctx.stack +1, kLEOInvalidateReferences, kLEOChunkTypeINVALID, 0, 0, &ctx );
+	ASSERT( LEOGetValueAsNumber( &theReference, &ctx ) == 2.5 );
+	
+	LEOCleanUpStackToPtr( &ctx, ctx.stack +1 );
+	ASSERT( ctx.stackEndPtr == ctx.stack +1 );
+	ASSERT( ctx.stack[1].base.isa == NULL && ctx.stack[2].base.isa == NULL && ctx.stack[3].base.isa == NULL );
+	ASSERT( ctx.stack[0].base.isa == &kLeoValueTypeInteger );
+	
+	// Numbers may be trivial to clean up, but references to them must still notice they're gone:
+	LEOGetValueAsNumber( &theReference, &ctx );
+	ASSERT( ctx.keepRunning == false );
+	ctx.keepRunning = true;
+	
+	LEOCleanUpStackToPtr( &ctx, ctx.stack );
+	ASSERT( ctx.stackEndPtr == ctx.stack );
+	
+	LEOCleanUpValue( &theReference, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpContext( &ctx );
+}
+
+
 void	DoWordsTestSingleSpaced( void )
 {
 	printf( "\nnote: Single-spaced words chunk tests\n" );
@@ -823,10 +935,86 @@ void	DoChunkReferenceTests( void )
 	memset( str, 'X', sizeof(str) );
 	LEOGetValueAsString( &valueRefReference, str, sizeof(str), &ctx );
 	ASSERT( strcmp(str,"THIS") == 0 );
+
+	// Copies share the chunk, which must survive the original going away:
+	union LEOValue		referenceCopy;
+	LEOInitCopy( &valueReference, &referenceCopy, kLEOInvalidateReferences, &ctx );
+	ASSERT( referenceCopy.reference.chunk == valueReference.reference.chunk );
+	ASSERT( referenceCopy.reference.chunk->referenceCount == 2 );
+	LEOCleanUpValue( &valueReference, kLEOInvalidateReferences, &ctx );
+	ASSERT( referenceCopy.reference.chunk->referenceCount == 1 );
+	memset( str, 'X', sizeof(str) );
+	LEOGetValueAsString( &referenceCopy, str, sizeof(str), &ctx );
+	ASSERT( strcmp(str,"THIS,that") == 0 );
+
+	// References to whole values don't need a chunk, and all values stay small:
+	LEOInitReferenceValue( &valueReference, &theValue, kLEOInvalidateReferences, kLEOChunkTypeINVALID, 0, 0, &ctx );
+	ASSERT( valueReference.reference.chunk == NULL );
+	ASSERT( sizeof(union LEOValue) <= 32 );
+
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &valueReference, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &valueRefReference, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &referenceCopy, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpContext( &ctx );
+}
+
+
+void	DoChunkReferenceCacheTest( void )
+{
+	LEOContext			ctx;
+	union LEOValue		theValue;
+	union LEOValue		itemReference;
+	char				str[256];
+	LEOContextGroup*	group = LEOContextGroupCreate();
 	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: Chunk reference cache tests\n" );
+	
+	LEOInitStringVariantValue( &theValue, "alpha,beta,gamma", kLEOInvalidateReferences, &ctx );
+	LEOInitReferenceValue( &itemReference, &theValue, kLEOInvalidateReferences, kLEOChunkTypeItem, 1, 1, &ctx );
+	ASSERT( itemReference.reference.chunk->cachedString == NULL );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &itemReference, str, sizeof(str), &ctx ), "beta" );
+	ASSERT( itemReference.reference.chunk->cachedString == theValue.string.string );
+	ASSERT( itemReference.reference.chunk->cachedBytesStart == 6 && itemReference.reference.chunk->cachedBytesEnd == 10 );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &itemReference, str, sizeof(str), &ctx ), "beta" );
+	
+	// Writing through the reference moves the items after it:
+	LEOSetValueAsString( &itemReference, "b", &ctx );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theValue, str, sizeof(str), &ctx ), "alpha,b,gamma" );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &itemReference, str, sizeof(str), &ctx ), "b" );
+	LEOSetValueAsString( &itemReference, "bravo", &ctx );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theValue, str, sizeof(str), &ctx ), "alpha,bravo,gamma" );
+	
+	// Changing the value in place (keeps its buffer) must not use stale offsets:
+	char*	originalBuffer = theValue.string.string;
+	LEOSetValueAsString( &theValue, "a,bb,c", &ctx );
+	ASSERT( theValue.string.string == originalBuffer );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &itemReference, str, sizeof(str), &ctx ), "bb" );
+	ASSERT( LEOGetValueAsInteger( &itemReference, &ctx ) == 0 && ctx.keepRunning == false );	// "bb" isn't a number.
+	ctx.keepRunning = true;
+	ctx.errMsg[0] = 0;
+	
+	// Nor must a different item delimiter:
+	ctx.itemDelimiter = ';';
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &itemReference, str, sizeof(str), &ctx ), "" );
+	LEOSetValueAsString( &theValue, "1;22;3", &ctx );
+	ASSERT( LEOGetValueAsInteger( &itemReference, &ctx ) == 22 && ctx.keepRunning == true );
+	ctx.itemDelimiter = ',';
+	
+	// Nor a round trip through another type:
+	LEOSetValueAsNumber( &theValue, 5, &ctx );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &itemReference, str, sizeof(str), &ctx ), "" );
+	LEOSetValueAsString( &theValue, "x,true,z", &ctx );
+	ASSERT( LEOGetValueAsBoolean( &itemReference, &ctx ) == true && ctx.keepRunning == true );
+	LEOSetValueAsNumber( &itemReference, 1.5, &ctx );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theValue, str, sizeof(str), &ctx ), "x,1.5,z" );
+	ASSERT( LEOGetValueAsNumber( &itemReference, &ctx ) == 1.5 && ctx.keepRunning == true );
+	
+	LEOCleanUpValue( &itemReference, kLEOInvalidateReferences, &ctx );
 	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
-	LEOCleanUpValue( &valueReference, kLEOInvalidateReferences, &ctx );	
-	LEOCleanUpValue( &valueRefReference, kLEOInvalidateReferences, &ctx );	
 	LEOCleanUpContext( &ctx );
 }
 
@@ -1011,11 +1199,1495 @@ void	DoAllChunksTest()
 }
 
 
+void	DoContextPoolTest( void )
+{
+	LEOContextGroup*			group = LEOContextGroupCreate();
+	LEOContextPool*				pool = LEOContextPoolCreate( group, 1 );
+	LEOContextPoolStatistics	stats;
+	LEOScript*					theScript = LEOScriptCreateForOwner( 0, 0, NULL );
+	char						str[256];
+	
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: Context pool tests\n" );
+	
+	LEOContext*	ctx = LEOContextPoolAcquireContext( pool );
+	ASSERT( ctx != NULL );
+	ASSERT( ctx->group == group );
+	LEOPushStringValueOnStack( ctx, "Transient", 9 );
+	LEOPushIntegerOnStack( ctx, 42 );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( ctx, NULL, theScript, NULL, ctx->stack );
+	ctx->itemDelimiter = ';';
+	LEOContextStopWithError( ctx, "Stopped." );
+	LEOCallStackEntry*	callStackEntries = ctx->callStackEntries;
+	LEOContextPoolReturnContext( pool, ctx );
+	
+	LEOContext*	ctx2 = LEOContextPoolAcquireContext( pool );
+	ASSERT( ctx2 == ctx );
+	ASSERT( ctx2->stackEndPtr == ctx2->stack );
+	ASSERT( ctx2->numCallStackEntries == 0 );
+	ASSERT( ctx2->callStackEntries == callStackEntries );
+	ASSERT( ctx2->keepRunning == true );
+	ASSERT( ctx2->errMsg[0] == 0 );
+	ASSERT( ctx2->itemDelimiter == ',' );
+	ASSERT( theScript->referenceCount == 1 );
+	
+	memset( str, 'X', sizeof(str) );
+	LEOGetValueAsString( LEOPushStringValueOnStack( ctx2, "Reused", 6 ), str, sizeof(str), ctx2 );
+	ASSERT( strcmp(str,"Reused") == 0 );
+	
+	LEOContext*	ctx3 = LEOContextPoolAcquireContext( pool );
+	ASSERT( ctx3 != ctx2 );
+	LEOContextPoolReturnContext( pool, ctx3 );
+	LEOContextPoolReturnContext( pool, ctx2 );
+	
+	LEOContextPoolGetStatistics( pool, &stats );
+	ASSERT( stats.numContextsCreated == 2 );
+	ASSERT( stats.numContextsAcquired == 3 );
+	ASSERT( stats.numContextsReused == 2 );
+	ASSERT( stats.numContextsReturned == 3 );
+	ASSERT( stats.numContextsInUse == 0 );
+	ASSERT( stats.maxContextsInUse == 2 );
+	
+	LEOScriptRelease( theScript );
+	LEOContextPoolRelease( pool );
+}
+
+
+void	DoArenaTest( void )
+{
+	LEOContext			ctx;
+	union LEOValue		copiedValue;
+	char				str[256];
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	LEOContextSetArenaSize( &ctx, 96 );
+	
+	printf( "\nnote: Transient string arena tests\n" );
+	
+	LEOValuePtr	firstValue = LEOPushStringValueOnStack( &ctx, "Transient", 9 );
+	ASSERT( LEOArenaContainsPointer( ctx.arena, firstValue->string.string ) );
+	LEOSetValueRangeAsString( firstValue, kLEOChunkTypeCharacter, 0, 1, "Not t", &ctx );
+	ASSERT( LEOArenaContainsPointer( ctx.arena, firstValue->string.string ) );
+	memset( str, 'X', sizeof(str) );
+	LEOGetValueAsString( firstValue, str, sizeof(str), &ctx );
+	ASSERT( strcmp(str,"Not transient") == 0 );
+	
+	LEOInitCopy( firstValue, &copiedValue, kLEOInvalidateReferences, &ctx );
+	ASSERT( !LEOArenaContainsPointer( ctx.arena, copiedValue.string.string ) );
+	
+	LEOValuePtr	secondValue = LEOPushStringValueOnStack( &ctx, "This one is too long to fit into the arena.", 43 );
+	ASSERT( !LEOArenaContainsPointer( ctx.arena, secondValue->string.string ) );
+	ASSERT( ctx.arena->statistics.numFallbackAllocations == 1 );
+	
+	LEOCleanUpStackToPtr( &ctx, ctx.stack );
+	ASSERT( ctx.arena->numLiveAllocations == 0 );
+	ASSERT( ctx.arena->top == ctx.arena->start );
+	ASSERT( ctx.arena->statistics.numAllocations == 2 );
+	
+	memset( str, 'X', sizeof(str) );
+	LEOGetValueAsString( &copiedValue, str, sizeof(str), &ctx );
+	ASSERT( strcmp(str,"Not transient") == 0 );
+	LEOCleanUpValue( &copiedValue, kLEOInvalidateReferences, &ctx );
+	
+	// Arena buffers go back to their arena, whichever context they're cleaned up through:
+	LEOContext	otherCtx;
+	LEOInitContext( &otherCtx, ctx.group );
+	firstValue = LEOPushStringValueOnStack( &ctx, "Transient", 9 );
+	secondValue = LEOPushStringValueOnStack( &ctx, "Other", 5 );
+	ASSERT( ctx.arena->numLiveAllocations == 2 );
+	LEOCleanUpValue( secondValue, kLEOInvalidateReferences, &otherCtx );
+	LEOCleanUpValue( firstValue, kLEOInvalidateReferences, NULL );
+	ctx.stackEndPtr = ctx.stack;
+	ASSERT( ctx.arena->numLiveAllocations == 0 );
+	ASSERT( ctx.arena->top == ctx.arena->start );
+	LEOCleanUpContext( &otherCtx );
+	
+	LEOCleanUpContext( &ctx );
+}
+
+
+void	DoArrayEntryAllocatorTest( void )
+{
+	LEOContext				ctx;
+	union LEOValue			theValue;
+	struct LEOArrayEntry*	theArray = NULL;
+	struct LEOArrayEntry*	arrayCopy = NULL;
+	char					key[LEO_SLAB_MAX_BLOCK_SIZE +16];
+	char					str[256];
+	LEOContextGroup*		group = LEOContextGroupCreate();
+	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: Array entry allocator tests\n" );
+	
+	for( int x = 1; x <= 100; x++ )	// Keys in ascending order, so the tree degenerates into a list.
+	{
+		snprintf( key, sizeof(key), "%03d", x );
+		LEOInitIntegerValue( &theValue, x, kLEOInvalidateReferences, &ctx );
+		LEOAddArrayEntryToRoot( &theArray, key, &theValue, &ctx );
+		LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	}
+	memset( key, 'K', sizeof(key) -1 );	// Too long for any size class, must come from malloc.
+	key[sizeof(key) -1] = 0;
+	LEOInitStringValue( &theValue, "long", 4, kLEOInvalidateReferences, &ctx );
+	LEOAddArrayEntryToRoot( &theArray, key, &theValue, &ctx );
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	ASSERT( LEOGetArrayKeyCount( theArray ) == 101 );
+	ASSERT( ctx.group->arrayEntryAllocator->statistics.numBlocksInUse == 100 );
+	ASSERT( ctx.group->arrayEntryAllocator->statistics.numFallbackAllocations == 1 );
+	
+	arrayCopy = LEOCopyArray( theArray, &ctx );
+	ASSERT( LEOGetArrayKeyCount( arrayCopy ) == 101 );
+	ASSERT( ctx.group->arrayEntryAllocator->statistics.numBlocksInUse == 200 );
+	LEOCleanUpArray( theArray, &ctx );
+	ASSERT( ctx.group->arrayEntryAllocator->statistics.numBlocksInUse == 100 );
+	
+	ASSERT( LEOGetValueAsInteger( LEOGetArrayValueForKey( arrayCopy, "042" ), &ctx ) == 42 );
+	LEOGetValueAsString( LEOGetArrayValueForKey( arrayCopy, key ), str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "long" ) == 0 );
+	
+	LEODeleteArrayEntryFromRoot( &arrayCopy, "050", &ctx );
+	ASSERT( LEOGetArrayKeyCount( arrayCopy ) == 100 );
+	ASSERT( LEOGetArrayValueForKey( arrayCopy, "050" ) == NULL );
+	ASSERT( LEOGetValueAsInteger( LEOGetArrayValueForKey( arrayCopy, "051" ), &ctx ) == 51 );
+	
+	LEOCleanUpArray( arrayCopy, &ctx );
+	ASSERT( ctx.group->arrayEntryAllocator->statistics.numBlocksInUse == 0 );
+	ASSERT( LEOCopyArray( NULL, &ctx ) == NULL );
+	
+	// Entries go back to the allocator they came from, whichever context frees them:
+	LEOContext			otherCtx;
+	LEOContextGroup*	otherGroup = LEOContextGroupCreate();
+	LEOInitContext( &otherCtx, otherGroup );
+	LEOInitIntegerValue( &theValue, 1, kLEOInvalidateReferences, &ctx );
+	theArray = NULL;
+	LEOAddArrayEntryToRoot( &theArray, "1", &theValue, &ctx );
+	LEOAddArrayEntryToRoot( &theArray, "2", &theValue, &otherCtx );
+	LEOAddArrayEntryToRoot( &theArray, "3", &theValue, NULL );
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	ASSERT( ctx.group->arrayEntryAllocator->statistics.numBlocksInUse == 1 );
+	ASSERT( otherGroup->arrayEntryAllocator->statistics.numBlocksInUse == 1 );
+	LEOCleanUpArray( theArray, &otherCtx );
+	ASSERT( ctx.group->arrayEntryAllocator->statistics.numBlocksInUse == 0 );
+	ASSERT( otherGroup->arrayEntryAllocator->statistics.numBlocksInUse == 0 );
+	
+	// Arrays can outlive the group they were created in:
+	LEOInitStringValue( &theValue, "survivor", 8, kLEOInvalidateReferences, &otherCtx );
+	theArray = NULL;
+	LEOAddArrayEntryToRoot( &theArray, "1", &theValue, &otherCtx );
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &otherCtx );
+	LEOCleanUpContext( &otherCtx );
+	LEOContextGroupRelease( otherGroup );	// Last owner, group goes away now.
+	LEOGetValueAsString( LEOGetArrayValueForKey( theArray, "1" ), str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "survivor" ) == 0 );
+	LEOCleanUpArray( theArray, &ctx );
+	
+	LEOCleanUpContext( &ctx );
+}
+
+
+void	DoArrayCopyOnWriteTest( void )
+{
+	LEOContext				ctx;
+	union LEOValue			originalArray, arrayCopy, variantCopy, itemValue;
+	struct LEOArrayEntry*	theArray = NULL;
+	char					str[256];
+	LEOContextGroup*		group = LEOContextGroupCreate();
+	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: Array copy-on-write tests\n" );
+	
+	LEOInitStringValue( &itemValue, "one", 3, kLEOInvalidateReferences, &ctx );
+	LEOAddArrayEntryToRoot( &theArray, "1", &itemValue, &ctx );
+	LEOSetValueAsString( &itemValue, "two", &ctx );
+	LEOAddArrayEntryToRoot( &theArray, "2", &itemValue, &ctx );
+	LEOInitArrayValue( &originalArray, theArray, kLEOInvalidateReferences, &ctx );
+	
+	// Copies share the array until one of them is changed:
+	LEOInitCopy( &originalArray, &arrayCopy, kLEOInvalidateReferences, &ctx );
+	ASSERT( arrayCopy.array.array == originalArray.array.array );
+	LEOInitStringVariantValue( &variantCopy, "", kLEOInvalidateReferences, &ctx );
+	LEOPutValueIntoValue( &originalArray, &variantCopy, &ctx );
+	ASSERT( variantCopy.array.array == originalArray.array.array );
+	ASSERT( originalArray.array.array->referenceCount == 3 );
+	
+	LEOSetValueAsString( &itemValue, "changed", &ctx );
+	LEOSetValueForKey( &arrayCopy, "2", &itemValue, &ctx );
+	ASSERT( arrayCopy.array.array != originalArray.array.array );
+	ASSERT( originalArray.array.array->referenceCount == 2 );
+	LEOGetValueAsString( LEOGetValueForKey( &arrayCopy, "2", &ctx ), str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "changed" ) == 0 );
+	LEOGetValueAsString( LEOGetValueForKey( &originalArray, "2", &ctx ), str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "two" ) == 0 );
+	LEOGetValueAsString( LEOGetValueForKey( &variantCopy, "2", &ctx ), str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "two" ) == 0 );
+	
+	LEODeleteArrayEntryFromRoot( &originalArray.array.array, "1", &ctx );
+	ASSERT( LEOGetArrayKeyCount( originalArray.array.array ) == 1 );
+	ASSERT( LEOGetArrayKeyCount( variantCopy.array.array ) == 2 );
+	ASSERT( LEOGetArrayKeyCount( arrayCopy.array.array ) == 2 );
+	
+	// Releasing the last owner of the original array must leave the others intact:
+	LEOCleanUpValue( &variantCopy, kLEOInvalidateReferences, &ctx );
+	LEOGetValueAsString( LEOGetValueForKey( &arrayCopy, "1", &ctx ), str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "one" ) == 0 );
+	LEOCleanUpValue( &originalArray, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &arrayCopy, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &itemValue, kLEOInvalidateReferences, &ctx );
+	ASSERT( ctx.group->arrayEntryAllocator->statistics.numBlocksInUse == 0 );
+	
+	LEOCleanUpContext( &ctx );
+}
+
+
+void	DoStringCopyOnWriteTest( void )
+{
+	LEOContext				ctx;
+	union LEOValue			originalValue, valueCopy, variantCopy;
+	char					str[256];
+	LEOContextGroup*		group = LEOContextGroupCreate();
+	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: String copy-on-write tests\n" );
+	
+	LEOInitStringValue( &originalValue, "Shared text", 11, kLEOInvalidateReferences, &ctx );
+	LEOInitCopy( &originalValue, &valueCopy, kLEOInvalidateReferences, &ctx );
+	LEOInitStringVariantValueCopy( &originalValue, &variantCopy, kLEOInvalidateReferences, &ctx );
+	ASSERT( valueCopy.string.string == originalValue.string.string );
+	ASSERT( variantCopy.string.string == originalValue.string.string );
+	
+	LEOSetValueRangeAsString( &valueCopy, kLEOChunkTypeCharacter, 0, 6, "Changed", &ctx );
+	ASSERT( valueCopy.string.string != originalValue.string.string );
+	LEOGetValueAsString( &valueCopy, str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "Changed text" ) == 0 );
+	LEOGetValueAsString( &originalValue, str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "Shared text" ) == 0 );
+	
+	LEOSetValueAsString( &originalValue, "Replaced", &ctx );
+	LEOGetValueAsString( &variantCopy, str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "Shared text" ) == 0 );
+	
+	LEOCleanUpValue( &variantCopy, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &valueCopy, kLEOInvalidateReferences, &ctx );
+	LEOGetValueAsString( &originalValue, str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "Replaced" ) == 0 );
+	LEOCleanUpValue( &originalValue, kLEOInvalidateReferences, &ctx );
+	
+	// Transient strings must not be shared, their copies may outlive the stack:
+	LEOContextSetArenaSize( &ctx, LEO_DEFAULT_ARENA_SIZE );
+	LEOValuePtr	transientValue = LEOPushStringValueOnStack( &ctx, "Transient", 9 );
+	LEOInitCopy( transientValue, &valueCopy, kLEOInvalidateReferences, &ctx );
+	ASSERT( valueCopy.string.string != transientValue->string.string );
+	LEOCleanUpStackToPtr( &ctx, ctx.stack );
+	LEOGetValueAsString( &valueCopy, str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "Transient" ) == 0 );
+	LEOCleanUpValue( &valueCopy, kLEOInvalidateReferences, &ctx );
+	
+	LEOCleanUpContext( &ctx );
+}
+
+
+void	DoStringCapacityTest( void )
+{
+	LEOContext				ctx;
+	union LEOValue			theVariant, variantCopy;
+	char					str[256];
+	char					longStr[1024];
+	LEOContextGroup*		group = LEOContextGroupCreate();
+	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: String capacity reuse tests\n" );
+	
+	// Shorter strings are written into the buffer we already have:
+	LEOInitStringVariantValue( &theVariant, "Hello World", kLEOInvalidateReferences, &ctx );
+	char*	originalBuffer = theVariant.string.string;
+	size_t	numStringsAllocated = ctx.statistics.numStringsAllocated;
+	LEOSetValueAsString( &theVariant, "Goodbye", &ctx );
+	ASSERT( theVariant.string.string == originalBuffer );
+	ASSERT( ctx.statistics.numStringsAllocated == numStringsAllocated );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theVariant, NULL, 0, &ctx ), "Goodbye" );
+	LEOSetValueAsNumber( &theVariant, 42, &ctx );	// Turns into a number variant.
+	LEOSetValueAsString( &theVariant, "42.5", &ctx );
+	ASSERT( theVariant.base.isa == &kLeoValueTypeStringVariant );
+	ASSERT( LEOGetValueAsNumber( &theVariant, &ctx ) == 42.5 );
+	
+	// Assigning part of ourselves to ourselves:
+	LEOSetValueAsString( &theVariant, "One Two", &ctx );
+	originalBuffer = theVariant.string.string;
+	LEOSetValueAsString( &theVariant, theVariant.string.string +4, &ctx );
+	ASSERT( theVariant.string.string == originalBuffer );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theVariant, NULL, 0, &ctx ), "Two" );
+	
+	// Shared buffers are never overwritten:
+	LEOInitCopy( &theVariant, &variantCopy, kLEOInvalidateReferences, &ctx );
+	ASSERT( variantCopy.string.string == theVariant.string.string );
+	LEOSetValueAsString( &theVariant, "Six", &ctx );
+	ASSERT( variantCopy.string.string != theVariant.string.string );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &variantCopy, NULL, 0, &ctx ), "Two" );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theVariant, NULL, 0, &ctx ), "Six" );
+	LEOCleanUpValue( &variantCopy, kLEOInvalidateReferences, &ctx );
+	
+	// Longer strings need a new buffer, and much shorter ones give back the memory:
+	memset( longStr, 'x', sizeof(longStr) -1 );
+	longStr[sizeof(longStr) -1] = 0;
+	originalBuffer = theVariant.string.string;
+	LEOSetValueAsString( &theVariant, longStr, &ctx );
+	ASSERT( theVariant.string.string != originalBuffer );
+	originalBuffer = theVariant.string.string;
+	LEOSetValueAsString( &theVariant, longStr +700, &ctx );
+	ASSERT( theVariant.string.string == originalBuffer );
+	ASSERT( strlen( LEOGetValueAsString( &theVariant, NULL, 0, &ctx ) ) == 323 );
+	LEOSetValueAsString( &theVariant, "Short", &ctx );
+	ASSERT( theVariant.string.string != originalBuffer );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theVariant, NULL, 0, &ctx ), "Short" );
+	
+	// Numbers are written into the buffer of plain string values as well:
+	LEOSetStringValueAsInteger( &theVariant, 12345, &ctx );
+	ASSERT( theVariant.base.isa == &kLeoValueTypeStringVariant );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theVariant, NULL, 0, &ctx ), "12345" );
+	
+	// Through an array and back:
+	struct LEOArrayEntry*	theArray = NULL;
+	union LEOValue			arrayItem;
+	LEOInitIntegerValue( &arrayItem, 7, kLEOInvalidateReferences, &ctx );
+	LEOAddArrayEntryToRoot( &theArray, "seven", &arrayItem, &ctx );
+	LEOSetValueAsArray( &theVariant, theArray, &ctx );
+	LEOCleanUpArray( theArray, &ctx );
+	ASSERT( theVariant.base.isa == &kLeoValueTypeArrayVariant );
+	ASSERT( LEOGetKeyCount( &theVariant, &ctx ) == 1 );
+	LEOSetValueAsString( &theVariant, "Text again", &ctx );
+	ASSERT( theVariant.base.isa == &kLeoValueTypeStringVariant );
+	LEOGetValueAsString( &theVariant, str, sizeof(str), &ctx );
+	ASSERT( strcmp( str, "Text again" ) == 0 );
+	ASSERT( ctx.keepRunning == true );
+	
+	LEOCleanUpValue( &arrayItem, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &theVariant, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpContext( &ctx );
+}
+
+
+void	DoStringKeyedWriteTest( void )
+{
+	LEOContext				ctx;
+	union LEOValue			theString, theVariant, itemValue;
+	char					str[256];
+	char					key[32];
+	LEOContextGroup*		group = LEOContextGroupCreate();
+	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: Keyed writes to string tests\n" );
+	
+	// A string turns into an array the first time a key is set:
+	const char*	arrayStr = "one:1\ntwo:2";
+	LEOInitStringValue( &theString, arrayStr, strlen(arrayStr), kLEOInvalidateReferences, &ctx );
+	LEOInitStringValue( &itemValue, "3", 1, kLEOInvalidateReferences, &ctx );
+	LEOSetValueForKey( &theString, "three", &itemValue, &ctx );
+	ASSERT( ctx.keepRunning == true );
+	ASSERT( theString.base.isa == &kLeoValueTypeArrayVariant );
+	ASSERT( LEOGetKeyCount( &theString, &ctx ) == 3 );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetValueForKey( &theString, "one", &ctx ), str, sizeof(str), &ctx ), "1" );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetValueForKey( &theString, "three", &ctx ), str, sizeof(str), &ctx ), "3" );
+	LEOCleanUpValue( &theString, kLEOInvalidateReferences, &ctx );
+	
+	// More keys than used to fit in the text we printed the array to after each write:
+	LEOInitStringVariantValue( &theVariant, "", kLEOInvalidateReferences, &ctx );
+	for( int x = 0; x < 200; x++ )
+	{
+		snprintf( key, sizeof(key), "key%d", x );
+		LEOSetValueAsInteger( &itemValue, x, &ctx );
+		LEOSetValueForKey( &theVariant, key, &itemValue, &ctx );
+	}
+	ASSERT( theVariant.base.isa == &kLeoValueTypeArrayVariant );
+	ASSERT( LEOGetKeyCount( &theVariant, &ctx ) == 200 );
+	ASSERT( LEOGetValueAsInteger( LEOGetValueForKey( &theVariant, "key199", &ctx ), &ctx ) == 199 );
+	LEOCleanUpValue( &theVariant, kLEOInvalidateReferences, &ctx );
+	
+	// Same for a plain string, and reading it back as text gives us every key:
+	LEOInitStringValue( &theString, "first:0", 7, kLEOInvalidateReferences, &ctx );
+	for( int x = 0; x < 200; x++ )
+	{
+		snprintf( key, sizeof(key), "key%d", x );
+		LEOSetValueAsInteger( &itemValue, x, &ctx );
+		LEOSetValueForKey( &theString, key, &itemValue, &ctx );
+	}
+	ASSERT( ctx.keepRunning == true );
+	ASSERT( theString.base.isa == &kLeoValueTypeArrayVariant );
+	ASSERT( LEOGetKeyCount( &theString, &ctx ) == 201 );
+	const char*				readBackStr = LEOGetValueAsString( &theString, NULL, 0, &ctx );
+	ASSERT( readBackStr != NULL && strlen(readBackStr) > 1024 );
+	struct LEOArrayEntry*	readBackArray = LEOCreateArrayFromString( readBackStr, &ctx );
+	ASSERT( LEOGetArrayKeyCount( readBackArray ) == 201 );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetArrayValueForKey( readBackArray, "first" ), str, sizeof(str), &ctx ), "0" );
+	for( int x = 0; x < 200; x++ )
+	{
+		snprintf( key, sizeof(key), "key%d", x );
+		ASSERT( LEOGetValueAsInteger( LEOGetArrayValueForKey( readBackArray, key ), &ctx ) == x );
+	}
+	LEOCleanUpArray( readBackArray, &ctx );
+	LEOCleanUpValue( &theString, kLEOInvalidateReferences, &ctx );
+	
+	// Text that isn't an array is an error, and stays what it was:
+	LEOInitStringValue( &theString, "no array", 8, kLEOInvalidateReferences, &ctx );
+	LEOSetValueForKey( &theString, "key", &itemValue, &ctx );
+	ASSERT( ctx.keepRunning == false );
+	ASSERT( theString.base.isa == &kLeoValueTypeString );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theString, str, sizeof(str), &ctx ), "no array" );
+	ctx.keepRunning = true;
+	
+	LEOCleanUpValue( &theString, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &itemValue, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpContext( &ctx );
+}
+
+
+void	DoArrayPrintTest( void )
+{
+	LEOContext				ctx;
+	struct LEOArrayEntry*	theArray = NULL;
+	struct LEOArrayEntry*	nestedArray = NULL;
+	union LEOValue			itemValue, arrayValue;
+	char					str[256];
+	char					key[32];
+	size_t					len = 0;
+	LEOContextGroup*		group = LEOContextGroupCreate();
+	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: Array printing tests\n" );
+	
+	// Each entry is printed before its smaller and then its larger side, returns and "\xc2\xac" are escaped:
+	LEOInitStringValue( &itemValue, "2", 1, kLEOInvalidateReferences, &ctx );
+	LEOAddArrayEntryToRoot( &theArray, "b", &itemValue, &ctx );
+	LEOSetValueAsString( &itemValue, "one\ntwo", &ctx );
+	LEOAddArrayEntryToRoot( &theArray, "a", &itemValue, &ctx );
+	LEOSetValueAsString( &itemValue, "\xc2\xac \xc2\xa9", &ctx );
+	LEOAddArrayEntryToRoot( &theArray, "c", &itemValue, &ctx );
+	char*	arrayStr = LEOCopyArrayAsString( theArray, &len, &ctx );
+	ASSERT_STRING_MATCH( arrayStr, "b:2\nc:\xc2\xac\xc2\xac \xc2\xa9\na:one\xc2\xac\ntwo\n" );
+	ASSERT( len == strlen(arrayStr) );
+	LEOPrintArray( theArray, str, sizeof(str), &ctx );
+	ASSERT_STRING_MATCH( str, arrayStr );
+	free( arrayStr );
+	
+	// Printing into a buffer that is too small truncates:
+	LEOPrintArray( theArray, str, 6, &ctx );
+	ASSERT_STRING_MATCH( str, "b:2\nc" );
+	
+	// References to chunks have to be copied out of the referenced value:
+	union LEOValue	referencedValue, referenceValue;
+	struct LEOArrayEntry*	referenceArray = NULL;
+	LEOInitStringValue( &referencedValue, "one,two,three", 13, kLEOInvalidateReferences, &ctx );
+	LEOInitReferenceValue( &referenceValue, &referencedValue, kLEOInvalidateReferences, kLEOChunkTypeItem, 1, 1, &ctx );
+	LEOAddArrayEntryToRoot( &referenceArray, "r", &referenceValue, &ctx );
+	LEOPrintArray( referenceArray, str, sizeof(str), &ctx );
+	ASSERT_STRING_MATCH( str, "r:two\n" );
+	LEOCleanUpArray( referenceArray, &ctx );
+	LEOCleanUpValue( &referenceValue, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &referencedValue, kLEOInvalidateReferences, &ctx );
+	
+	// Nested arrays are printed without their last return:
+	LEOCleanUpValue( &itemValue, kLEOInvalidateReferences, &ctx );
+	LEOInitIntegerValue( &itemValue, 7, kLEOInvalidateReferences, &ctx );
+	LEOAddArrayEntryToRoot( &nestedArray, "x", &itemValue, &ctx );
+	LEOInitArrayValue( &arrayValue, nestedArray, kLEOInvalidateReferences, &ctx );
+	LEOAddArrayEntryToRoot( &theArray, "d", &arrayValue, &ctx );
+	LEOCleanUpValue( &arrayValue, kLEOInvalidateReferences, &ctx );
+	LEOInitArrayValue( &arrayValue, theArray, kLEOInvalidateReferences, &ctx );
+	LEOGetValueAsString( &arrayValue, str, sizeof(str), &ctx );
+	ASSERT_STRING_MATCH( str, "b:2\nc:\xc2\xac\xc2\xac \xc2\xa9\nd:x:7\na:one\xc2\xac\ntwo" );
+	LEOCleanUpValue( &arrayValue, kLEOInvalidateReferences, &ctx );
+	
+	// Large arrays aren't cut off when put into a string:
+	theArray = NULL;
+	for( int x = 0; x < 1000; x++ )
+	{
+		snprintf( key, sizeof(key), "key%d", x );
+		LEOInitIntegerValue( &itemValue, x, kLEOInvalidateReferences, &ctx );
+		LEOAddArrayEntryToRoot( &theArray, key, &itemValue, &ctx );
+	}
+	LEOInitStringVariantValue( &itemValue, "", kLEOInvalidateReferences, &ctx );
+	LEOSetValueAsArray( &itemValue, theArray, &ctx );	// Turns it into an array variant.
+	LEOInitStringValue( &arrayValue, "", 0, kLEOInvalidateReferences, &ctx );
+	LEOSetValueAsArray( &arrayValue, theArray, &ctx );	// Stays a string.
+	ASSERT( arrayValue.base.isa == &kLeoValueTypeString );
+	ASSERT( strstr( arrayValue.string.string, "key999:999\n" ) != NULL );
+	struct LEOArrayEntry*	parsedArray = LEOCreateArrayFromString( arrayValue.string.string, &ctx );
+	ASSERT( LEOGetArrayKeyCount( parsedArray ) == 1000 );
+	LEOCleanUpArray( parsedArray, &ctx );
+	
+	// Scripts that read an array as text get all of it, not just the first 1024 bytes:
+	arrayStr = LEOCopyArrayAsString( theArray, &len, &ctx );
+	len--;	// Without the trailing return.
+	LEOCleanUpArray( theArray, &ctx );
+	const char*	fullStr = LEOGetValueAsString( &itemValue, NULL, 0, &ctx );
+	ASSERT( fullStr != NULL && strlen(fullStr) == len && strncmp( fullStr, arrayStr, len ) == 0 );
+	ASSERT( LEOGetValueAsString( &itemValue, NULL, 0, &ctx ) == fullStr );	// Kept until the array changes.
+	free( arrayStr );
+	
+	LEOInstruction	setStringInstruction = { SET_STRING_INSTR, 0, 0 };
+	LEOInstruction	pushChunkInstruction = { PUSH_CHUNK_INSTR, BACK_OF_STACK, kLEOChunkTypeLine };
+	LEOInstruction	concatInstruction = { CONCATENATE_VALUES_INSTR, 0, ',' };
+	LEOInitInstructionArray();
+	ctx.stackBasePtr = ctx.stackEndPtr = ctx.stack;
+	LEOPushStringValueOnStack( &ctx, "", 0 );
+	LEOPushValueOnStack( &ctx, &itemValue );
+	ctx.currentInstruction = &setStringInstruction;
+	gInstructions[SET_STRING_INSTR]( &ctx );
+	ASSERT( ctx.stackEndPtr == ctx.stack +1 );
+	ASSERT( strlen( LEOGetValueAsString( ctx.stack +0, NULL, 0, &ctx ) ) == len );
+	
+	LEOPushValueOnStack( &ctx, &itemValue );
+	ctx.currentInstruction = &concatInstruction;
+	gInstructions[CONCATENATE_VALUES_INSTR]( &ctx );
+	ASSERT( ctx.stackEndPtr == ctx.stack +1 );
+	ASSERT( strlen( LEOGetValueAsString( ctx.stack +0, NULL, 0, &ctx ) ) == (len +1 +len) );
+	LEOCleanUpStackToPtr( &ctx, ctx.stack );
+	
+	LEOPushValueOnStack( &ctx, &itemValue );
+	LEOPushIntegerOnStack( &ctx, 1000 );
+	LEOPushIntegerOnStack( &ctx, 1000 );
+	ctx.currentInstruction = &pushChunkInstruction;
+	gInstructions[PUSH_CHUNK_INSTR]( &ctx );
+	ASSERT( ctx.stackEndPtr == ctx.stack +1 );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( ctx.stack +0, str, sizeof(str), &ctx ), strrchr( LEOGetValueAsString( &itemValue, NULL, 0, &ctx ), '\n' ) +1 );
+	LEOCleanUpStackToPtr( &ctx, ctx.stack );
+	
+	// Changing the array gives us new text:
+	LEOCleanUpValue( &arrayValue, kLEOInvalidateReferences, &ctx );
+	LEOInitIntegerValue( &arrayValue, 42, kLEOInvalidateReferences, &ctx );
+	LEOSetValueForKey( &itemValue, "new", &arrayValue, &ctx );
+	ASSERT( strstr( LEOGetValueAsString( &itemValue, NULL, 0, &ctx ), "new:42" ) != NULL );
+	ASSERT( strlen( LEOGetValueAsString( &itemValue, NULL, 0, &ctx ) ) == len +7 );
+	
+	ASSERT( ctx.keepRunning == true );
+	LEOCleanUpValue( &arrayValue, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &itemValue, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpContext( &ctx );
+}
+
+
+static size_t	LEOTestArrayDepth( struct LEOArrayEntry* inArray )
+{
+	if( !inArray )
+		return 0;
+	size_t	smallerDepth = LEOTestArrayDepth( inArray->smallerItem ),
+			largerDepth = LEOTestArrayDepth( inArray->largerItem );
+	return 1 +((smallerDepth > largerDepth) ? smallerDepth : largerDepth);
+}
+
+
+void	DoArrayParseTest( void )
+{
+	LEOContext				ctx;
+	struct LEOArrayEntry*	theArray = NULL;
+	char					str[256];
+	char*					longStr = NULL;
+	size_t					longStrLen = 0;
+	LEOContextGroup*		group = LEOContextGroupCreate();
+	
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: Array parsing tests\n" );
+	
+	theArray = LEOCreateArrayFromString( "b:2\na:1:one\nc:", &ctx );
+	ASSERT( LEOGetArrayKeyCount( theArray ) == 3 );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetArrayValueForKey( theArray, "a" ), str, sizeof(str), &ctx ), "1:one" );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetArrayValueForKey( theArray, "B" ), str, sizeof(str), &ctx ), "2" );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetArrayValueForKey( theArray, "c" ), str, sizeof(str), &ctx ), "" );
+	LEOCleanUpArray( theArray, &ctx );
+	
+	// The first spelling of a key and its last value win:
+	theArray = LEOCreateArrayFromString( "Key:1\nother:2\nKEY:3\n", &ctx );
+	ASSERT( LEOGetArrayKeyCount( theArray ) == 2 );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetArrayValueForKey( theArray, "key" ), str, sizeof(str), &ctx ), "3" );
+	LEOPrintArray( theArray, str, sizeof(str), &ctx );
+	ASSERT( strstr( str, "Key:3\n" ) != NULL );
+	LEOCleanUpArray( theArray, &ctx );
+	
+	// Escaped returns are part of the value, escaped escape characters aren't:
+	theArray = LEOCreateArrayFromString( "a:one\xc2\xac\ntwo\nb:x\xc2\xac\xc2\xac\nc:3", &ctx );
+	ASSERT( LEOGetArrayKeyCount( theArray ) == 3 );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetArrayValueForKey( theArray, "a" ), str, sizeof(str), &ctx ), "one\xc2\xac\ntwo" );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetArrayValueForKey( theArray, "b" ), str, sizeof(str), &ctx ), "x\xc2\xac\xc2\xac" );
+	LEOCleanUpArray( theArray, &ctx );
+	
+	// Not arrays:
+	ASSERT( LEOCreateArrayFromString( "", &ctx ) == NULL );
+	ASSERT( LEOCreateArrayFromString( "a:1\n:2", &ctx ) == NULL );
+	
+	// Sorted keys still give a balanced tree:
+	longStr = malloc( 1024 * 16 );
+	for( int x = 0; x < 1024; x++ )
+		longStrLen += snprintf( longStr +longStrLen, 16, "%04d:%d\n", x, x );
+	theArray = LEOCreateArrayFromString( longStr, &ctx );
+	ASSERT( LEOGetArrayKeyCount( theArray ) == 1024 );
+	ASSERT( LEOTestArrayDepth( theArray ) <= 11 );
+	ASSERT( LEOGetValueAsInteger( LEOGetArrayValueForKey( theArray, "0777" ), &ctx ) == 777 );
+	ASSERT( LEOGetValueAsInteger( LEOGetArrayValueForKey( theArray, "1023" ), &ctx ) == 1023 );
+	free( longStr );
+	
+	// What we print, we can parse again:
+	longStr = LEOCopyArrayAsString( theArray, &longStrLen, &ctx );
+	struct LEOArrayEntry*	parsedArray = LEOCreateArrayFromString( longStr, &ctx );
+	ASSERT( LEOGetArrayKeyCount( parsedArray ) == 1024 );
+	ASSERT( LEOGetValueAsInteger( LEOGetArrayValueForKey( parsedArray, "0000" ), &ctx ) == 0 );
+	free( longStr );
+	LEOCleanUpArray( parsedArray, &ctx );
+	LEOCleanUpArray( theArray, &ctx );
+	
+	ASSERT( ctx.keepRunning == true );
+	LEOCleanUpContext( &ctx );
+}
+
+
+
+void	DoDenseArrayTest( void )
+{
+	LEOContext				ctx;
+	union LEOValue			arrayValue;
+	union LEOValue			copiedValue;
+	union LEOValue			itemValue;
+	char					str[256];
+	char*					longStr = NULL;
+	size_t					longStrLen = 0;
+	LEOInstruction			splitInstruction = { ASSIGN_CHUNK_ARRAY_INSTR, BACK_OF_STACK, kLEOChunkTypeLine };
+	LEOContextGroup*		group = LEOContextGroupCreate();
+	
+	LEOInitInstructionArray();
+	LEOInitContext( &ctx, group );
+	LEOContextGroupRelease( group );
+	
+	printf( "\nnote: Dense array tests\n" );
+	
+	struct LEODenseArray*	denseArray = LEOCreateDenseArray( 3, &ctx );
+	LEOInitStringValue( denseArray->items +0, "one", 3, kLEOInvalidateReferences, &ctx );
+	LEOInitIntegerValue( denseArray->items +1, 2, kLEOInvalidateReferences, &ctx );
+	LEOInitStringValue( denseArray->items +2, "th\nree", 6, kLEOInvalidateReferences, &ctx );
+	LEOInitDenseArrayValue( &arrayValue, denseArray, kLEOInvalidateReferences, &ctx );
+	
+	ASSERT( LEOGetKeyCount( &arrayValue, &ctx ) == 3 );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetValueForKey( &arrayValue, "1", &ctx ), str, sizeof(str), &ctx ), "one" );
+	ASSERT( LEOGetValueAsInteger( LEOGetValueForKey( &arrayValue, "2", &ctx ), &ctx ) == 2 );
+	ASSERT( LEOGetValueForKey( &arrayValue, "0", &ctx ) == NULL );
+	ASSERT( LEOGetValueForKey( &arrayValue, "01", &ctx ) == NULL );
+	ASSERT( LEOGetValueForKey( &arrayValue, "4", &ctx ) == NULL );
+	ASSERT( LEOGetValueForKey( &arrayValue, "99999999999999999999999", &ctx ) == NULL );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &arrayValue, str, sizeof(str), &ctx ), "1:one\n2:2\n3:th\xc2\xac\nree" );
+	
+	// Writing an existing key keeps it dense, and doesn't change copies:
+	LEOInitCopy( &arrayValue, &copiedValue, kLEOInvalidateReferences, &ctx );
+	LEOInitStringValue( &itemValue, "uno", 3, kLEOInvalidateReferences, &ctx );
+	LEOSetValueForKey( &arrayValue, "1", &itemValue, &ctx );
+	LEOCleanUpValue( &itemValue, kLEOInvalidateReferences, &ctx );
+	ASSERT( arrayValue.base.isa == &kLeoValueTypeDenseArray );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetValueForKey( &arrayValue, "1", &ctx ), str, sizeof(str), &ctx ), "uno" );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetValueForKey( &copiedValue, "1", &ctx ), str, sizeof(str), &ctx ), "one" );
+	
+	// Any other key turns it into a regular array:
+	LEOInitStringValue( &itemValue, "extra", 5, kLEOInvalidateReferences, &ctx );
+	LEOSetValueForKey( &arrayValue, "name", &itemValue, &ctx );
+	LEOSetValueForKey( &copiedValue, "4", &itemValue, &ctx );
+	LEOCleanUpValue( &itemValue, kLEOInvalidateReferences, &ctx );
+	ASSERT( arrayValue.base.isa == &kLeoValueTypeArray );
+	ASSERT( LEOGetKeyCount( &arrayValue, &ctx ) == 4 );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetValueForKey( &arrayValue, "name", &ctx ), str, sizeof(str), &ctx ), "extra" );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetValueForKey( &arrayValue, "3", &ctx ), str, sizeof(str), &ctx ), "th\nree" );
+	ASSERT( copiedValue.base.isa == &kLeoValueTypeArray );
+	ASSERT( LEOGetKeyCount( &copiedValue, &ctx ) == 4 );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( LEOGetValueForKey( &copiedValue, "1", &ctx ), str, sizeof(str), &ctx ), "one" );
+	LEOCleanUpValue( &copiedValue, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &arrayValue, kLEOInvalidateReferences, &ctx );
+	
+	// Splitting text into lines isn't limited to the first 1024 bytes:
+	longStr = malloc( 2000 * 8 );
+	for( int x = 1; x <= 2000; x++ )
+		longStrLen += snprintf( longStr +longStrLen, 8, (x == 1) ? "%d" : "\n%d", x );
+	ctx.stackEndPtr = ctx.stack;
+	LEOPushStringValueOnStack( &ctx, longStr, longStrLen );
+	free( longStr );
+	ctx.currentInstruction = &splitInstruction;
+	gInstructions[ASSIGN_CHUNK_ARRAY_INSTR]( &ctx );
+	ASSERT( ctx.stackEndPtr == ctx.stack +1 );
+	ASSERT( ctx.stack[0].base.isa == &kLeoValueTypeDenseArray );
+	ASSERT( LEOGetKeyCount( ctx.stack +0, &ctx ) == 2000 );
+	ASSERT( LEOGetValueAsInteger( LEOGetValueForKey( ctx.stack +0, "1234", &ctx ), &ctx ) == 1234 );
+	ASSERT( LEOGetValueAsInteger( LEOGetValueForKey( ctx.stack +0, "2000", &ctx ), &ctx ) == 2000 );
+	
+	// Reading it back as text isn't limited to 1024 bytes either:
+	size_t		textLen = 0;
+	for( int x = 1; x <= 2000; x++ )
+		textLen += snprintf( str, sizeof(str), (x == 1) ? "%d:%d" : "\n%d:%d", x, x );
+	const char*	textStr = LEOGetValueAsString( ctx.stack +0, NULL, 0, &ctx );
+	ASSERT( textStr != NULL && strlen(textStr) == textLen );
+	ASSERT( strcmp( textStr +textLen -19, "1999:1999\n2000:2000" ) == 0 );
+	LEOGetValueAsString( ctx.stack +0, str, 8, &ctx );	// Callers' buffers still get as much as fits.
+	ASSERT_STRING_MATCH( str, "1:1\n2:2" );
+	ASSERT( LEOGetValueAsString( ctx.stack +0, NULL, 0, &ctx ) == textStr );	// Kept until the items change.
+	
+	LEOInstruction	setStringInstruction = { SET_STRING_INSTR, 0, 0 };
+	ctx.stackBasePtr = ctx.stack +1;
+	LEOPushStringValueOnStack( &ctx, "", 0 );
+	LEOPushValueOnStack( &ctx, ctx.stack +0 );
+	ctx.currentInstruction = &setStringInstruction;
+	gInstructions[SET_STRING_INSTR]( &ctx );
+	ASSERT( ctx.stackEndPtr == ctx.stack +2 );
+	ASSERT( strlen( LEOGetValueAsString( ctx.stack +1, NULL, 0, &ctx ) ) == textLen );
+	LEOCleanUpStackToPtr( &ctx, ctx.stack +1 );
+	
+	// Changing an item gives us new text:
+	LEOInitStringValue( &itemValue, "last", 4, kLEOInvalidateReferences, &ctx );
+	LEOSetValueForKey( ctx.stack +0, "2000", &itemValue, &ctx );
+	LEOCleanUpValue( &itemValue, kLEOInvalidateReferences, &ctx );
+	ASSERT( ctx.stack[0].base.isa == &kLeoValueTypeDenseArray );
+	textStr = LEOGetValueAsString( ctx.stack +0, NULL, 0, &ctx );
+	ASSERT( strcmp( textStr +strlen(textStr) -19, "1999:1999\n2000:last" ) == 0 );
+	LEOInitStringValue( &itemValue, "2000", 4, kLEOInvalidateReferences, &ctx );
+	LEOSetValueForKey( ctx.stack +0, "2000", &itemValue, &ctx );
+	LEOCleanUpValue( &itemValue, kLEOInvalidateReferences, &ctx );
+	
+	// Putting it into another value gives that a regular array with the same keys:
+	LEOInitArrayValue( &copiedValue, NULL, kLEOInvalidateReferences, &ctx );
+	LEOPutValueIntoValue( ctx.stack +0, &copiedValue, &ctx );
+	ASSERT( LEOGetKeyCount( &copiedValue, &ctx ) == 2000 );
+	ASSERT( LEOGetValueAsInteger( LEOGetValueForKey( &copiedValue, "999", &ctx ), &ctx ) == 999 );
+	LEOCleanUpValue( &copiedValue, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpStackToPtr( &ctx, ctx.stack );
+	
+	ASSERT( ctx.keepRunning == true );
+	LEOCleanUpContext( &ctx );
+}
+
+void	DoProfilerTest( void )
+{
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	LEOScript*			theScript = LEOScriptCreateForOwner( 0, 0, NULL );
+	LEOHandlerID		mainID = LEOContextGroupHandlerIDForHandlerName( group, "main" );
+	LEOHandlerID		helperID = LEOContextGroupHandlerIDForHandlerName( group, "helper" );
+	LEOContext			ctx;
+	
+	printf( "\nnote: Profiler tests\n" );
+	
+	LEOInitInstructionArray();
+	LEOScriptAddCommandHandlerWithID( theScript, mainID );
+	LEOScriptAddCommandHandlerWithID( theScript, helperID );
+	LEOHandler*	mainHandler = LEOScriptFindCommandHandlerWithID( theScript, mainID );
+	LEOHandlerAddInstruction( mainHandler, CALL_HANDLER_INSTR, 0, helperID );
+	LEOHandlerAddInstruction( mainHandler, CALL_HANDLER_INSTR, 0, helperID );
+	LEOHandlerAddInstruction( mainHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	LEOHandler*	helperHandler = LEOScriptFindCommandHandlerWithID( theScript, helperID );
+	LEOHandlerAddInstruction( helperHandler, NO_OP_INSTR, 0, 0 );
+	LEOHandlerAddInstruction( helperHandler, NO_OP_INSTR, 0, 0 );
+	LEOHandlerAddInstruction( helperHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	
+	for( LEOProfilerMode currMode = kLEOProfilerModeExact; currMode <= kLEOProfilerModeSampling; currMode++ )
+	{
+		LEOProfiler*	profiler = LEOProfilerCreate( currMode, 1 );
+		
+		LEOInitContext( &ctx, group );
+		LEOProfilerAttachToContext( profiler, &ctx );
+		ASSERT( ctx.profiler == profiler );
+		LEOContextPushHandlerScriptReturnAddressAndBasePtr( &ctx, mainHandler, theScript, NULL, NULL );
+		LEORunInContext( mainHandler->instructions, &ctx );
+		LEOProfilerDetachFromContext( profiler );
+		ASSERT( ctx.profiler == NULL );
+		ASSERT( ctx.errMsg[0] == 0 );
+		LEOCleanUpContext( &ctx );
+		
+		ASSERT( profiler->instructionEntries[CALL_HANDLER_INSTR].numExecutions == 2 );
+		ASSERT( profiler->instructionEntries[NO_OP_INSTR].numExecutions == 4 );
+		ASSERT( profiler->instructionEntries[RETURN_FROM_HANDLER_INSTR].numExecutions == 3 );
+		ASSERT( profiler->numHandlerEntries == 2 );
+		ASSERT( strcmp( profiler->handlerEntries[0].handlerName, "main" ) == 0 );
+		ASSERT( profiler->handlerEntries[0].numCalls == 1 );
+		ASSERT( profiler->handlerEntries[0].numActivations == 0 );
+		ASSERT( strcmp( profiler->handlerEntries[1].handlerName, "helper" ) == 0 );
+		ASSERT( profiler->handlerEntries[1].numCalls == 2 );
+		ASSERT( profiler->handlerEntries[0].inclusiveTime >= profiler->handlerEntries[1].inclusiveTime );
+		ASSERT( profiler->handlerEntries[0].inclusiveTime >= profiler->handlerEntries[0].exclusiveTime );
+		
+		FILE*	reportFile = tmpfile();
+		LEOProfilerPrintReport( profiler, reportFile );
+		ASSERT( ftell( reportFile ) > 0 );
+		fclose( reportFile );
+		
+		LEOProfilerFree( profiler );
+	}
+	
+	// Contexts given back to a pool are detached from their profiler:
+	LEOContextPool*	pool = LEOContextPoolCreate( group, 1 );
+	LEOProfiler*	firstProfiler = LEOProfilerCreate( kLEOProfilerModeExact, 1 );
+	LEOProfiler*	secondProfiler = LEOProfilerCreate( kLEOProfilerModeExact, 1 );
+	LEOContext*		pooledCtx = LEOContextPoolAcquireContext( pool );
+	LEOProfilerAttachToContext( firstProfiler, pooledCtx );
+	LEOContextPoolReturnContext( pool, pooledCtx );
+	ASSERT( pooledCtx->profiler == NULL );
+	ASSERT( firstProfiler->context == NULL );
+	pooledCtx = LEOContextPoolAcquireContext( pool );
+	LEOProfilerAttachToContext( secondProfiler, pooledCtx );
+	LEOProfilerDetachFromContext( firstProfiler );	// Mustn't touch the context anymore.
+	ASSERT( pooledCtx->profiler == secondProfiler );
+	ASSERT( pooledCtx->preInstructionProc == LEOProfilerPreInstructionProc );
+	LEOProfilerFree( firstProfiler );
+	LEOContextPoolReturnContext( pool, pooledCtx );
+	ASSERT( secondProfiler->context == NULL );
+	LEOProfilerFree( secondProfiler );
+	LEOContextPoolRelease( pool );
+	
+	LEOScriptRelease( theScript );
+	LEOContextGroupRelease( group );
+}
+
+
+void	DoLineProfilerTest( void )
+{
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	LEOScript*			theScript = LEOScriptCreateForOwner( 0, 0, NULL );
+	LEOHandlerID		mainID = LEOContextGroupHandlerIDForHandlerName( group, "main" );
+	LEOProfiler*		profiler = LEOProfilerCreate( kLEOProfilerModeExact, 0 );
+	LEOContext			ctx;
+	char				str[1024] = { 0 };
+	
+	printf( "\nnote: Line profiler tests\n" );
+	
+	LEOInitInstructionArray();
+	LEOHandler*	mainHandler = LEOScriptAddCommandHandlerWithID( theScript, mainID );
+	LEOHandlerAddInstruction( mainHandler, LINE_MARKER_INSTR, 0, 1 );
+	LEOHandlerAddInstruction( mainHandler, NO_OP_INSTR, 0, 0 );
+	LEOHandlerAddInstruction( mainHandler, LINE_MARKER_INSTR, 0, 2 );
+	LEOHandlerAddInstruction( mainHandler, NO_OP_INSTR, 0, 0 );
+	LEOHandlerAddInstruction( mainHandler, NO_OP_INSTR, 0, 0 );
+	LEOHandlerAddInstruction( mainHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	
+	profiler->collectLines = true;
+	LEOInitContext( &ctx, group );
+	LEOProfilerAttachToContext( profiler, &ctx );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( &ctx, mainHandler, theScript, NULL, NULL );
+	LEORunInContext( mainHandler->instructions, &ctx );
+	LEOProfilerDetachFromContext( profiler );
+	LEOCleanUpContext( &ctx );
+	
+	ASSERT( profiler->numHandlerEntries == 1 );
+	LEOProfilerHandlerEntry*	handlerEntry = profiler->handlerEntries +0;
+	ASSERT( handlerEntry->numLineEntries > 2 );
+	ASSERT( handlerEntry->lineEntries[0].numInstructions == 0 );
+	ASSERT( handlerEntry->lineEntries[1].numHits == 1 );
+	ASSERT( handlerEntry->lineEntries[1].numInstructions == 2 );
+	ASSERT( handlerEntry->lineEntries[2].numHits == 1 );
+	ASSERT( handlerEntry->lineEntries[2].numInstructions == 4 );
+	ASSERT( handlerEntry->lineEntries[1].time +handlerEntry->lineEntries[2].time == handlerEntry->exclusiveTime );
+	
+	FILE*	callgrindFile = tmpfile();
+	LEOProfilerWriteCallgrindFile( profiler, callgrindFile );
+	rewind( callgrindFile );
+	fread( str, 1, sizeof(str) -1, callgrindFile );
+	fclose( callgrindFile );
+	ASSERT( strstr( str, "events: " ) != NULL );
+	ASSERT( strstr( str, "\nfn=main\n1 " ) != NULL );
+	
+	LEOProfilerFree( profiler );
+	LEOScriptRelease( theScript );
+	LEOContextGroupRelease( group );
+}
+
+
+void	DoTraceTest( void )
+{
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	LEOScript*			theScript = LEOScriptCreateForOwner( 0, 0, NULL );
+	LEOHandlerID		mainID = LEOContextGroupHandlerIDForHandlerName( group, "main" );
+	LEOHandlerID		helperID = LEOContextGroupHandlerIDForHandlerName( group, "helper" );
+	LEOContext			ctx;
+	FILE*				traceFile = tmpfile();
+	LEOTraceSession*	session = LEOTraceSessionCreate( traceFile );
+	
+	printf( "\nnote: Trace tests\n" );
+	
+	LEOInitInstructionArray();
+	LEOHandler*	mainHandler = LEOScriptAddCommandHandlerWithID( theScript, mainID );
+	LEOHandlerAddInstruction( mainHandler, CALL_HANDLER_INSTR, 0, helperID );
+	LEOHandlerAddInstruction( mainHandler, CALL_HANDLER_INSTR, 0, helperID );
+	LEOHandlerAddInstruction( mainHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	LEOHandler*	helperHandler = LEOScriptAddCommandHandlerWithID( theScript, helperID );
+	LEOHandlerAddInstruction( helperHandler, NO_OP_INSTR, 0, 0 );
+	LEOHandlerAddInstruction( helperHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	mainHandler = LEOScriptFindCommandHandlerWithID( theScript, mainID );	// Adding helper may have moved it.
+	
+	LEOInitContext( &ctx, group );
+	LEOTraceSessionAttachToContext( session, &ctx );
+	ASSERT( ctx.traceBuffer != NULL );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( &ctx, mainHandler, theScript, NULL, NULL );
+	LEORunInContext( mainHandler->instructions, &ctx );
+	ASSERT( ctx.errMsg[0] == 0 );
+	ASSERT( ctx.traceBuffer->currentChunk->numEvents == 6 );
+	
+	// Enough calls to fill a chunk, so it gets handed to the session while running:
+	for( size_t x = 0; x < LEO_TRACE_CHUNK_NUM_EVENTS; x++ )
+	{
+		LEOContextPushHandlerScriptReturnAddressAndBasePtr( &ctx, helperHandler, theScript, NULL, NULL );
+		LEOContextPopHandlerScriptReturnAddressAndBasePtr( &ctx );
+	}
+	ASSERT( session->fullChunks != NULL );
+	LEOTraceSessionFlush( session );
+	ASSERT( session->fullChunks == NULL );
+	ASSERT( session->numEventsWritten == 2 * LEO_TRACE_CHUNK_NUM_EVENTS );
+	
+	LEOCleanUpContext( &ctx );	// Detaches and hands over the rest.
+	ASSERT( ctx.traceBuffer == NULL );
+	
+	// Contexts given back to a pool stop recording into our session:
+	LEOContextPool*	pool = LEOContextPoolCreate( group, 1 );
+	LEOContext*		pooledCtx = LEOContextPoolAcquireContext( pool );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( pooledCtx, mainHandler, theScript, NULL, NULL );	// Called before we attached, so no events for it.
+	LEOTraceSessionAttachToContext( session, pooledCtx );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( pooledCtx, helperHandler, theScript, NULL, NULL );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( pooledCtx, helperHandler, theScript, NULL, NULL );
+	LEOContextPopHandlerScriptReturnAddressAndBasePtr( pooledCtx );
+	LEOContextPoolReturnContext( pool, pooledCtx );	// Aborted while helper was still running, gets an end event now.
+	ASSERT( pooledCtx->traceBuffer == NULL );
+	LEOTraceSessionFree( session );
+	pooledCtx = LEOContextPoolAcquireContext( pool );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( pooledCtx, helperHandler, theScript, NULL, NULL );
+	LEOContextPopHandlerScriptReturnAddressAndBasePtr( pooledCtx );
+	LEOContextPoolReturnContext( pool, pooledCtx );
+	LEOContextPoolRelease( pool );
+	
+	size_t	fileSize = ftell( traceFile );
+	char*	str = calloc( fileSize +1, 1 );
+	rewind( traceFile );
+	fread( str, 1, fileSize, traceFile );
+	fclose( traceFile );
+	
+	ASSERT( str[0] == '[' );
+	ASSERT( strcmp( str +fileSize -3, "\n]\n" ) == 0 );
+	ASSERT( strstr( str, "{\"name\":\"main\",\"cat\":\"handler\",\"ph\":\"B\"" ) != NULL );
+	ASSERT( strstr( str, "{\"name\":\"helper\",\"cat\":\"handler\",\"ph\":\"E\"" ) != NULL );
+	size_t	numEvents = 0;
+	for( char* currEvent = strstr( str, "\"ph\":" ); currEvent != NULL; currEvent = strstr( currEvent +1, "\"ph\":" ) )
+		numEvents++;
+	ASSERT( numEvents == 2 * LEO_TRACE_CHUNK_NUM_EVENTS +10 );
+	size_t	numBeginEvents = 0;
+	for( char* currEvent = strstr( str, "\"ph\":\"B\"" ); currEvent != NULL; currEvent = strstr( currEvent +1, "\"ph\":\"B\"" ) )
+		numBeginEvents++;
+	ASSERT( numBeginEvents * 2 == numEvents );
+	free( str );
+	
+	LEOScriptRelease( theScript );
+	LEOContextGroupRelease( group );
+}
+
+
+void	DoStatisticsTest( void )
+{
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	LEOScript*			theScript = LEOScriptCreateForOwner( 0, 0, NULL );
+	LEOHandlerID		mainID = LEOContextGroupHandlerIDForHandlerName( group, "main" );
+	LEOHandlerID		helperID = LEOContextGroupHandlerIDForHandlerName( group, "helper" );
+	LEOContext			ctx;
+	LEOContext			otherCtx;
+	LEOStatistics		stats;
+	union LEOValue		theValue;
+	union LEOValue		theReference;
+	struct LEOArrayEntry*	theArray = NULL;
+	
+	printf( "\nnote: Statistics tests\n" );
+	
+	LEOInitInstructionArray();
+	LEOHandler*	mainHandler = LEOScriptAddCommandHandlerWithID( theScript, mainID );
+	LEOHandlerAddInstruction( mainHandler, CALL_HANDLER_INSTR, 0, helperID );
+	LEOHandlerAddInstruction( mainHandler, CALL_HANDLER_INSTR, 0, helperID );
+	LEOHandlerAddInstruction( mainHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	LEOHandler*	helperHandler = LEOScriptAddCommandHandlerWithID( theScript, helperID );
+	LEOHandlerAddInstruction( helperHandler, NO_OP_INSTR, 0, 0 );
+	LEOHandlerAddInstruction( helperHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	mainHandler = LEOScriptFindCommandHandlerWithID( theScript, mainID );	// Adding helper may have moved it.
+	
+	LEOInitContext( &ctx, group );
+	LEOInitContext( &otherCtx, group );
+	ASSERT( group->numContexts == 2 );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( &ctx, mainHandler, theScript, NULL, NULL );
+	LEORunInContext( mainHandler->instructions, &ctx );
+	ASSERT( ctx.errMsg[0] == 0 );
+	
+	LEOInitStringValue( &theValue, "Hello World", 11, kLEOInvalidateReferences, &ctx );
+	LEOInitReferenceValue( &theReference, &theValue, kLEOInvalidateReferences, kLEOChunkTypeINVALID, 0, 0, &ctx );
+	LEOAddArrayEntryToRoot( &theArray, "one", &theValue, &ctx );
+	LEOAddArrayEntryToRoot( &theArray, "two", &theValue, &ctx );
+	LEOCleanUpArray( theArray, &ctx );
+	LEOCleanUpValue( &theReference, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	
+	LEOContextGetStatistics( &ctx, &stats );
+	ASSERT( stats.numInstructions == 7 );
+	ASSERT( stats.numHandlerCalls == 3 );
+	ASSERT( stats.maxCallDepth == 2 );
+	ASSERT( stats.numStringBytesAllocated == 12 );
+	ASSERT( stats.numStringBytesFreed == 12 );
+	ASSERT( stats.numArrayEntriesAllocated == 2 );
+	ASSERT( stats.numArrayEntriesFreed == 2 );
+	ASSERT( stats.numErrors == 0 );
+	
+	LEOContextStopWithError( &otherCtx, "Runaway script." );
+	LEOContextGroupGetStatistics( group, &stats );
+	ASSERT( stats.numInstructions == 7 );
+	ASSERT( stats.numErrors == 1 );
+	ASSERT( stats.numReferencesCreated == 1 );
+	ASSERT( stats.numReferencesRecycled == 1 );
+	
+	// Counters of contexts that have been reset or are gone are kept by the group:
+	LEOResetContext( &ctx );
+	LEOContextGetStatistics( &ctx, &stats );
+	ASSERT( stats.numInstructions == 0 );
+	LEOCleanUpContext( &otherCtx );
+	ASSERT( group->numContexts == 1 );
+	LEOContextGroupGetStatistics( group, &stats );
+	ASSERT( stats.numInstructions == 7 );
+	ASSERT( stats.maxCallDepth == 2 );
+	ASSERT( stats.numErrors == 1 );
+	
+	LEOCleanUpContext( &ctx );
+	ASSERT( group->numContexts == 0 );
+	LEOScriptRelease( theScript );
+	LEOContextGroupRelease( group );
+}
+
+
+void	DoBytecodeFileTest( void )
+{
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	LEOScript*			theScript = LEOScriptCreateForOwner( 0, 0, NULL );
+	LEOHandlerID		mainID = LEOContextGroupHandlerIDForHandlerName( group, "main" );
+	LEOHandlerID		helperID = LEOContextGroupHandlerIDForHandlerName( group, "helper" );
+	LEOContext			ctx;
+	char				errMsg[256] = { 0 };
+	char				str[256] = { 0 };
+	
+	printf( "\nnote: Bytecode file tests\n" );
+	
+	LEOInitInstructionArray();
+	LEOScriptAddString( theScript, "unused" );
+	size_t		stringIndex = LEOScriptAddString( theScript, "Hello World" );
+	LEOHandler*	mainHandler = LEOScriptAddCommandHandlerWithID( theScript, mainID );
+	LEOHandlerAddInstruction( mainHandler, CALL_HANDLER_INSTR, kLEOCallHandler_IsFunctionFlag, helperID );
+	LEOHandlerAddInstruction( mainHandler, PUSH_STR_FROM_TABLE_INSTR, BACK_OF_STACK, (uint32_t) stringIndex );
+	LEOHandlerAddInstruction( mainHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	LEOHandlerAddVariableNameMapping( mainHandler, "var_greeting", "greeting", 0 );
+	LEOHandler*	helperHandler = LEOScriptAddFunctionHandlerWithID( theScript, helperID );
+	LEOHandlerAddInstruction( helperHandler, NO_OP_INSTR, 0, 0 );
+	LEOHandlerAddInstruction( helperHandler, RETURN_FROM_HANDLER_INSTR, 0, 0 );
+	
+	FILE*	theFile = tmpfile();
+	ASSERT( LEOBytecodeFileWriteScript( theScript, group, theFile ) );
+	LEOScriptRelease( theScript );
+	LEOContextGroupRelease( group );
+	
+	// Read it into a group where the handlers get different IDs:
+	group = LEOContextGroupCreate();
+	LEOContextGroupHandlerIDForHandlerName( group, "somethingElse" );
+	mainID = LEOContextGroupHandlerIDForHandlerName( group, "main" );
+	helperID = LEOContextGroupHandlerIDForHandlerName( group, "helper" );
+	rewind( theFile );
+	theScript = LEOBytecodeFileReadScript( theFile, group, errMsg, sizeof(errMsg) );
+	ASSERT( theScript != NULL );
+	ASSERT( errMsg[0] == 0 );
+	ASSERT( theScript->numStrings == 2 );
+	ASSERT( strcmp( theScript->strings[stringIndex], "Hello World" ) == 0 );
+	ASSERT( theScript->numCommands == 1 && theScript->numFunctions == 1 );
+	mainHandler = LEOScriptFindCommandHandlerWithID( theScript, mainID );
+	ASSERT( mainHandler != NULL );
+	ASSERT( LEOScriptFindFunctionHandlerWithID( theScript, helperID ) != NULL );
+	ASSERT( mainHandler->numInstructions == 3 );
+	ASSERT( mainHandler->instructions[0].instructionID == CALL_HANDLER_INSTR );
+	ASSERT( mainHandler->instructions[0].param1 == kLEOCallHandler_IsFunctionFlag );
+	ASSERT( mainHandler->instructions[0].param2 == helperID );
+	ASSERT( mainHandler->instructions[1].param1 == BACK_OF_STACK );
+	ASSERT( LEOHandlerFindVariableByName( mainHandler, "greeting" ) == 0 );
+	
+	LEOInitContext( &ctx, group );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( &ctx, mainHandler, theScript, NULL, NULL );
+	LEORunInContext( mainHandler->instructions, &ctx );
+	ASSERT( ctx.errMsg[0] == 0 );
+	ASSERT( ctx.stackEndPtr == ctx.stack +1 );
+	LEOGetValueAsString( ctx.stack, str, sizeof(str), &ctx );
+	ASSERT_STRING_MATCH( str, "Hello World" );
+	LEOCleanUpContext( &ctx );
+	LEOScriptRelease( theScript );
+	
+	// Damaged files must be rejected, not crash:
+	rewind( theFile );
+	fputc( 'X', theFile );
+	rewind( theFile );
+	ASSERT( LEOBytecodeFileReadScript( theFile, group, errMsg, sizeof(errMsg) ) == NULL );
+	ASSERT( errMsg[0] != 0 );
+	fclose( theFile );
+	
+	theFile = tmpfile();
+	fwrite( "LEOB\1\0\0\0\1\0\0\0\5\0\0\0Bogus", 1, 21, theFile );
+	rewind( theFile );
+	errMsg[0] = 0;
+	ASSERT( LEOBytecodeFileReadScript( theFile, group, errMsg, sizeof(errMsg) ) == NULL );
+	ASSERT_STRING_MATCH( errMsg, "Unknown instruction \"Bogus\" in bytecode file." );
+	fclose( theFile );
+	
+	LEOContextGroupRelease( group );
+}
+
+
+static const char*	sAssemblerTestScript =
+	"string \"unused\"\n"
+	"string \"Tab\\there \\\"quoted\\\"\\n\"\n"
+	"\n"
+	"command main\n"
+	"\tPushInteger( BACK, 3 );\n"
+	"L1:\n"
+	"\tAddInteger( 0, -1 );\n"
+	"\tCallHandler( 0, $helper );\n"
+	"\tJumpRelativeIfGreaterThanZero( 0, @L1 );\n"
+	"\tPushStringFromTable( BACK, \"Tab\\there \\\"quoted\\\"\\n\" );\n"
+	"\tPushNumber( BACK, 1.5 );\n"
+	"\tReturnFromHandler( 0, 0 );\n"
+	"\tvariable \"counter\" \"var_counter\" 0\n"
+	"end\n"
+	"\n"
+	"command helper\n"
+	"\tNoOp( 0, 0 );\n"
+	"\tReturnFromHandler( 0, 0 );\n"
+	"end\n"
+	"\n"
+	"function unused\n"
+	"\tReturnFromHandler( 0, 0 );\n"
+	"end\n";
+
+
+static void	DoAssemblerErrorTest( LEOContextGroup* inGroup, const char* inText, const char* inExpectedError )
+{
+	char	errMsg[256] = { 0 };
+	ASSERT( LEOAssembleScript( inText, strlen(inText), inGroup, errMsg, sizeof(errMsg) ) == NULL );
+	ASSERT_STRING_MATCH( errMsg, inExpectedError );
+}
+
+
+void	DoAssemblerTest( void )
+{
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	LEOContext			ctx;
+	char				errMsg[256] = { 0 };
+	char				str[256] = { 0 };
+	
+	printf( "\nnote: Assembler tests\n" );
+	
+	LEOInitInstructionArray();
+	LEOScript*	theScript = LEOAssembleScript( sAssemblerTestScript, strlen(sAssemblerTestScript), group, errMsg, sizeof(errMsg) );
+	ASSERT( theScript != NULL );
+	ASSERT_STRING_MATCH( errMsg, "" );
+	ASSERT( theScript->numStrings == 2 );
+	ASSERT_STRING_MATCH( theScript->strings[1], "Tab\there \"quoted\"\n" );
+	ASSERT( theScript->numCommands == 2 && theScript->numFunctions == 1 );
+	LEOHandler*	mainHandler = LEOScriptFindCommandHandlerWithID( theScript, LEOContextGroupHandlerIDForHandlerName( group, "main" ) );
+	ASSERT( mainHandler->numInstructions == 7 );
+	ASSERT( mainHandler->instructions[0].param1 == BACK_OF_STACK );
+	ASSERT( mainHandler->instructions[1].param2 == (uint32_t) -1 );
+	ASSERT( mainHandler->instructions[2].param2 == LEOContextGroupHandlerIDForHandlerName( group, "helper" ) );
+	ASSERT( LEOCastUInt32ToInt32( mainHandler->instructions[3].param2 ) == -2 );
+	ASSERT( mainHandler->instructions[4].param2 == 1 );
+	ASSERT( LEOCastUInt32ToLEONumber( mainHandler->instructions[5].param2 ) == 1.5 );
+	ASSERT( LEOHandlerFindVariableByName( mainHandler, "counter" ) == 0 );
+	
+	// Disassembling must give us back exactly what we assembled:
+	FILE*	theFile = tmpfile();
+	ASSERT( LEODisassembleScript( theScript, group, theFile ) );
+	size_t	textLength = ftell( theFile );
+	char*	theText = calloc( textLength +1, 1 );
+	rewind( theFile );
+	ASSERT( fread( theText, 1, textLength, theFile ) == textLength );
+	fclose( theFile );
+	ASSERT_STRING_MATCH( theText, sAssemblerTestScript );
+	free( theText );
+	
+	LEOInitContext( &ctx, group );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( &ctx, mainHandler, theScript, NULL, NULL );
+	LEORunInContext( mainHandler->instructions, &ctx );
+	ASSERT( ctx.errMsg[0] == 0 );
+	ASSERT( ctx.stackEndPtr == ctx.stack +3 );
+	ASSERT( LEOGetValueAsInteger( ctx.stack, &ctx ) == 0 );
+	LEOGetValueAsString( ctx.stack +1, str, sizeof(str), &ctx );
+	ASSERT_STRING_MATCH( str, "Tab\there \"quoted\"\n" );
+	ASSERT( LEOGetValueAsNumber( ctx.stack +2, &ctx ) == 1.5 );
+	LEOCleanUpContext( &ctx );
+	LEOScriptRelease( theScript );
+	
+	DoAssemblerErrorTest( group, "command main\n\tNoSuchThing( 0, 0 );\nend\n", "line 2: Unknown instruction \"NoSuchThing\"." );
+	DoAssemblerErrorTest( group, "command main\n\tJumpRelative( 0, @nowhere );\nend\n", "line 2: Unknown label \"nowhere\"." );
+	DoAssemblerErrorTest( group, "command main\n\tNoOp( 0, 0 );\n", "line 3: Missing \"end\" at end of file." );
+	DoAssemblerErrorTest( group, "\tNoOp( 0, 0 );\n", "line 1: Instruction outside a handler." );
+	DoAssemblerErrorTest( group, "command main\n\tNoOp( 70000, 0 );\nend\n", "line 2: Parameter 70000 out of range." );
+	DoAssemblerErrorTest( group, "string \"open\n", "line 1: Missing closing quote." );
+	
+	LEOContextGroupRelease( group );
+}
+
+
+static const char*	sVerifierTestScript =
+	"command main\n"
+	"\tPushInteger( BACK, 0 );\n"
+	"\tPushInteger( BACK, 5 );\n"
+	"loop:\n"
+	"\tPushInteger( BACK, 0 );\n"
+	"\tPushInteger( BACK, 7 );\n"
+	"\tPushInteger( BACK, 1 );\n"
+	"\tCallHandler( 1, $twice );\n"
+	"\tPopValue( BACK, 0 );\n"
+	"\tPopValue( BACK, 0 );\n"
+	"\tPushReference( 0, 0 );\n"
+	"\tAddCommand( 0, 0 );\n"
+	"\tAddInteger( 1, -1 );\n"
+	"\tJumpRelativeIfGreaterThanZero( 1, @loop );\n"
+	"\tPopValue( BACK, 0 );\n"
+	"\tSetReturnValue( 0, 0 );\n"
+	"\tReturnFromHandler( 0, 0 );\n"
+	"end\n"
+	"\n"
+	"function twice\n"
+	"\tParameter( BACK, 1 );\n"
+	"\tPushInteger( BACK, 2 );\n"
+	"\tMultiply( 0, 0 );\n"
+	"\tSetReturnValue( 0, 0 );\n"
+	"\tReturnFromHandler( 0, 0 );\n"
+	"end\n";
+
+
+static void	DoVerifierErrorTest( LEOContextGroup* inGroup, const char* inText, const char* inExpectedError )
+{
+	char		errMsg[256] = { 0 };
+	LEOScript*	theScript = LEOAssembleScript( inText, strlen(inText), inGroup, errMsg, sizeof(errMsg) );
+	ASSERT( theScript != NULL );
+	ASSERT( !LEOVerifyHandler( theScript->commands, errMsg, sizeof(errMsg) ) );
+	ASSERT( !theScript->commands[0].verified );
+	ASSERT_STRING_MATCH( errMsg, inExpectedError );
+	LEOScriptRelease( theScript );
+}
+
+
+static size_t	sVerifierTestNumPreInstructionCalls = 0;
+
+
+static void	LEOVerifierTestCountingPreInstructionProc( LEOContext* inContext )
+{
+	sVerifierTestNumPreInstructionCalls++;
+}
+
+
+static LEONumber	LEOVerifierTestRunMain( LEOContext* inContext, LEOScript* inScript, LEOHandler* inHandler, bool* outRanUnchecked )
+{
+	LEOPushEmptyValueOnStack( inContext );	// Return value.
+	LEOPushIntegerOnStack( inContext, 0 );	// Parameter count.
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( inContext, inHandler, inScript, NULL, NULL );
+	LEOPrepareContextForRunning( inHandler->instructions, inContext );
+	*outRanUnchecked = inContext->runUnchecked;
+	LEORunInContext( inHandler->instructions, inContext );
+	
+	return LEOGetValueAsNumber( inContext->stack, inContext );
+}
+
+
+void	DoVerifierTest( void )
+{
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	LEOContext			ctx;
+	char				errMsg[256] = { 0 };
+	bool				ranUnchecked = true;
+	
+	printf( "\nnote: Verifier tests\n" );
+	
+	LEOInitInstructionArray();
+	LEOScript*	theScript = LEOAssembleScript( sVerifierTestScript, strlen(sVerifierTestScript), group, errMsg, sizeof(errMsg) );
+	ASSERT( theScript != NULL );
+	LEOHandler*	mainHandler = theScript->commands;
+	
+	// Run it once with all checks, so we can compare:
+	LEOInitContext( &ctx, group );
+	ASSERT( LEOVerifierTestRunMain( &ctx, theScript, mainHandler, &ranUnchecked ) == 70 );
+	ASSERT( !ranUnchecked );
+	ASSERT( ctx.errMsg[0] == 0 );
+	size_t	numCheckedInstructions = ctx.statistics.numInstructions;
+	size_t	checkedStackDepth = ctx.statistics.maxStackDepth;
+	LEOCleanUpContext( &ctx );
+	
+	ASSERT( LEOVerifyScript( theScript, errMsg, sizeof(errMsg) ) );
+	ASSERT( mainHandler->verified && theScript->functions[0].verified );
+	ASSERT( mainHandler->maxStackDepth == 5 );
+	ASSERT( theScript->functions[0].maxStackDepth == 2 );
+	
+	LEOInitContext( &ctx, group );
+	ASSERT( LEOVerifierTestRunMain( &ctx, theScript, mainHandler, &ranUnchecked ) == 70 );
+	ASSERT( ranUnchecked );
+	ASSERT( ctx.errMsg[0] == 0 );
+	ASSERT( ctx.statistics.numInstructions == numCheckedInstructions );
+	ASSERT( ctx.statistics.maxStackDepth == checkedStackDepth );
+	LEOCleanUpContext( &ctx );
+	
+	// An installed preInstructionProc must see every instruction:
+	LEOInitContext( &ctx, group );
+	ctx.preInstructionProc = LEOVerifierTestCountingPreInstructionProc;
+	sVerifierTestNumPreInstructionCalls = 0;
+	ASSERT( LEOVerifierTestRunMain( &ctx, theScript, mainHandler, &ranUnchecked ) == 70 );
+	ASSERT( sVerifierTestNumPreInstructionCalls == numCheckedInstructions );
+	LEOCleanUpContext( &ctx );
+	
+	// Stack frames that don't fit on the stack anymore mustn't skip checks:
+	LEOInitContext( &ctx, group );
+	for( size_t x = 0; x < LEO_STACK_SIZE -4; x++ )
+		LEOPushIntegerOnStack( &ctx, 0 );
+	LEOContextPushHandlerScriptReturnAddressAndBasePtr( &ctx, mainHandler, theScript, NULL, NULL );
+	ASSERT( !ctx.runUnchecked );
+	LEOPrepareContextForRunning( mainHandler->instructions, &ctx );
+	ASSERT( !ctx.runUnchecked );
+	LEOCleanUpContext( &ctx );
+	
+	// Changing a handler means it has to be verified again:
+	LEOHandlerAddInstruction( mainHandler, NO_OP_INSTR, 0, 0 );
+	ASSERT( !mainHandler->verified );
+	LEOScriptRelease( theScript );
+	
+	DoVerifierErrorTest( group, "command main\n\tPopValue( BACK, 0 );\n\tReturnFromHandler( 0, 0 );\nend\n", "instruction 0 (PopValue): Needs 1 operands, but the stack only holds 0 values." );
+	DoVerifierErrorTest( group, "command main\n\tJumpRelative( 0, 5 );\nend\n", "instruction 0 (JumpRelative): Jumps to instruction 5 outside the handler." );
+	DoVerifierErrorTest( group, "command main\nloop:\n\tPushInteger( BACK, 1 );\n\tJumpRelative( 0, @loop );\nend\n", "instruction 0 (PushInteger): Reached with 0 and with 1 values on the stack." );
+	DoVerifierErrorTest( group, "command main\n\tPushInteger( BACK, 1 );\n\tAddInteger( 1, 1 );\n\tReturnFromHandler( 0, 0 );\nend\n", "instruction 1 (AddInteger): Address 1 is outside the handler's 1 local values." );
+	DoVerifierErrorTest( group, "command main\n\tPushInteger( BACK, 1 );\n\tPushInteger( BACK, 1 );\n\tPopValue( 1, 0 );\n\tReturnFromHandler( 0, 0 );\nend\n", "instruction 2 (PopValue): Address 1 is outside the handler's 1 local values." );
+	DoVerifierErrorTest( group, "command main\n\tPushInteger( BACK, 1 );\n\tReturnFromHandler( 0, 0 );\nend\n", "instruction 1 (ReturnFromHandler): Returns without popping 1 values off the stack." );
+	DoVerifierErrorTest( group, "command main\n\tNoOp( 0, 0 );\nend\n", "instruction 0 (NoOp): Runs past the end of the handler." );
+	DoVerifierErrorTest( group, "command main\n\tPushChunkReference( BACK, 0 );\nend\n", "instruction 0 (PushChunkReference): Needs an address, not BACK_OF_STACK." );
+	DoVerifierErrorTest( group, "command main\n\tInvalid( 0, 0 );\nend\n", "instruction 0 (Invalid): Invalid instruction." );
+	
+	LEOScript*	theScript2 = LEOScriptCreateForOwner( 0, 0, NULL );
+	LEOHandler*	theHandler = LEOScriptAddCommandHandlerWithID( theScript2, LEOContextGroupHandlerIDForHandlerName( group, "main" ) );
+	ASSERT( !LEOVerifyHandler( theHandler, errMsg, sizeof(errMsg) ) );
+	ASSERT_STRING_MATCH( errMsg, "Handler has no instructions." );
+	LEOHandlerAddInstruction( theHandler, 9999, 0, 0 );
+	ASSERT( !LEOVerifyHandler( theHandler, errMsg, sizeof(errMsg) ) );
+	ASSERT_STRING_MATCH( errMsg, "instruction 0 (?): Unknown instruction 9999." );
+	LEOScriptRelease( theScript2 );
+	
+	LEOContextGroupRelease( group );
+}
+
+
+static const double		sNumberConversionTestNumbers[] =
+{
+	0.0, -0.0, 1.0, -1.0, 0.5, 1.5, 2.5, 0.1, 0.2 +0.1, 1.0 / 3.0, -2.0 / 3.0, 10.0, 100000.0, 999999.0, 999999.5,
+	1000000.0, 1234567.0, 123456.5, 0.0001, 0.00001, 0.000123456789, 1e-5, 1e16, 1e22, 1e27, 1e28, 1e100, -1e-100,
+	1e-17, 5e-324, 1.7976931348623157e308, 3.14159265358979, 12345.678, -98765.4321
+};
+
+
+static const char*		sNumberConversionTestStrings[] =
+{
+	"", "0", "-0", "+7", "00012", "1.5", "-1.5", ".5", "5.", ".", "-", "+", "1e", "1e+", "1E-3", "1e3x", " 5", "5 ",
+	"0x1F", "inf", "-nan", "1e400", "1e-400", "12345678901234567890", "123456789012345678901234", "0.30000000000000004",
+	"9223372036854775807", "-9223372036854775808", "9223372036854775808", "999999999999999999", "1000000000000000000"
+};
+
+
+void	DoNumberConversionTest( void )
+{
+	char		str[LEO_NUMBER_STRING_MAX_LENGTH] = { 0 };
+	char		libcStr[LEO_NUMBER_STRING_MAX_LENGTH] = { 0 };
+	size_t		numMismatches = 0;
+	
+	printf( "\nnote: Number conversion tests\n" );
+	
+	// We must give the same results as libc, which we used before:
+	for( size_t x = 0; x < sizeof(sNumberConversionTestNumbers) / sizeof(double); x++ )
+	{
+		ASSERT( LEOFormatNumber( sNumberConversionTestNumbers[x], str ) == strlen(str) );
+		snprintf( libcStr, sizeof(libcStr), "%g", sNumberConversionTestNumbers[x] );
+		ASSERT_STRING_MATCH( str, libcStr );
+	}
+	
+	for( size_t x = 0; x < sizeof(sNumberConversionTestStrings) / sizeof(const char*); x++ )
+	{
+		const char*	currStr = sNumberConversionTestStrings[x];
+		char*		libcEnd = NULL;
+		LEONumber	num = 0;
+		LEOInteger	integer = 0;
+		const char*	numEnd = LEOParseNumber( currStr, &num );
+		LEONumber	libcNum = strtod( currStr, &libcEnd );
+		ASSERT( numEnd == libcEnd && (num == libcNum || (isnan(num) && isnan(libcNum))) && signbit(num) == signbit(libcNum) );
+		const char*	integerEnd = LEOParseInteger( currStr, &integer );
+		LEOInteger	libcInteger = strtoll( currStr, &libcEnd, 10 );
+		ASSERT( integerEnd == libcEnd && integer == libcInteger );
+	}
+	
+	// Lots of "random" numbers, some of them with fractions that make
+	//	rounding them to 6 digits interesting:
+	unsigned long long	seed = 88172645463325252ULL;
+	for( size_t x = 0; x < 100000; x++ )
+	{
+		seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+		LEONumber	theNumber = (x % 2) ? ((LEONumber)(long long)(seed % 200000000) / 1000.0) : ((LEONumber)(seed % 10000000) * pow( 10, (int)(seed % 41) -20 ));
+		LEOInteger	theInteger = (x % 3) ? (LEOInteger)seed : (LEOInteger)(seed % 100000) -50000;
+		
+		LEOFormatNumber( theNumber, str );
+		snprintf( libcStr, sizeof(libcStr), "%g", theNumber );
+		if( strcmp( str, libcStr ) != 0 )
+			numMismatches++;
+		
+		LEONumber	parsedNumber = 0;
+		snprintf( libcStr, sizeof(libcStr), (x % 2) ? "%.17g" : "%.4f", theNumber );
+		LEOParseNumber( libcStr, &parsedNumber );
+		if( parsedNumber != strtod( libcStr, NULL ) )
+			numMismatches++;
+		
+		LEOFormatInteger( theInteger, str );
+		snprintf( libcStr, sizeof(libcStr), "%lld", theInteger );
+		if( strcmp( str, libcStr ) != 0 )
+			numMismatches++;
+	}
+	ASSERT( numMismatches == 0 );
+	
+	// Values use these for their conversions now:
+	LEOContextGroup*	group = LEOContextGroupCreate();
+	LEOContext			ctx;
+	union LEOValue		theValue;
+	LEOInitContext( &ctx, group );
+	LEOInitStringValue( &theValue, "x", 1, kLEOInvalidateReferences, &ctx );
+	LEOSetValueAsNumber( &theValue, 0.1 +0.2, &ctx );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theValue, NULL, 0, &ctx ), "0.3" );
+	ASSERT( LEOGetValueAsNumber( &theValue, &ctx ) == 0.3 );
+	LEOSetValueAsInteger( &theValue, -1234567890123LL, &ctx );
+	ASSERT_STRING_MATCH( LEOGetValueAsString( &theValue, NULL, 0, &ctx ), "-1234567890123" );
+	ASSERT( LEOGetValueAsInteger( &theValue, &ctx ) == -1234567890123LL );
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	LEOInitNumberValue( &theValue, 1234567.0, kLEOInvalidateReferences, &ctx );
+	LEOGetValueAsString( &theValue, str, 6, &ctx );
+	ASSERT_STRING_MATCH( str, "1.23" );	// Truncated like before.
+	LEOCleanUpValue( &theValue, kLEOInvalidateReferences, &ctx );
+	LEOCleanUpContext( &ctx );
+	LEOContextGroupRelease( group );
+}
+
+
 int main( int argc, char** argv )
 {
 	DoChunkTests();
 	DoChunkValueTests();
 	DoReferenceTest();
+	DoValueTypeTagTest();
+	DoStackUnwindingTest();
 	DoWordsTestSingleSpaced();
 	DoWordsTestDoubleSpaced();
 	DoWordsTestLeadingWhiteSingleSpaced();
@@ -1025,6 +2697,32 @@ int main( int argc, char** argv )
 	DoScriptTest();
 	
 	DoChunkReferenceTests();
+	DoChunkReferenceCacheTest();
+	
+	DoContextPoolTest();
+	DoArenaTest();
+	DoArrayEntryAllocatorTest();
+	DoArrayCopyOnWriteTest();
+	DoStringCopyOnWriteTest();
+	DoStringCapacityTest();
+	DoStringKeyedWriteTest();
+	DoArrayPrintTest();
+	DoArrayParseTest();
+	DoDenseArrayTest();
+	DoProfilerTest();
+	DoLineProfilerTest();
+	DoTraceTest();
+	DoStatisticsTest();
+	DoBytecodeFileTest();
+	DoAssemblerTest();
+	DoVerifierTest();
+	DoNumberConversionTest();
+	
+	if( gNumFailedTests > 0 )
+	{
+		printf( "\nerror: %zu tests failed.\n", gNumFailedTests );
+		return EXIT_FAILURE;
+	}
 	
 	return EXIT_SUCCESS;
 }
\ No newline at end of file